@@ -0,0 +1,119 @@
+// ===================================================
+// Filter pipeline benchmark: float path vs fixed-point chain
+// ===================================================
+// Host:   g++ -O2 -std=gnu++17 -DHOST_BENCH -Iinclude bench/filter_bench.cpp -o filter_bench && ./filter_bench
+// Target: pio run -e bench_filters -t upload -t monitor
+//
+// Feeds the same synthetic pH trace (slow drift + noise + rare spikes)
+// through three paths and reports ns/sample plus the worst deviation from
+// the float reference:
+//   float_block : what readPhSensor() used to do (block average, float cal)
+//   float_chain : the same median/EMA/cal chain in float, per sample
+//   fixed_chain : SensorFilter from filter_pipeline.h, per sample
+
+#include "filter_pipeline.h"
+
+#ifdef HOST_BENCH
+#include <stdio.h>
+#include <chrono>
+static uint32_t micros() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+#define BENCH_PRINTF printf
+#else
+#include <Arduino.h>
+#define BENCH_PRINTF Serial.printf
+#endif
+
+static const int SAMPLES = 4096;
+static const int BLOCK = 30;  // old readPhSensor() sample count
+static const int ROUNDS = 20;
+
+static const float VREF = 3.3f, FULL_SCALE = 4095.0f;
+static const float SLOPE = -9.76f, INTERCEPT = 19.45f;
+
+static uint16_t trace[SAMPLES];
+static volatile int32_t sink;  // keeps the optimiser honest
+
+static void makeTrace() {
+  uint32_t lcg = 12345;
+  for (int i = 0; i < SAMPLES; i++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    int noise = (int)((lcg >> 24) & 0x0F) - 8;        // +-8 counts
+    int base = 1450 + (i * 40) / SAMPLES;             // slow drift
+    int spike = (lcg & 0x3FF) == 0 ? 900 : 0;         // ~0.1% spikes
+    trace[i] = (uint16_t)(base + noise + spike);
+  }
+}
+
+static float floatBlock() {
+  float ph = 0;
+  for (int i = 0; i + BLOCK <= SAMPLES; i += BLOCK) {
+    long sum = 0;
+    for (int j = 0; j < BLOCK; j++) sum += trace[i + j];
+    float v = sum / (float)BLOCK * VREF / FULL_SCALE;
+    ph = SLOPE * v + INTERCEPT;
+    if (ph < 4.5f) ph = 4.5f;
+    if (ph > 9.5f) ph = 9.5f;
+  }
+  return ph;
+}
+
+static void floatChain(float* out) {
+  float h[3] = {0, 0, 0}, ema = 0;
+  for (int i = 0; i < SAMPLES; i++) {
+    h[i % 3] = trace[i];
+    float a = h[0], b = h[1], c = h[2];
+    float med = i < 2 ? trace[i]
+              : (a > b ? (b > c ? b : (a > c ? c : a)) : (a > c ? a : (b > c ? c : b)));
+    ema = i == 0 ? med : ema + (med - ema) * 0.5f;
+    out[i] = (SLOPE * (ema * VREF / FULL_SCALE) + INTERCEPT) * 1000.0f;
+  }
+}
+
+typedef FilterPipeline<MedianFilter<3>, EmaFilter<1>, LinearCal> BenchFilter;
+
+static void fixedChain(int32_t* out) {
+  BenchFilter f({}, {}, LinearCal::fromFloat(SLOPE * VREF / FULL_SCALE * 1000.0f, INTERCEPT * 1000.0f));
+  for (int i = 0; i < SAMPLES; i++) out[i] = f.process(trace[i]);
+}
+
+void runFilterBench() {
+  static float   refOut[SAMPLES];
+  static int32_t fixOut[SAMPLES];
+  makeTrace();
+
+  uint32_t t0 = micros();
+  for (int r = 0; r < ROUNDS; r++) sink = (int32_t)(floatBlock() * 1000.0f);
+  uint32_t tBlock = micros() - t0;
+
+  t0 = micros();
+  for (int r = 0; r < ROUNDS; r++) { floatChain(refOut); sink = (int32_t)refOut[SAMPLES - 1]; }
+  uint32_t tFloat = micros() - t0;
+
+  t0 = micros();
+  for (int r = 0; r < ROUNDS; r++) { fixedChain(fixOut); sink = fixOut[SAMPLES - 1]; }
+  uint32_t tFixed = micros() - t0;
+
+  float worst = 0;
+  for (int i = 0; i < SAMPLES; i++) {
+    float d = fixOut[i] - refOut[i];
+    if (d < 0) d = -d;
+    if (d > worst) worst = d;
+  }
+
+  const float n = (float)SAMPLES * ROUNDS;
+  BENCH_PRINTF("[BENCH] filter samples=%d rounds=%d\n", SAMPLES, ROUNDS);
+  BENCH_PRINTF("[BENCH] float_block : %8.1f ns/sample\n", tBlock * 1000.0f / n);
+  BENCH_PRINTF("[BENCH] float_chain : %8.1f ns/sample\n", tFloat * 1000.0f / n);
+  BENCH_PRINTF("[BENCH] fixed_chain : %8.1f ns/sample | max |fixed-float| = %.1f milli-pH\n",
+               tFixed * 1000.0f / n, worst);
+}
+
+#ifdef HOST_BENCH
+int main() {
+  runFilterBench();
+  return 0;
+}
+#endif
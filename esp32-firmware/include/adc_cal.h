@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+#include <driver/adc.h>
+
+// ===================================================
+// Calibrated ADC1 access
+// ===================================================
+// Reads the per-chip eFuse characterisation (two-point or Vref) at boot and
+// precomputes a raw -> millivolt table for each attenuation in use, so a
+// calibrated conversion is one table load. Samples go straight through
+// adc1_get_raw() instead of analogRead()'s per-call pin/attenuation checks.
+// Only ADC1 pins are supported (ADC2 is unusable while WiFi is on).
+
+// Configure a pin's channel + attenuation; builds (and logs) the LUT on
+// first use of each attenuation
+bool adcAttach(uint8_t pin, adc_atten_t atten = ADC_ATTEN_DB_11);
+
+int      adcReadRaw(uint8_t pin);
+uint16_t adcRawToMilliVolts(uint8_t pin, int raw);
+uint16_t adcReadMilliVolts(uint8_t pin);
+// Inverse of adcRawToMilliVolts, interpolated: the raw count that reads as mv
+float    adcMilliVoltsToRaw(uint8_t pin, float mv);
@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include "sensors.h"
+
+// ===================================================
+// Windowed aggregation of sensor readings
+// ===================================================
+// Every reading lands in the current window as running min / max / sum /
+// count per field. In the "window" uplink mode only the closed windows are
+// uploaded: the means go out as an ordinary frame (so the server's dosing
+// logic reads them like a sample) with min, max and count alongside.
+
+enum AggField { AGG_TEMPERATURE, AGG_HUMIDITY, AGG_DISTANCE, AGG_PPM, AGG_PH, AGG_FIELD_COUNT };
+
+struct FieldWindow {
+  float min = 0, max = 0, sum = 0;
+  uint32_t count = 0;
+
+  void add(float v) {
+    if (v != v) return;  // NaN: failed read
+    if (!count || v < min) min = v;
+    if (!count || v > max) max = v;
+    sum += v;
+    count++;
+  }
+  float mean() const { return count ? sum / count : 0; }
+};
+
+struct WindowSummary {
+  uint32_t startMs = 0, endMs = 0;
+  FieldWindow fields[AGG_FIELD_COUNT];
+  SensorFrame mean;  // per-field mean; the latest value for fields with no reading
+};
+
+class WindowAggregator {
+public:
+  explicit WindowAggregator(uint32_t lengthMs) : length(lengthMs) {}
+
+  // A sensor job just updated `f` (latestFrame)
+  void add(SensorId id, const SensorFrame& f) {
+    switch (id) {
+      case SENSOR_DHT:
+        cur.fields[AGG_TEMPERATURE].add(f.temperature);
+        cur.fields[AGG_HUMIDITY].add(f.humidity);
+        break;
+      case SENSOR_DISTANCE: cur.fields[AGG_DISTANCE].add(f.distance); break;
+      case SENSOR_PPM:      cur.fields[AGG_PPM].add(f.ppm); break;
+      case SENSOR_PH:       cur.fields[AGG_PH].add(f.ph); break;
+      case SENSOR_WATER:    waterLow |= !f.waterSufficient; break;
+      default: break;
+    }
+  }
+
+  bool due(uint32_t nowMs) const { return nowMs - cur.startMs >= length; }
+  uint32_t dueInMs(uint32_t nowMs) const { return due(nowMs) ? 0 : length - (nowMs - cur.startMs); }
+
+  // Finish the current window (early if asked) and start the next one
+  WindowSummary close(uint32_t nowMs, const SensorFrame& latest) {
+    WindowSummary s = cur;
+    s.endMs = nowMs;
+    s.mean = latest;
+    float* means[AGG_FIELD_COUNT] = { &s.mean.temperature, &s.mean.humidity, &s.mean.distance,
+                                      &s.mean.ppm, &s.mean.ph };
+    for (int i = 0; i < AGG_FIELD_COUNT; i++) {
+      if (s.fields[i].count) *means[i] = s.fields[i].mean();
+    }
+    s.mean.waterSufficient = latest.waterSufficient && !waterLow;
+
+    cur = WindowSummary();
+    cur.startMs = nowMs;
+    waterLow = false;
+    return s;
+  }
+
+  void setLengthMs(uint32_t ms) { length = ms; }
+  uint32_t lengthMs() const { return length; }
+
+private:
+  uint32_t length;
+  WindowSummary cur;
+  bool waterLow = false;
+};
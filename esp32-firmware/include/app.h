@@ -0,0 +1,17 @@
+#pragma once
+#include <ArduinoJson.h>
+
+// ===================================================
+// Application: job table, sampling glue, setup/loop
+// ===================================================
+// Board-independent; main.cpp (ESP32) and native_main.cpp (Linux) just call
+// appSetup() once and appLoop() forever.
+
+void appSetup();
+void appLoop();
+
+// Server-pushed sampling policy overrides (see app.cpp)
+void applySamplingConfig(JsonVariant cfg);
+
+// [SCHED] table, regardless of VERBOSE_LOG
+void printSchedulerStats();
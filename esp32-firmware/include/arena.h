@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ===================================================
+// Bump arena
+// ===================================================
+// Fixed storage handed out front to back and released all at once with
+// reset(). Used for the per-cycle working memory of the uplink (JSON
+// documents, request and response buffers) so the steady-state path never
+// touches the heap: size it for the worst cycle, watch highWater().
+class Arena {
+public:
+  Arena(uint8_t* storage, size_t capacity) : base(storage), cap(capacity) {}
+
+  // nullptr when it doesn't fit (counted in overflows())
+  void* alloc(size_t n, size_t align = alignof(max_align_t)) {
+    size_t at = (top + align - 1) & ~(align - 1);
+    if (at + n > cap) { failed++; return nullptr; }
+    last = at;
+    top = at + n;
+    if (top > high) high = top;
+    return base + at;
+  }
+
+  // Grows in place when p is the most recent allocation, else moves it
+  void* realloc(void* p, size_t n) {
+    if (!p) return alloc(n);
+    size_t at = (uint8_t*)p - base;
+    if (at == last) {
+      if (at + n > cap) { failed++; return nullptr; }
+      top = at + n;
+      if (top > high) high = top;
+      return p;
+    }
+    void* q = alloc(n);
+    if (q) memmove(q, p, n < top - at ? n : top - at);  // old size unknown: bounded by top
+    return q;
+  }
+
+  void reset() { top = last = 0; }
+
+  size_t used() const { return top; }
+  size_t capacity() const { return cap; }
+  size_t highWater() const { return high; }
+  uint32_t overflows() const { return failed; }
+
+private:
+  uint8_t* base;
+  size_t cap;
+  size_t top = 0, last = 0, high = 0;
+  uint32_t failed = 0;
+};
+
+template <size_t N>
+class StaticArena : public Arena {
+public:
+  StaticArena() : Arena(storage, N) {}
+private:
+  alignas(max_align_t) uint8_t storage[N];
+};
@@ -0,0 +1,175 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+// ===================================================
+// Minimal CBOR (RFC 8949) writer and reader
+// ===================================================
+// Just what telemetry needs: definite-length maps and arrays, integers,
+// text strings, booleans and floats. Floats go out as half precision when
+// that round-trips exactly, else single. Both sides work on a caller buffer
+// and never allocate; ok() turns false on overflow / malformed input.
+
+class CborWriter {
+public:
+  CborWriter(uint8_t* buf, size_t cap) : p(buf), cap(cap) {}
+
+  void map(size_t n)   { head(5, n); }
+  void array(size_t n) { head(4, n); }
+  void integer(int64_t v) { if (v < 0) head(1, (uint64_t)(-1 - v)); else head(0, (uint64_t)v); }
+  void boolean(bool v) { put(v ? 0xF5 : 0xF4); }
+  void null() { put(0xF6); }
+  void text(const char* s) {
+    size_t n = strlen(s);
+    head(3, n);
+    if (room(n)) { memcpy(p + len, s, n); len += n; }
+  }
+  void number(float v) {
+    uint16_t h;
+    if (toHalf(v, h)) { put(0xF9); put(h >> 8); put(h); return; }
+    uint32_t bits;
+    memcpy(&bits, &v, 4);
+    put(0xFA);
+    for (int s = 24; s >= 0; s -= 8) put(bits >> s);
+  }
+
+  size_t size() const { return len; }
+  bool ok() const { return !overflow; }
+
+private:
+  void put(uint8_t b) { if (room(1)) p[len++] = b; }
+  bool room(size_t n) { if (len + n > cap) overflow = true; return !overflow; }
+
+  void head(uint8_t major, uint64_t v) {
+    uint8_t m = major << 5;
+    if (v < 24)               put(m | v);
+    else if (v <= 0xFF)       { put(m | 24); put(v); }
+    else if (v <= 0xFFFF)     { put(m | 25); put(v >> 8); put(v); }
+    else if (v <= 0xFFFFFFFF) { put(m | 26); for (int s = 24; s >= 0; s -= 8) put(v >> s); }
+    else                      { put(m | 27); for (int s = 56; s >= 0; s -= 8) put(v >> s); }
+  }
+
+  // Exact float -> binary16 (normals, zero, inf, NaN); false if it would lose bits
+  static bool toHalf(float v, uint16_t& h) {
+    uint32_t f;
+    memcpy(&f, &v, 4);
+    uint16_t sign = (f >> 16) & 0x8000;
+    int32_t exp = (int32_t)((f >> 23) & 0xFF);
+    uint32_t mant = f & 0x7FFFFF;
+    if (exp == 0xFF) { h = sign | 0x7C00 | (mant ? 0x200 : 0); return true; }
+    if (exp == 0 && mant == 0) { h = sign; return true; }
+    exp -= 127 - 15;
+    if (exp <= 0 || exp >= 31 || (mant & 0x1FFF)) return false;
+    h = sign | (uint16_t)(exp << 10) | (uint16_t)(mant >> 13);
+    return true;
+  }
+
+  uint8_t* p;
+  size_t cap;
+  size_t len = 0;
+  bool overflow = false;
+};
+
+class CborReader {
+public:
+  CborReader(const uint8_t* buf, size_t len) : p(buf), end(buf + len) {}
+
+  // Container headers: element / pair count
+  bool map(size_t& n)   { return count(5, n); }
+  bool array(size_t& n) { return count(4, n); }
+
+  bool integer(int64_t& v) {
+    uint8_t major;
+    uint64_t arg;
+    if (!head(major, arg) || major > 1) return fail();
+    v = major == 0 ? (int64_t)arg : -1 - (int64_t)arg;
+    return true;
+  }
+
+  // Any number (integer or float) as a float; booleans as 0/1
+  bool number(float& v) {
+    if (p >= end) return fail();
+    uint8_t ib = *p;
+    if (ib == 0xF4 || ib == 0xF5) { p++; v = ib == 0xF5; return true; }
+    if (ib == 0xF9 && end - p >= 3) { v = fromHalf(p[1] << 8 | p[2]); p += 3; return true; }
+    if (ib == 0xFA && end - p >= 5) {
+      uint32_t bits = (uint32_t)p[1] << 24 | p[2] << 16 | p[3] << 8 | p[4];
+      memcpy(&v, &bits, 4);
+      p += 5;
+      return true;
+    }
+    if (ib == 0xFB && end - p >= 9) {
+      uint64_t bits = 0;
+      for (int i = 1; i <= 8; i++) bits = bits << 8 | p[i];
+      double d;
+      memcpy(&d, &bits, 8);
+      v = (float)d;
+      p += 9;
+      return true;
+    }
+    int64_t i;
+    if (!integer(i)) return false;
+    v = (float)i;
+    return true;
+  }
+
+  // Skip one complete item, containers included
+  bool skip() {
+    uint8_t major;
+    uint64_t arg;
+    if (!head(major, arg)) return false;
+    switch (major) {
+      case 2: case 3:
+        if ((uint64_t)(end - p) < arg) return fail();
+        p += arg;
+        return true;
+      case 4: for (uint64_t i = 0; i < arg; i++) if (!skip()) return false; return true;
+      case 5: for (uint64_t i = 0; i < 2 * arg; i++) if (!skip()) return false; return true;
+      case 6: return skip();  // tagged item
+      default: return true;   // ints, simple values and floats are header-only
+    }
+  }
+
+  bool ok() const { return !bad; }
+  const uint8_t* position() const { return p; }  // start of the next item
+
+private:
+  bool fail() { bad = true; return false; }
+
+  bool count(uint8_t want, size_t& n) {
+    uint8_t major;
+    uint64_t arg;
+    if (!head(major, arg) || major != want) return fail();
+    n = (size_t)arg;
+    return true;
+  }
+
+  // Initial byte + argument; for major 7 the float payload is skipped over
+  bool head(uint8_t& major, uint64_t& arg) {
+    if (p >= end) return fail();
+    major = *p >> 5;
+    uint8_t info = *p++ & 0x1F;
+    if (info < 24) { arg = info; return true; }
+    if (info > 27) return fail();  // indefinite lengths are not used here
+    size_t n = (size_t)1 << (info - 24);
+    if ((size_t)(end - p) < n) return fail();
+    arg = 0;
+    for (size_t i = 0; i < n; i++) arg = arg << 8 | *p++;
+    return true;
+  }
+
+  static float fromHalf(uint16_t h) {
+    int exp = (h >> 10) & 0x1F;
+    int mant = h & 0x3FF;
+    float v = exp == 0  ? ldexpf((float)mant, -24) :
+              exp == 31 ? (mant ? NAN : INFINITY) :
+                          ldexpf((float)(mant | 0x400), exp - 25);
+    return (h & 0x8000) ? -v : v;
+  }
+
+  const uint8_t* p;
+  const uint8_t* end;
+  bool bad = false;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// Minimal CoAP (RFC 7252) message codec
+// ===================================================
+// What the LAN gateway transport needs: the 4-byte header, a token, the
+// Uri-Path / Content-Format / Uri-Query options (one segment each) and a
+// payload. Shared by the device (gateway.cpp) and the host stand-in
+// (tools/coap_gateway.cpp). Never allocates; decoded strings and payload
+// point into the datagram.
+
+enum CoapType : uint8_t { COAP_CON, COAP_NON, COAP_ACK, COAP_RST };
+
+// Codes as on the wire: class << 5 | detail ("2.04" = 0x44)
+const uint8_t COAP_EMPTY       = 0x00;
+const uint8_t COAP_POST        = 0x02;
+const uint8_t COAP_CHANGED     = 0x44;  // 2.04
+const uint8_t COAP_BAD_REQUEST = 0x80;  // 4.00
+const uint8_t COAP_NOT_FOUND   = 0x84;  // 4.04
+const uint8_t COAP_BAD_GATEWAY = 0xA2;  // 5.02
+
+// Same numbers as the HTTP status it maps to: 2.04 -> 204, 5.02 -> 502
+inline int coapStatus(uint8_t code) { return (code >> 5) * 100 + (code & 0x1F); }
+
+const uint16_t COAP_FORMAT_JSON = 50;
+const uint16_t COAP_FORMAT_CBOR = 60;
+const int COAP_NO_FORMAT = -1;
+
+struct CoapMessage {
+  uint8_t type = COAP_CON;
+  uint8_t code = COAP_EMPTY;
+  uint16_t messageId = 0;
+  uint8_t token[8];
+  uint8_t tokenLen = 0;
+  const char* uriPath = nullptr;   // encoding: NUL-terminated; decoding: uriPathLen chars
+  size_t uriPathLen = 0;
+  const char* uriQuery = nullptr;  // same, e.g. "d=<device id>"
+  size_t uriQueryLen = 0;
+  int contentFormat = COAP_NO_FORMAT;
+  const uint8_t* payload = nullptr;
+  size_t payloadLen = 0;
+};
+
+// Bytes written, 0 if it didn't fit
+size_t coapEncode(const CoapMessage& m, uint8_t* out, size_t cap);
+// False if malformed. Options other than the three above are skipped
+// (critical ones too: neither end sends any).
+bool coapDecode(const uint8_t* in, size_t len, CoapMessage& m);
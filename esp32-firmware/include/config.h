@@ -0,0 +1,136 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===== Debug verbosity toggle =====
+#ifndef VERBOSE_LOG
+#define VERBOSE_LOG 1  // set to 0 to quiet things down
+#endif
+
+// ===== Firmware version (a release build passes -DFIRMWARE_VERSION=...) =====
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "0.1.0"
+#endif
+
+// -------- WiFi & API --------
+const char* const ssid     = "Jonathan";
+const char* const password = "eeeeeeee";
+const char* const HOSTNAME = "planterbox-orcin.vercel.app";
+const int         HTTPS_PORT = 443;
+const char* const API_PATH = "/api/sensordata";
+// What the server files uploads under. Empty: derived from the eFuse MAC
+// (identity.h), which is what a fleet wants; set it to pin one.
+const char* const DEVICE_ID = "";
+
+// -------- Sensors / Pins --------
+#define DHTPIN   33
+#define DHTTYPE  DHT11
+#define TRIG_PIN 26
+#define ECHO_PIN 34
+#define PPM_SENSOR_PIN 39
+#define PH_SENSOR_PIN  36
+#define WATER_SENSOR_PIN 32
+#define LIGHT_PIN 15
+
+#define PH_UP_PUMP_PIN   21
+#define PH_DOWN_PUMP_PIN 19
+#define PPM_A_PUMP_PIN   18
+#define PPM_B_PUMP_PIN   5
+const int WATER_THRESHOLD = 680;
+const unsigned long MAX_DOSE_MS = 10000;  // cap on a server-requested pump run
+
+// -------- Stepper Motor (ULN2003 + 28BYJ-48) --------
+#define MOTOR_IN1 27
+#define MOTOR_IN2 14
+#define MOTOR_IN3 12
+#define MOTOR_IN4 13
+
+// -------- Light height --------
+const float TARGET_MIN_CM = 25.0f;
+const float TARGET_MAX_CM = 30.0f;
+const int LIGHT_ADJUST_STEPS = 5;
+const int MOTOR_STEP_DELAY_US = 5000;
+const unsigned long LIGHT_ADJUST_INTERVAL_MS = 1000;
+const unsigned long STEPPER_SETTLE_MS = 5000;  // distance sampled densely this long after a move
+
+// -------- Grow light PWM --------
+const int ledChannel = 0, ledFreq = 5000, ledResolution = 8;
+
+// -------- Uplink --------
+const unsigned long UPLINK_INTERVAL_MS = 3000;     // how often a frame is considered
+const unsigned long UPLINK_HEARTBEAT_MS = 30000;   // longest gap between sent frames
+const unsigned long UPLINK_WINDOW_MS = 60000;      // aggregation window ("window" mode)
+const int UPLINK_WINDOW_BACKLOG = 8;               // closed windows kept until acknowledged
+const int UPLINK_BATCH_MAX = 4;                    // backlog windows per HTTPS upload
+// Per-cycle working memory: request/response buffers and both JSON
+// documents. The high-water mark is on /metrics.
+const size_t UPLINK_ARENA_BYTES = 6144;
+const size_t UPLINK_PAYLOAD_BYTES = 768;  // a full batch of CBOR windows
+const size_t UPLINK_RESP_BYTES = 1024;
+const bool UPLINK_CBOR = true;  // false: JSON bodies (readable in logs / curl)
+// Server connection limits; the TLS library's own handshake timeout is 120 s
+const unsigned long UPLINK_CONNECT_TIMEOUT_MS = 5000;  // TCP connect + TLS handshake
+const unsigned long UPLINK_READ_TIMEOUT_MS = 5000;     // waiting for each part of the reply
+// Retry policy (uplink_policy.h): a failed upload waits 0.5-1x the backoff,
+// which doubles from MIN to MAX; BREAKER_FAILURES in a row stop uploads for
+// the cool-down, with closed windows kept in the backlog meanwhile
+const unsigned long UPLINK_RETRY_MIN_MS = 6000;
+const unsigned long UPLINK_RETRY_MAX_MS = 60000;
+const int UPLINK_BREAKER_FAILURES = 5;
+const unsigned long UPLINK_BREAKER_COOLDOWN_MS = 300000;
+// Pacing (uplink_policy.h): the server's next_upload_ms is clamped to
+// UPLINK_INTERVAL_MS..UPLINK_GAP_MAX_MS; without one, round trips slower
+// than UPLINK_SLOW_RTT_MS and failures stretch the gap toward the same cap
+const unsigned long UPLINK_GAP_MAX_MS = 600000;
+const unsigned long UPLINK_SLOW_RTT_MS = 1500;
+// Open the server connection this long before an upload is expected
+// (heartbeat, window close, end of a pacing gap); 0 disables it
+const unsigned long UPLINK_WARM_LEAD_MS = 3000;
+// DNS cache for HOSTNAME (dns_cache.h): records are refreshed in the
+// background at 3/4 of their TTL, clamped to this range
+const int DNS_MAX_ADDRS = 4;
+const unsigned long DNS_MIN_TTL_S = 30;
+const unsigned long DNS_MAX_TTL_S = 3600;
+const unsigned long DNS_TIMEOUT_MS = 2000;     // per query, then a retry
+const unsigned long DNS_RETRY_MAX_MS = 60000;  // retry backoff, doubling from the timeout
+const unsigned long SCHED_REPORT_INTERVAL_MS = 60000;
+
+// -------- Push channel (MQTT) --------
+// Needs a broker on the LAN (tools/mqtt_bridge.cpp or mosquitto); without
+// one the uplink is plain HTTPS. Console "push on" enables it at runtime.
+const bool PUSH_ENABLED = false;
+const char* const MQTT_HOST = "planterbox-gateway.local";
+const uint16_t MQTT_PORT = 1883;
+const bool MQTT_TLS = false;                     // true for a broker on 8883
+const uint16_t PUSH_KEEPALIVE_S = 30;
+const unsigned long PUSH_RETRY_MIN_MS = 5000;    // reconnect backoff, doubling
+const unsigned long PUSH_RETRY_MAX_MS = 300000;
+
+// -------- LAN gateway (CoAP over UDP) --------
+// Frames go to a gateway on the LAN (tools/coap_gateway.cpp) instead of
+// HTTPS to the server; console "gateway on" enables it at runtime. The
+// ACK timeout is LAN-sized: the RFC's 2 s assumes a lossy WAN.
+const bool GATEWAY_ENABLED = false;
+const char* const GATEWAY_HOST = "planterbox-gateway.local";
+const uint16_t GATEWAY_PORT = 5683;
+const char* const GATEWAY_PATH = "t";
+const unsigned long COAP_ACK_TIMEOUT_MS = 250;   // first wait, x1-1.5 jitter, doubling
+const int COAP_MAX_RETRANSMIT = 3;               // worst case ~5.6 s, then the frame waits
+
+// -------- Sensor history (RAM) --------
+// 1 KB blocks; a steady reservoir takes ~7 bytes a row, so 32 blocks hold
+// about three days at one row a minute (bench/history_bench.cpp).
+const unsigned long HISTORY_INTERVAL_MS = 60000;
+const int HISTORY_BLOCKS = 32;
+
+// -------- Local HTTP (dashboard, metrics, control) --------
+const uint16_t LOCAL_HTTP_PORT = 80;
+// Bearer token for the LAN control endpoints; empty disables them
+const char* const LOCAL_API_TOKEN = "";
+const unsigned long MANUAL_LIGHT_HOLD_MS = 600000;  // default server lockout after a manual light change
+const unsigned long LIVE_INTERVAL_MS = 100;         // fastest WebSocket frame rate
+const unsigned long LIVE_HEARTBEAT_MS = 1000;       // a frame at least this often
+// DNS-SD service type (_planterbox._tcp) and host name prefix; the HAL
+// appends the MAC's last three bytes, e.g. planterbox-a1b2c3.local
+const char* const MDNS_SERVICE = "planterbox";
+const bool MDNS_ENABLED = true;
@@ -0,0 +1,9 @@
+#pragma once
+
+// ===================================================
+// Serial command console
+// ===================================================
+// Polled as a scheduler job. One command per line, e.g. "trace dump"; "help"
+// lists them. Commands live in a compile-time table in console.cpp.
+
+void consoleTick();
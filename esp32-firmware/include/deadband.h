@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include "sensors.h"
+
+// ===================================================
+// Deadband filter for uplink frames
+// ===================================================
+// A frame is worth sending when any field has moved more than its band
+// away from the last frame the server acknowledged, when the water flag
+// flips, or when the heartbeat is due. Frames always go out whole, so the
+// server sees a step-held series: each stored sample stays valid until the
+// next one (see getHistoricalData() in route.js).
+struct Deadband {
+  float temperature, humidity, distance, ppm, ph;
+};
+
+class DeadbandFilter {
+public:
+  DeadbandFilter(const Deadband& band, uint32_t heartbeatMs) : band(band), heartbeat(heartbeatMs) {}
+
+  bool due(const SensorFrame& f, uint32_t nowMs) const {
+    if (!hasSent || pending || nowMs - sentMs >= heartbeat) return true;
+    return f.waterSufficient != last.waterSufficient ||
+           moved(f.temperature, last.temperature, band.temperature) ||
+           moved(f.humidity, last.humidity, band.humidity) ||
+           moved(f.distance, last.distance, band.distance) ||
+           moved(f.ppm, last.ppm, band.ppm) ||
+           moved(f.ph, last.ph, band.ph);
+  }
+
+  // Until the heartbeat alone makes a frame due; 0 if one already is
+  uint32_t heartbeatInMs(uint32_t nowMs) const {
+    if (!hasSent || pending || nowMs - sentMs >= heartbeat) return 0;
+    return heartbeat - (nowMs - sentMs);
+  }
+
+  // The server has this frame; bands are measured from it from now on
+  void sent(const SensorFrame& f, uint32_t nowMs) {
+    last = f;
+    sentMs = nowMs;
+    hasSent = true;
+    pending = false;
+  }
+
+  // Send the next frame regardless (something the server decides on changed)
+  void force() { pending = true; }
+
+  uint32_t heartbeatMs() const { return heartbeat; }
+
+private:
+  static bool moved(float v, float ref, float b) { return fabsf(v - ref) > b; }
+
+  Deadband band;
+  uint32_t heartbeat;
+  SensorFrame last;
+  uint32_t sentMs = 0;
+  bool hasSent = false, pending = false;
+};
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+
+// ===================================================
+// DNS cache for the uplink host
+// ===================================================
+// HOSTNAME's A records and their TTL, kept fresh by a scheduler job: the
+// query goes out on one tick and the answer is picked up on a later one,
+// and a refresh starts at 3/4 of the TTL, so an upload never waits on a
+// lookup. Records that expire without a refresh are dropped, and
+// hal::httpPost() goes back to resolving the name itself. An address that
+// refused a connection moves to the back of the list. Without a resolver
+// (native, no PLANTERBOX_DNS) the cache stays empty.
+
+void dnsCacheTick();
+uint32_t dnsCacheAddress();          // the address to try first (network order); 0 if none
+void dnsCacheFailed(uint32_t ipv4);  // it refused a connection: prefer the next one
+int dnsCacheCount();
+uint32_t dnsCacheTtlMs();            // until the records expire; 0 if none
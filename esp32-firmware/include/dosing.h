@@ -0,0 +1,30 @@
+#pragma once
+
+// ===================================================
+// Dosing state machines
+// ===================================================
+// The server decides *whether* to dose; the device owns pump timing, the
+// A -> delay -> B nutrient sequence and the global lockout between doses.
+
+enum PpmDosingState { PPM_IDLE, PPM_DOSING_A, PPM_DELAYING, PPM_DOSING_B };
+enum PhDosingState  { PH_IDLE,  PH_DOSING_UP, PH_DOSING_DOWN };
+
+extern PpmDosingState ppmState;
+extern PhDosingState  phState;
+extern unsigned long dosingDuration, delayDuration;
+extern unsigned long globalLockoutUntil;
+
+void dosingBegin();
+void stopAllPumps();
+void dosingTick();
+
+bool isLockedOut();
+unsigned long lockoutRemaining();
+bool dosingActive();  // a pump sequence is running or we're settling after one
+
+// Start at most one new dose for the server's commands. Respects the local
+// lockout; sequences already running continue. A non-zero doseMs (capped at
+// MAX_DOSE_MS) is the pump run time of the dose it starts; without one a
+// dose runs for dosingDuration.
+void applyDosingCommands(bool phUp, bool phDn, bool ppmA, bool ppmB, unsigned long lockoutMs,
+                         unsigned long doseMs = 0);
@@ -0,0 +1,138 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// ===================================================
+// Fixed-point filter pipeline
+// ===================================================
+// Integer-only replacement for the float averaging/calibration in the sensor
+// reads: median-of-K (outlier rejection) -> EMA or biquad (smoothing) ->
+// linear calibration. Every stage maps int32 -> int32 at a fixed cost, so the
+// chain is deterministic and cheap enough to run per sample once ADC reads
+// move to DMA. Header-only and Arduino-free so it also builds on the host
+// (see bench/filter_bench.cpp).
+
+// Median of the last K inputs (K odd and small, e.g. 3 or 5)
+template <uint8_t K>
+class MedianFilter {
+  static_assert(K & 1, "MedianFilter needs an odd window");
+public:
+  int32_t process(int32_t x) {
+    hist[pos] = x;
+    if (++pos == K) pos = 0;
+    if (fill < K) fill++;
+
+    if (K == 3 && fill == 3) {  // compare network, the common case
+      int32_t a = hist[0], b = hist[1], c = hist[2];
+      int32_t lo = a < b ? a : b, hi = a < b ? b : a;
+      return c < lo ? lo : (c > hi ? hi : c);
+    }
+
+    int32_t s[K];
+    for (uint8_t i = 0; i < fill; i++) {
+      int32_t v = hist[i];
+      uint8_t j = i;
+      for (; j > 0 && s[j - 1] > v; j--) s[j] = s[j - 1];
+      s[j] = v;
+    }
+    return s[fill / 2];
+  }
+  void reset() { pos = 0; fill = 0; }
+
+private:
+  int32_t hist[K];
+  uint8_t pos = 0, fill = 0;
+};
+
+// Exponential moving average with alpha = 1 / 2^SHIFT. The state carries
+// 8 extra fractional bits so small steps aren't lost to truncation.
+template <uint8_t SHIFT>
+class EmaFilter {
+public:
+  int32_t process(int32_t x) {
+    int32_t xs = x * (1 << FRAC);
+    if (!primed) { acc = xs; primed = true; }
+    acc += (xs - acc) >> SHIFT;
+    return (acc + (1 << (FRAC - 1))) >> FRAC;
+  }
+  void reset() { primed = false; }
+
+private:
+  static const uint8_t FRAC = 8;
+  int32_t acc = 0;
+  bool primed = false;
+};
+
+// Direct-form-I biquad with Q14 coefficients (1.0 = 16384, a0 normalised)
+class BiquadFilter {
+public:
+  BiquadFilter(int32_t b0, int32_t b1, int32_t b2, int32_t a1, int32_t a2)
+      : b0(b0), b1(b1), b2(b2), a1(a1), a2(a2) {}
+
+  // RBJ low-pass; cutoff is a fraction of the sample rate (0 < f < 0.5).
+  // Float math here runs once at construction, never per sample.
+  static BiquadFilter lowpass(float cutoff, float q = 0.7071f) {
+    float w = 2.0f * (float)M_PI * cutoff;
+    float alpha = sinf(w) / (2.0f * q), c = cosf(w);
+    float a0 = 1.0f + alpha;
+    float k = 16384.0f / a0;
+    return BiquadFilter(lroundf((1.0f - c) / 2.0f * k), lroundf((1.0f - c) * k),
+                        lroundf((1.0f - c) / 2.0f * k), lroundf(-2.0f * c * k),
+                        lroundf((1.0f - alpha) * k));
+  }
+
+  int32_t process(int32_t x) {
+    if (!primed) { x1 = x2 = y1 = y2 = x; primed = true; }
+    int64_t acc = (int64_t)b0 * x + (int64_t)b1 * x1 + (int64_t)b2 * x2
+                - (int64_t)a1 * y1 - (int64_t)a2 * y2;
+    int32_t y = (int32_t)((acc + (1 << 13)) >> 14);
+    x2 = x1; x1 = x;
+    y2 = y1; y1 = y;
+    return y;
+  }
+  void reset() { primed = false; }
+
+private:
+  int32_t b0, b1, b2, a1, a2;
+  int32_t x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+  bool primed = false;
+};
+
+// y = x * gain + offset, gain in Q16
+class LinearCal {
+public:
+  LinearCal(int32_t gainQ16 = 1 << 16, int32_t offset = 0) : gain(gainQ16), offset(offset) {}
+
+  static LinearCal fromFloat(float gain, float offset) {
+    return LinearCal(lroundf(gain * 65536.0f), lroundf(offset));
+  }
+
+  int32_t process(int32_t x) const {
+    return (int32_t)(((int64_t)x * gain + (1 << 15)) >> 16) + offset;
+  }
+  void reset() {}
+
+private:
+  int32_t gain, offset;
+};
+
+struct PassThrough {
+  int32_t process(int32_t x) const { return x; }
+  void reset() {}
+};
+
+// Three-stage chain; stages are public so calibration can be retuned at
+// runtime (e.g. temperature compensation).
+template <class Pre, class Smooth, class Cal>
+class FilterPipeline {
+public:
+  FilterPipeline(const Pre& p = Pre(), const Smooth& s = Smooth(), const Cal& c = Cal())
+      : pre(p), smooth(s), cal(c) {}
+
+  int32_t process(int32_t x) { return cal.process(smooth.process(pre.process(x))); }
+  void reset() { pre.reset(); smooth.reset(); cal.reset(); }
+
+  Pre pre;
+  Smooth smooth;
+  Cal cal;
+};
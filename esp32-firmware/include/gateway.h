@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+
+// ===================================================
+// LAN gateway transport: confirmable CoAP over UDP
+// ===================================================
+// For installations with a gateway next to the boxes: each frame is one
+// CON POST to coap://GATEWAY_HOST/t?d=<device>, retransmitted with
+// exponential backoff until the gateway ACKs it. The gateway batches frames
+// to /api/sensordata over HTTPS and piggybacks the latest server reply
+// (the usual command JSON) on its ACKs, so the device runs no TLS or TCP.
+// tools/coap_gateway.cpp is the reference stand-in.
+
+// Same contract as hal::httpPost(): the response code mapped onto HTTP
+// numbers (2.04 -> 204), or a negative GATEWAY_ERR_*. An empty ACK payload
+// leaves `resp` empty. timing->totalUs is the exchange, retransmits included.
+int gatewayPost(const uint8_t* body, size_t len, bool cbor,
+                char* resp, size_t respCap, hal::HttpTiming* timing = nullptr);
+const char* gatewayErrorString(int code);
+
+const int GATEWAY_ERR_SOCKET  = -200;  // no UDP socket / couldn't send
+const int GATEWAY_ERR_TIMEOUT = -201;  // no ACK after all retransmissions
+const int GATEWAY_ERR_RESET   = -202;  // gateway answered RST
+
+void gatewayEnable(bool on);  // console "gateway"; GATEWAY_ENABLED at boot
+bool gatewayEnabled();
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "aggregate.h"
+
+// ===================================================
+// Gorilla-compressed sensor history
+// ===================================================
+// Rows of (time, one value per AggField) packed the way Facebook's Gorilla
+// TSDB does it: timestamps as delta-of-delta, values XORed with the
+// previous value of the same field so an unchanged reading costs one bit
+// and a small change only its meaningful bits. At a fixed row interval the
+// timestamp is one bit per row too.
+//
+// Storage is a ring of fixed-size blocks. Each block starts from a raw row
+// and decodes on its own; when the last one fills up the oldest is
+// overwritten. No heap, no flash.
+
+struct HistoryRow {
+  uint32_t t;  // seconds
+  float v[AGG_FIELD_COUNT];
+};
+
+struct HistoryBlock {
+  static const size_t BYTES = 1024;
+  uint16_t rows;
+  uint16_t bits;   // used
+  uint8_t data[BYTES];
+};
+
+class HistoryStore {
+public:
+  HistoryStore(HistoryBlock* blocks, int count) : blocks(blocks), count(count) { clear(); }
+
+  void append(const HistoryRow& r);
+  void clear();
+
+  // Oldest to newest, rows with t >= fromT; fn returns false to stop
+  void scan(uint32_t fromT, bool (*fn)(void* ctx, const HistoryRow& r), void* ctx) const;
+
+  uint32_t rows() const;
+  size_t bytesUsed() const;  // payload bits rounded up, over all live blocks
+  size_t capacityBytes() const { return (size_t)count * sizeof(HistoryBlock); }
+  bool oldest(uint32_t& t) const;
+
+private:
+  HistoryBlock* blocks;
+  int count;
+  int head = 0;   // oldest live block
+  int live = 0;   // blocks holding rows (the last one is open)
+
+  // Encoder state of the open block
+  uint32_t prevT = 0;
+  int32_t prevDelta = 0;
+  uint32_t prevBits[AGG_FIELD_COUNT] = {};
+  uint8_t prevLead[AGG_FIELD_COUNT] = {}, prevTrail[AGG_FIELD_COUNT] = {};
+};
+
+// Storage for N blocks
+template <int N>
+class StaticHistory : public HistoryStore {
+public:
+  StaticHistory() : HistoryStore(storage, N) {}
+private:
+  HistoryBlock storage[N];
+};
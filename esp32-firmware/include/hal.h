@@ -0,0 +1,156 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// Hardware abstraction layer
+// ===================================================
+// Everything the control logic needs from the board, so the same sources
+// build for the ESP32 (hal_esp32.cpp) and for Linux (hal_native.cpp). Plain
+// functions, no virtual dispatch: the implementation is picked at link time
+// by each PlatformIO env's build_src_filter.
+
+namespace hal {
+
+// -------- Clock --------
+uint32_t millis();
+uint32_t micros();
+void delayMs(uint32_t ms);  // lets other tasks run / the core idle
+void delayUs(uint32_t us);  // short busy wait
+void yield();
+
+// -------- GPIO --------
+void pinOutput(uint8_t pin);
+void pinInput(uint8_t pin);
+void digitalWrite(uint8_t pin, bool high);
+// Length of the next HIGH pulse in us, 0 on timeout
+uint32_t pulseInHigh(uint8_t pin, uint32_t timeoutUs);
+
+// -------- ADC --------
+// maxMilliVolts picks the input range (attenuation on the ESP32)
+bool     adcAttach(uint8_t pin, uint16_t maxMilliVolts = 3100);
+int      adcReadRaw(uint8_t pin);
+uint16_t adcReadMilliVolts(uint8_t pin);
+float    adcMilliVoltsToRaw(uint8_t pin, float mv);  // the raw count a reading came from
+
+// -------- PWM --------
+void pwmAttach(uint8_t pin, uint8_t channel, uint32_t freqHz, uint8_t bits);
+void pwmWrite(uint8_t channel, uint32_t duty);
+
+// -------- DHT temperature / humidity --------
+void dhtBegin();
+void dhtRead(float& tempC, float& humidity);  // NaN on failure, like the library
+
+// -------- Network / HTTP transport --------
+void networkBegin(const char* ssid, const char* password);  // blocks until up
+bool networkUp();
+
+struct HttpTiming {
+  uint32_t connectUs = 0;  // TCP connect + TLS handshake
+  uint32_t totalUs = 0;    // whole call
+};
+
+// POST `body` and copy the response body (NUL-terminated, truncated to
+// respCap - 1) into `resp`. Returns the HTTP status, or a negative transport
+// error that httpErrorString() can describe. A non-zero `ipv4` (network
+// order, e.g. from dns_cache.h) is connected to instead of resolving
+// `host`, which still names the server for TLS (SNI) and the Host header.
+int httpPost(const char* host, uint16_t port, const char* path,
+             const char* contentType, const uint8_t* body, size_t len,
+             char* resp, size_t respCap, HttpTiming* timing = nullptr, uint32_t ipv4 = 0);
+const char* httpErrorString(int code);
+// Open the connection httpPost() would use, if it isn't already, so the
+// next POST skips the connect; blocks like the connect in httpPost().
+// 1 if it connected, 0 if the connection was open, else HTTP_ERR_CONNECT.
+int httpWarm(const char* host, uint16_t port, uint32_t ipv4 = 0);
+
+const int HTTP_ERR_CONNECT = -1;  // no connection to the server
+const int HTTP_ERR_BEGIN = -100;  // bad URL / request setup
+
+// -------- DNS resolver socket --------
+// Plain DNS over UDP to the network's resolver: the one DHCP handed out on
+// the ESP32, PLANTERBOX_DNS=ip[:port] natively (none without it). Never
+// blocks; resolverRecv() returns 0 until a datagram is there. Each send
+// opens a new socket on a random port (dropping any answer still due to
+// the last one), and only datagrams from that resolver's port 53 are read.
+bool resolverSend(const uint8_t* data, size_t len);
+int  resolverRecv(uint8_t* buf, size_t cap);
+
+// -------- Push channel socket --------
+// One long-lived TCP connection (TLS if asked) for the push channel
+// (push.cpp), separate from the uplink's. Connecting blocks like
+// httpPost(); reads and the liveness check never do.
+bool streamConnect(const char* host, uint16_t port, bool useTls);
+bool streamConnected();
+bool streamWrite(const uint8_t* data, size_t len);  // all of it, or false (connection dropped)
+int  streamRead(uint8_t* buf, size_t cap);          // bytes read, 0 if none yet, -1 once closed
+void streamClose();
+
+// -------- Datagram socket --------
+// One UDP socket for the LAN gateway transport (gateway.cpp). Never
+// blocks: udpRecv() returns 0 until a datagram is there, and truncates one
+// longer than `cap`. Only datagrams from the address and port udpSend()
+// last sent to are read; anything else is discarded.
+bool udpBegin(uint16_t localPort);
+bool udpSend(const char* host, uint16_t port, const uint8_t* data, size_t len);
+int  udpRecv(uint8_t* buf, size_t cap);
+
+// -------- Local HTTP server --------
+// Minimal polled server for LAN endpoints. The handler runs inside
+// httpServerPoll(), starts its reply with httpReplyBegin() and streams the
+// body with httpReplyWrite(); the connection closes when it returns.
+struct HttpConn;  // only valid during the handler call
+typedef void (*HttpServeFn)(HttpConn* c, const char* method, const char* path);
+bool httpServerBegin(uint16_t port, HttpServeFn fn);
+void httpServerPoll();
+void httpReplyBegin(HttpConn* c, int status, const char* contentType);
+void httpReplyWrite(HttpConn* c, const char* data, size_t len);
+// Request header value (nullptr if absent; valid until the next call). The
+// ESP32 server only keeps the headers named in hal_esp32.cpp.
+const char* httpHeader(HttpConn* c, const char* name);
+// Request body, NUL-terminated and truncated to cap - 1; returns its length
+size_t httpBody(HttpConn* c, char* buf, size_t cap);
+
+// Keep the connection past the handler (WebSocket upgrade): no HTTP reply
+// is sent, the caller talks on it through the socket id. -1 if all
+// HTTP_DETACHED_MAX slots are taken. Reads never block.
+const int HTTP_DETACHED_MAX = 4;
+int  httpDetach(HttpConn* c);
+bool sockWrite(int s, const uint8_t* data, size_t len);  // all of it, or false (closed)
+int  sockRead(int s, uint8_t* buf, size_t cap);          // bytes read, 0 if none yet, -1 once closed
+void sockClose(int s);
+
+// -------- Identity --------
+// Factory-programmed base MAC (eFuse on the ESP32). The native build makes
+// a locally administered one from the host name and PLANTERBOX_LOCAL_PORT,
+// so instances on one machine differ and keep their ID across restarts.
+void deviceMac(uint8_t mac[6]);
+// Unpredictable 32 bits (hardware RNG on the ESP32), e.g. per-boot IDs
+uint32_t randomU32();
+
+// -------- Service discovery --------
+// Answer mDNS for <service>-<id>.local and advertise _<service>._tcp on
+// `port` with TXT "key=value" entries, for collectors on the LAN. Once, at
+// boot; the ESP32 responder runs in its own task, the native one in a thread.
+bool mdnsAdvertise(const char* service, uint16_t port, const char* const* txt, size_t txtCount);
+
+// -------- Memory --------
+struct HeapStats {
+  uint32_t freeBytes = 0;         // 0 when the target can't tell
+  uint32_t largestFreeBlock = 0;
+  uint32_t minFreeBytes = 0;      // low-water mark since boot
+};
+HeapStats heapStats();
+// Stack bytes a task has never used since it started; nullptr = the
+// calling task. 0 if the task doesn't exist or the target can't tell.
+uint32_t stackHighWater(const char* task = nullptr);
+
+// -------- Console --------
+void consoleBegin(uint32_t baud);
+void logf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+// Bytes logf() can take right now without blocking on the UART
+size_t consoleWriteSpace();
+// Non-blocking: true once a whole line (without the newline) is in `line`
+bool consoleReadLine(char* line, size_t cap);
+
+}  // namespace hal
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// HAL: host-only hooks
+// ===================================================
+// The Linux HAL has no real pins, so sensor inputs are whatever was last set
+// here and outputs can be inspected. Defaults describe a healthy reservoir
+// (pH ~7, ~800 ppm, 27 cm lamp distance) so a plain native run sends
+// plausible frames.
+
+namespace hal {
+namespace native {
+
+void setAdcMilliVolts(uint8_t pin, uint16_t mv);
+// Raw count 0 reads as offsetMv, each count adds mvPerCount, and nothing reads
+// lower: the ESP32's eFuse calibration at 11 dB is ~75-150 mV and ~0.8 mV.
+// Default 0 and 3300/4095, where calibrated mV and the legacy scale agree.
+void setAdcCalibration(float offsetMv, float mvPerCount);
+void setEchoPulseUs(uint8_t pin, uint32_t us);
+void setDht(float tempC, float humidity);
+
+bool     pinLevel(uint8_t pin);
+uint32_t pwmDuty(uint8_t channel);
+
+// -------- Virtual clock (simulator) --------
+// Once enabled, time only moves when the firmware waits (delayMs, delayUs,
+// pulseInHigh) or the host calls advanceClock(), so simulated days run as
+// fast as the control code does. onAdvance sees every step, after the fact;
+// it must not advance the clock itself. micros()/millis() wrap like the chip.
+void useVirtualClock(void (*onAdvance)(uint64_t nowUs) = nullptr);
+void advanceClock(uint64_t us);
+uint64_t clockUs();
+
+// In-process server: when set, httpPost() calls this instead of opening a
+// socket. Same contract as hal::httpPost.
+typedef int (*HttpHandler)(const char* path, const char* contentType,
+                           const uint8_t* body, size_t len,
+                           char* resp, size_t respCap);
+void setHttpHandler(HttpHandler fn);
+
+void setConsoleMuted(bool muted);
+
+}  // namespace native
+}  // namespace hal
@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+#include "gorilla.h"
+#include "metrics.h"
+
+// ===================================================
+// Sensor history in RAM
+// ===================================================
+// A row of latestFrame every HISTORY_INTERVAL_MS into a Gorilla store
+// (gorilla.h). Values are first rounded to what the sensors resolve, so a
+// steady reading repeats exactly and costs one bit. Times are seconds since
+// boot. For looking back without a round trip to the server: GET /history
+// and the "hist" command render it as CSV.
+// Uploads don't backfill from it: an outage is covered by the uplink's
+// window backlog (UPLINK_WINDOW_BACKLOG), and anything older is only here.
+
+const HistoryStore& sensorHistory();
+void historyTick();
+
+// CSV (t_s,temperature,humidity,distance,ppm,ph), rows with t >= sinceS
+void historyRender(MetricsOut& out, uint32_t sinceS);
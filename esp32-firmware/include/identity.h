@@ -0,0 +1,11 @@
+#pragma once
+
+// ===================================================
+// Device identity
+// ===================================================
+// What the server files this box's uploads under, the push topics and the
+// gateway query carry, and /status, /metrics and mDNS report. DEVICE_ID
+// (config.h) if set, else "planterbox-" and the 48-bit eFuse MAC in hex:
+// stable across reflashes and unique per board.
+
+const char* deviceId();
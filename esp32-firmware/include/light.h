@@ -0,0 +1,14 @@
+#pragma once
+
+// ===================================================
+// Grow light: PWM brightness and automatic height control
+// ===================================================
+extern unsigned long lastStepperMoveMs;
+
+void lightBegin();
+void controlGrowLight(int brightness);  // server commands
+// Manual brightness from the LAN API: server commands leave the light alone
+// until holdMs has passed
+void overrideGrowLight(int brightness, unsigned long holdMs);
+int growLightLevel();
+void adjustLightHeightAuto();
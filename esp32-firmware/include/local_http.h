@@ -0,0 +1,23 @@
+#pragma once
+
+// ===================================================
+// Local HTTP endpoints (LAN only, no TLS)
+// ===================================================
+//   GET  /            status page: live values over WebSocket, manual controls
+//   GET  /status      the live frame as JSON, once
+//   GET  /live        WebSocket: a JSON frame on every sensor update
+//                     (at most every LIVE_INTERVAL_MS, at least every
+//                     LIVE_HEARTBEAT_MS)
+//   POST /api/light   {"light":0-255, "hold_ms":n}      bearer token
+//   POST /api/dose    {"pump":"ph_up|ph_down|nutrients"} bearer token
+//   GET  /metrics     Prometheus text format (metrics.h)
+//   GET  /history     sensor history as CSV (history.h)
+// Served from the scheduler: localHttpTick() handles at most one request
+// and services the WebSocket clients. Manual doses go through the same
+// dosing state machine and lockout as the server's.
+// The server is advertised over mDNS as _planterbox._tcp with TXT id, fw,
+// metrics and status, for tools/fleet_collector.cpp and the like.
+
+void localHttpBegin();
+void localHttpTick();
+void localLiveObserve();  // a sensor job just updated latestFrame
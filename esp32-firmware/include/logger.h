@@ -0,0 +1,170 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+#include "config.h"
+
+// ===================================================
+// Deferred logger
+// ===================================================
+// A log call stores a pointer to its static call-site record (format string,
+// module, level) plus the raw arguments in a lock-free single-producer /
+// single-consumer ring. Nothing is formatted or written to the UART at the
+// call site: the lowest-priority "log_drain" job formats records later, and
+// only as many as the console can take without blocking.
+//
+//   static constexpr LogModule LOG_THIS = LOG_MOD_DOSING;  // once per file
+//   LOGI("[pH] UP START | lockout until %lu\n", until);
+//
+// Strings (%s) are copied, truncated to LOG_MAX_STR bytes. Levels can be
+// changed per module at runtime ("log" console command); anything above a
+// module's compile-time ceiling (LOG_MAX_<MODULE>, default LOG_MAX_DEFAULT)
+// is removed by the compiler, arguments and format string included.
+
+#define LOG_LVL_NONE  0
+#define LOG_LVL_ERROR 1
+#define LOG_LVL_WARN  2
+#define LOG_LVL_INFO  3
+#define LOG_LVL_DEBUG 4
+
+#ifndef LOG_MAX_DEFAULT
+#define LOG_MAX_DEFAULT (VERBOSE_LOG ? LOG_LVL_DEBUG : LOG_LVL_NONE)
+#endif
+#ifndef LOG_MAX_SENSORS
+#define LOG_MAX_SENSORS LOG_MAX_DEFAULT
+#endif
+#ifndef LOG_MAX_DOSING
+#define LOG_MAX_DOSING LOG_MAX_DEFAULT
+#endif
+#ifndef LOG_MAX_LIGHT
+#define LOG_MAX_LIGHT LOG_MAX_DEFAULT
+#endif
+#ifndef LOG_MAX_UPLINK
+#define LOG_MAX_UPLINK LOG_MAX_DEFAULT
+#endif
+#ifndef LOG_MAX_SAMPLING
+#define LOG_MAX_SAMPLING LOG_MAX_DEFAULT
+#endif
+#ifndef LOG_MAX_SCHED
+#define LOG_MAX_SCHED LOG_MAX_DEFAULT
+#endif
+
+#ifndef LOG_RING_BYTES
+#define LOG_RING_BYTES 4096  // power of two
+#endif
+#ifndef LOG_MAX_STR
+#define LOG_MAX_STR 255  // length is stored in one byte
+#endif
+
+enum LogModule : uint8_t {
+  LOG_MOD_SENSORS, LOG_MOD_DOSING, LOG_MOD_LIGHT, LOG_MOD_UPLINK,
+  LOG_MOD_SAMPLING, LOG_MOD_SCHED, LOG_MOD_COUNT
+};
+
+constexpr uint8_t LOG_COMPILED_MAX[LOG_MOD_COUNT] = {
+  LOG_MAX_SENSORS, LOG_MAX_DOSING, LOG_MAX_LIGHT, LOG_MAX_UPLINK,
+  LOG_MAX_SAMPLING, LOG_MAX_SCHED,
+};
+
+extern uint8_t logLevels[LOG_MOD_COUNT];  // runtime, default LOG_LVL_INFO
+
+struct LogSite {
+  const char* fmt;
+  LogModule module;
+  uint8_t level;
+};
+
+const char* logModuleName(LogModule m);
+bool logParseModule(const char* name, LogModule& out);
+const char* logLevelName(uint8_t level);
+bool logParseLevel(const char* name, uint8_t& out);
+
+void logDrainTick();        // scheduler job: format what the console can take
+void logFlush();            // format everything now, blocking (boot, crash paths)
+uint32_t logDropped();      // records lost to a full ring
+
+// -------- Argument capture --------
+// Each argument is a 1-byte tag plus its value; formatting later follows the
+// format string, using the tag only to widen the value back.
+enum LogArgTag : uint8_t { LOG_ARG_I32, LOG_ARG_U32, LOG_ARG_I64, LOG_ARG_F32, LOG_ARG_STR };
+
+namespace logdetail {
+
+inline uint8_t strLen(const char* s) {
+  size_t n = 0;
+  if (s) while (n < LOG_MAX_STR && s[n]) n++;
+  return (uint8_t)n;
+}
+
+template <class T>
+inline size_t argSize(T) {
+  static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "unsupported log argument");
+  return 1 + (sizeof(T) > 4 && !std::is_floating_point<T>::value ? 8 : 4);
+}
+inline size_t argSize(const char* s) { return 2 + strLen(s); }
+inline size_t argSize(char* s) { return argSize((const char*)s); }
+
+template <class T>
+inline uint8_t* putArg(uint8_t* p, T v) {
+  if (std::is_floating_point<T>::value) {
+    float f = (float)v;
+    *p++ = LOG_ARG_F32; memcpy(p, &f, 4); return p + 4;
+  }
+  if (sizeof(T) > 4) {
+    int64_t x = (int64_t)v;
+    *p++ = LOG_ARG_I64; memcpy(p, &x, 8); return p + 8;
+  }
+  bool isSigned = std::is_signed<T>::value;
+  uint32_t x = (uint32_t)v;
+  *p++ = isSigned ? LOG_ARG_I32 : LOG_ARG_U32; memcpy(p, &x, 4); return p + 4;
+}
+inline uint8_t* putArg(uint8_t* p, const char* s) {
+  uint8_t n = strLen(s);
+  *p++ = LOG_ARG_STR; *p++ = n; memcpy(p, s, n); return p + n;
+}
+inline uint8_t* putArg(uint8_t* p, char* s) { return putArg(p, (const char*)s); }
+
+inline size_t argsSize() { return 0; }
+template <class A, class... R>
+inline size_t argsSize(A a, R... r) { return argSize(a) + argsSize(r...); }
+
+inline uint8_t* putArgs(uint8_t* p) { return p; }
+template <class A, class... R>
+inline uint8_t* putArgs(uint8_t* p, A a, R... r) { return putArgs(putArg(p, a), r...); }
+
+// Reserve a record in the ring; returns a linear scratch area to fill, or
+// nullptr when the ring is full (the record is counted as dropped).
+uint8_t* begin(const LogSite* site, size_t argBytes, uint8_t nargs);
+void commit();
+
+inline void checkFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void checkFormat(const char*, ...) {}
+
+}  // namespace logdetail
+
+template <class... A>
+inline void logDeferred(const LogSite* site, A... args) {
+  size_t bytes = logdetail::argsSize(args...);
+  uint8_t* p = logdetail::begin(site, bytes, sizeof...(A));
+  if (!p) return;
+  logdetail::putArgs(p, args...);
+  logdetail::commit();
+}
+
+#define LOG_AT(lvl, fmt, ...) do {                                              \
+    if (LOG_ON(lvl)) {                                                          \
+      static const LogSite logSite_ = { fmt, LOG_THIS, lvl };                   \
+      if (0) logdetail::checkFormat(fmt, ##__VA_ARGS__);                        \
+      logDeferred(&logSite_, ##__VA_ARGS__);                                    \
+    }                                                                           \
+  } while (0)
+
+#define LOGE(fmt, ...) LOG_AT(LOG_LVL_ERROR, fmt, ##__VA_ARGS__)
+#define LOGW(fmt, ...) LOG_AT(LOG_LVL_WARN,  fmt, ##__VA_ARGS__)
+#define LOGI(fmt, ...) LOG_AT(LOG_LVL_INFO,  fmt, ##__VA_ARGS__)
+#define LOGD(fmt, ...) LOG_AT(LOG_LVL_DEBUG, fmt, ##__VA_ARGS__)
+
+// True when a level would be logged; for guarding work done only for a log
+#define LOG_ENABLED(mod, lvl) ((lvl) <= LOG_COMPILED_MAX[mod] && (lvl) <= logLevels[mod])
+#define LOG_ON(lvl) LOG_ENABLED(LOG_THIS, lvl)
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// Minimal mDNS / DNS-SD (RFC 6762 / 6763) messages
+// ===================================================
+// One service type, one instance per answer: a PTR for the browse, the
+// instance's SRV (port, host) and TXT, and an A record when the address is
+// known. The ESP32 has ESPmDNS; this is for the native responder
+// (hal_native.cpp) and the host collector (tools/fleet_collector.cpp).
+// Plus plain unicast A lookups, for the uplink's DNS cache (dns_cache.h).
+
+const int MDNS_MAX_TXT = 6;
+
+struct MdnsService {
+  char instance[64] = "";  // "<host>._planterbox._tcp.local"
+  char host[48] = "";      // "<host>.local"
+  uint16_t port = 0;
+  uint32_t ipv4 = 0;       // network order; 0 if the answer had no A record
+  char txt[MDNS_MAX_TXT][48];
+  int txtCount = 0;
+};
+
+// PTR question for `service` ("_planterbox._tcp.local"); 0 if it didn't fit
+size_t mdnsQuery(uint8_t* out, size_t cap, uint16_t id, const char* service);
+// Does this message ask for `service`? `id` is echoed in legacy unicast replies
+bool mdnsAsks(const uint8_t* in, size_t len, const char* service, uint16_t& id);
+// PTR + SRV + TXT (+ A) for one instance; 0 if it didn't fit
+size_t mdnsAnswer(uint8_t* out, size_t cap, uint16_t id, const char* service, const MdnsService& s);
+// The instance of `service` announced in a response; false if none
+bool mdnsParseAnswer(const uint8_t* in, size_t len, const char* service, MdnsService& s);
+
+// -------- Unicast DNS --------
+// A question for `host`, recursion desired; 0 if it didn't fit
+size_t dnsQueryA(uint8_t* out, size_t cap, uint16_t id, const char* host);
+// The A records (network order) of the answer to query `id` for `host`, at
+// most `max`, and the shortest TTL on the way to them (CNAMEs included).
+// Returns how many (0 if the resolver had none or reported an error); -1 if
+// this isn't the answer to that query (other ID, or another question echoed).
+int dnsParseA(const uint8_t* in, size_t len, uint16_t id, const char* host,
+              uint32_t* addrs, int max, uint32_t& ttlS);
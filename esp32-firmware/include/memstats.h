@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+
+// ===================================================
+// Heap / stack instrumentation
+// ===================================================
+// Every heap allocation is counted against the code region the loop task is
+// in (MEM_REGION(...) scopes); allocations made by other tasks (WiFi, lwIP,
+// events) go to "background". The hook is the linker's --wrap=malloc on the
+// ESP32 and a replaced operator new on the host. Heap and stack figures come
+// from the allocator / FreeRTOS and are read on demand, so keeping them costs
+// nothing per cycle; the uplink reports them with every frame.
+
+enum MemRegion : uint8_t {
+  MEM_OTHER,       // loop task, outside any region
+  MEM_SENSING,
+  MEM_JSON,
+  MEM_TLS,         // connect + handshake
+  MEM_HTTP,        // request / response after connect
+  MEM_BACKGROUND,  // other tasks
+  MEM_REGION_COUNT
+};
+
+struct MemRegionStats {
+  uint32_t allocs;
+  uint32_t bytes;
+};
+
+extern MemRegionStats memRegions[MEM_REGION_COUNT];  // cumulative since boot
+
+const char* memRegionName(MemRegion r);
+uint32_t memTotalAllocs();
+
+// Called by the allocator hook
+void memRecordAlloc(size_t bytes, bool onLoopTask);
+
+MemRegion memSetRegion(MemRegion r);  // returns the previous region
+
+class MemRegionScope {
+public:
+  explicit MemRegionScope(MemRegion r) : prev(memSetRegion(r)) {}
+  ~MemRegionScope() { memSetRegion(prev); }
+private:
+  MemRegion prev;
+};
+
+#define MEM_REGION(r) MemRegionScope memRegion_(r)
+
+// Tasks whose stack high-water marks are reported (0 = not running here)
+extern const char* const MEM_TASKS[];
+extern const int MEM_TASK_COUNT;
+
+struct MemSnapshot {
+  hal::HeapStats heap;
+  uint8_t fragPct;         // 100 * (1 - largest block / free)
+  uint32_t loopStackFree;  // bytes never touched on the loop task's stack
+};
+
+MemSnapshot memSnapshot();
@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "sensors.h"
+
+// ===================================================
+// On-device metrics: latency histograms and counters
+// ===================================================
+// Always on and fixed size. Rendered in Prometheus text format on the local
+// HTTP server (GET /metrics) and by the "metrics" console command.
+
+// HDR-style log-linear histogram of microsecond values: each power of two
+// is split into 8 linear sub-buckets, so any recorded value is known to
+// within 12.5%. Covers 0 us .. ~134 s (larger values land in the top
+// bucket) in 208 counters, ~850 bytes.
+class LatencyHistogram {
+public:
+  static const int SUB_BITS = 3;
+  static const int SUB = 1 << SUB_BITS;
+  static const int MAX_EXP = 27;
+  static const int BUCKETS = (MAX_EXP - SUB_BITS + 2) * SUB;
+
+  void record(uint32_t us);
+  void reset();
+
+  uint32_t count() const { return n; }
+  uint64_t sumUs() const { return sum; }
+  uint32_t maxUs() const { return max; }
+  uint32_t countBelow(uint32_t us) const;  // recorded values < us (exact at powers of two)
+
+  static int bucketOf(uint32_t us);
+  static uint32_t bucketLow(int b);
+
+private:
+  uint32_t buckets[BUCKETS] = {};
+  uint32_t n = 0, max = 0;
+  uint64_t sum = 0;
+};
+
+struct Metrics {
+  LatencyHistogram loopUs;      // one scheduler pass that ran a job
+  LatencyHistogram postUs;      // whole httpPost(), connect included
+  LatencyHistogram connectUs;   // TCP connect + TLS handshake
+  LatencyHistogram pumpErrorUs; // pump on-time beyond the requested duration
+  LatencyHistogram sensorUs[SENSOR_COUNT];
+
+  uint32_t uplinks = 0;
+  uint32_t uplinksSuppressed = 0;    // frame inside the deadband, not sent
+  uint32_t uplinksDeferred = 0;      // due, but held back by pacing or the retry policy
+  uint32_t uplinkWindowsDropped = 0; // backlog full: oldest unsent window discarded
+  uint32_t uplinkFramesRejected = 0; // refused by the server (4xx), dropped
+  uint32_t httpTransportErrors = 0;  // no HTTP status at all
+  uint32_t httpStatusErrors = 0;     // 4xx / 5xx
+  uint32_t jsonParseErrors = 0;
+  uint32_t pushConnects = 0;         // push channel sessions established
+  uint32_t pushCommands = 0;         // command messages received on it
+  uint32_t coapRetransmits = 0;      // gateway transport: CON resends
+  uint32_t dnsLookups = 0;           // queries sent by the DNS cache
+  uint32_t dnsFailures = 0;          // ... that timed out or found nothing
+  uint32_t dnsFailovers = 0;         // cached address refused, moved to the next
+  uint32_t uplinkWarmups = 0;        // connections opened ahead of an upload
+  uint32_t localRequests = 0;        // requests served by local_http.cpp
+  uint32_t lockoutRejections = 0;    // dose requested while locked out
+  uint32_t doses = 0;
+};
+
+extern Metrics metrics;
+
+// Text sink for renderers: an HTTP reply, the serial console, ...
+struct MetricsOut {
+  void (*write)(void* ctx, const char* s, size_t n);
+  void* ctx;
+  void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+void metricsRender(MetricsOut& out);
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// Minimal MQTT 3.1.1 packet codec
+// ===================================================
+// QoS 0 only, which is all the push channel needs: commands are idempotent
+// (the latest one wins) and telemetry has its own heartbeat. Encoders write
+// one packet into a caller buffer and return its size (0 if it didn't fit).
+// Shared by the device (push.cpp) and the host stand-in broker
+// (tools/mqtt_bridge.cpp), which also uses the broker-side packets.
+
+enum MqttType : uint8_t {
+  MQTT_CONNECT = 1, MQTT_CONNACK, MQTT_PUBLISH, MQTT_PUBACK, MQTT_PUBREC, MQTT_PUBREL,
+  MQTT_PUBCOMP, MQTT_SUBSCRIBE, MQTT_SUBACK, MQTT_UNSUBSCRIBE, MQTT_UNSUBACK,
+  MQTT_PINGREQ, MQTT_PINGRESP, MQTT_DISCONNECT,
+};
+
+// -------- Client packets --------
+size_t mqttConnect(uint8_t* out, size_t cap, const char* clientId, uint16_t keepAliveS,
+                   const char* user = nullptr, const char* password = nullptr);
+size_t mqttSubscribe(uint8_t* out, size_t cap, uint16_t packetId, const char* topic);
+size_t mqttPublish(uint8_t* out, size_t cap, const char* topic, const uint8_t* payload, size_t len);
+size_t mqttPingReq(uint8_t* out, size_t cap);
+size_t mqttDisconnect(uint8_t* out, size_t cap);
+
+// -------- Broker packets --------
+size_t mqttConnAck(uint8_t* out, size_t cap, uint8_t returnCode);
+size_t mqttSubAck(uint8_t* out, size_t cap, uint16_t packetId);
+size_t mqttPingResp(uint8_t* out, size_t cap);
+
+// -------- Reading --------
+struct MqttPacket {
+  uint8_t type;         // MqttType
+  uint8_t flags;        // low nibble of the first byte
+  const uint8_t* body;  // variable header + payload
+  size_t len;
+};
+
+// Reassembles packets from a byte stream into a fixed buffer. Packets
+// larger than the buffer are skipped (and counted).
+class MqttReader {
+public:
+  MqttReader(uint8_t* buf, size_t cap) : buf(buf), cap(cap) {}
+
+  // Read from the socket into writePtr() (up to writeSpace()), then commit(n)
+  uint8_t* writePtr() { return buf + have; }
+  size_t writeSpace() const { return cap - have; }
+  void commit(size_t n);
+
+  // Next whole packet; valid until the following next()
+  bool next(MqttPacket& p);
+
+  void reset() { have = used = 0; skip = 0; }
+  uint32_t oversized() const { return dropped; }
+
+private:
+  uint8_t* buf;
+  size_t cap;
+  size_t have = 0;   // buffered bytes
+  size_t used = 0;   // bytes of the packet handed out last
+  size_t skip = 0;   // rest of an oversized packet still to discard
+  uint32_t dropped = 0;
+};
+
+// Topic and payload of a PUBLISH; false if malformed. The topic is not
+// NUL-terminated.
+bool mqttParsePublish(const MqttPacket& p, const char*& topic, size_t& topicLen,
+                      const uint8_t*& payload, size_t& len);
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// ===================================================
+// Noise-adaptive ADC oversampling
+// ===================================================
+// Instead of a fixed 10/30-sample average, each channel tracks its own sample
+// variance (Welford) and takes just enough samples to reach a target standard
+// error: N = sigma^2 / targetSE^2, clamped to [minN, maxN]. Bursts containing
+// spikes (> spikeK * sigma from the median) fall back to a trimmed mean.
+
+struct OversamplePolicy {
+  uint8_t  minN;
+  uint8_t  maxN;        // <= OVERSAMPLE_MAX_N
+  float    targetSE;    // millivolts
+  float    spikeK;      // spike threshold in sigmas
+  uint16_t spacingMs;   // gap between samples
+};
+
+const uint8_t OVERSAMPLE_MAX_N = 64;
+
+// Welford's online mean/variance
+struct Welford {
+  uint32_t n = 0;
+  float mean = 0, m2 = 0;
+
+  void reset() { n = 0; mean = 0; m2 = 0; }
+  void add(float x) {
+    n++;
+    float d = x - mean;
+    mean += d / n;
+    m2 += d * (x - mean);
+  }
+  float variance() const { return n > 1 ? m2 / (n - 1) : 0.0f; }
+};
+
+class AdaptiveOversampler {
+public:
+  AdaptiveOversampler(uint8_t pin, const OversamplePolicy& p) : pin(pin), pol(p) {}
+
+  // Take one adaptive burst and return the averaged calibrated millivolts.
+  // Each sample is linearised (LUT) before averaging.
+  float read();
+
+  uint8_t lastCount()   const { return lastN; }
+  bool    lastTrimmed() const { return trimmed; }
+  float   sigma()       const { return sqrtf(noiseVar); }
+  uint32_t spikeBursts() const { return spikes; }
+
+private:
+  uint8_t pin;
+  OversamplePolicy pol;
+  float    noiseVar = 0;     // smoothed per-sample variance across bursts
+  bool     hasNoise = false;
+  uint8_t  lastN = 0;
+  bool     trimmed = false;
+  uint32_t spikes = 0;
+
+  uint8_t samplesFor(float var) const;
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// Push channel: MQTT to a broker / gateway
+// ===================================================
+// A persistent connection so the server can push commands and profile
+// changes the moment they happen instead of waiting for the next upload
+// reply. Subscribes to planterbox/<device>/cmd, whose messages are the same
+// JSON as a POST reply; while it is up the uplink publishes frames to
+// planterbox/<device>/telemetry/{cbor,json} instead of POSTing them. When
+// the broker is unreachable everything falls back to HTTPS and the channel
+// retries with backoff. tools/mqtt_bridge.cpp is a stand-in broker that
+// forwards to /api/sensordata; any MQTT 3.1.1 broker (mosquitto) works too.
+
+void pushTick();
+bool pushUp();
+bool pushTelemetry(const uint8_t* payload, size_t len, bool cbor);
+
+void pushEnable(bool on);  // console "push"; off by default (PUSH_ENABLED)
+bool pushEnabled();
+const char* pushStateName();
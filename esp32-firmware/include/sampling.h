@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+
+// ===================================================
+// Per-sensor sampling policies
+// ===================================================
+// FIXED     : read every slowMs.
+// ADAPTIVE  : drop to fastMs while the value is moving by more than `delta`
+//             between reads or while the caller reports a transient (dose in
+//             progress, stepper moving); otherwise back off x2 up to slowMs.
+// ON_DEMAND : never scheduled; only read when someone asks for a sample.
+
+enum SampleMode : uint8_t { SAMPLE_FIXED, SAMPLE_ADAPTIVE, SAMPLE_ON_DEMAND };
+
+struct SamplingPolicy {
+  SampleMode mode;
+  uint32_t   slowMs;
+  uint32_t   fastMs;
+  float      delta;
+};
+
+class AdaptiveSampler {
+public:
+  AdaptiveSampler(const SamplingPolicy& p) { setPolicy(p); }
+
+  // Feed a fresh reading; returns the period until the next one (0 = on demand)
+  uint32_t update(float value, bool transient);
+
+  void setPolicy(const SamplingPolicy& p);
+  const SamplingPolicy& policy() const { return pol; }
+  uint32_t intervalMs() const { return interval; }
+
+private:
+  SamplingPolicy pol;
+  uint32_t interval = 0;
+  float    last = 0;
+  bool     hasLast = false;
+};
+
+const char* sampleModeName(SampleMode m);
+bool parseSampleMode(const char* s, SampleMode& out);
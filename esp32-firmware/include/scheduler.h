@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// Cooperative deadline scheduler
+// ===================================================
+// Replaces the old "run everything, then delay(100)" super-loop. Jobs are
+// declared in a compile-time table (see app.cpp); each has its own period,
+// a priority (0 = most urgent) and a time budget. runOnce() executes the most
+// urgent job whose deadline has passed, otherwise sleeps until the next one.
+// A period of 0 makes a job on-demand: it only runs after trigger().
+
+struct Job {
+  const char* name;
+  void (*fn)();
+  uint32_t periodMs;
+  uint8_t  priority;
+  uint32_t budgetUs;
+};
+
+struct JobStats {
+  uint32_t nextDueUs;
+  uint32_t lastStartUs;
+  uint32_t periodMs;     // runtime copy, may be retuned after boot
+  bool     dormant;      // on-demand job waiting for trigger()
+  uint32_t runs;
+  uint32_t overruns;     // runs that took longer than budgetUs
+  uint32_t missed;       // whole periods skipped because we fell behind
+  uint32_t lastRunUs;
+  uint32_t maxRunUs;
+  uint32_t maxJitterUs;  // start time minus deadline
+  uint64_t sumJitterUs;
+};
+
+class Scheduler {
+public:
+  Scheduler(const Job* jobs, JobStats* stats, size_t count)
+      : jobs(jobs), stats(stats), count(count) {}
+
+  void begin();
+  // Index of the job that ran, or -1 if nothing was due (we slept instead)
+  int runOnce();
+  void report() const;
+  void resetStats();
+
+  // Re-anchor a job's deadline to its last start with a new period
+  // (0 = on demand). Safe to call from inside the job itself.
+  void setPeriod(size_t id, uint32_t periodMs);
+  // Make a job due right now, regardless of its period
+  void trigger(size_t id);
+
+  const JobStats& statsFor(size_t id) const { return stats[id]; }
+
+private:
+  const Job* jobs;
+  JobStats*  stats;
+  size_t     count;
+};
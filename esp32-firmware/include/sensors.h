@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+
+// ===================================================
+// Sensor reading
+// ===================================================
+// Each read* function is a scheduler job: it samples one sensor, updates
+// latestFrame and reports the value through sampleDone().
+
+struct SensorFrame {
+  float temperature = 0;
+  float humidity = 0;
+  float distance = 0;
+  float ppm = 0;
+  float ph = 0;
+  bool  waterSufficient = false;
+};
+
+extern SensorFrame latestFrame;
+extern float currentTempC;
+extern float currentDistanceCm;
+extern unsigned long lastDistanceReadMs;
+
+enum SensorId { SENSOR_DHT, SENSOR_DISTANCE, SENSOR_PPM, SENSOR_PH, SENSOR_WATER, SENSOR_COUNT };
+
+void sensorsBegin();
+void readDHT();
+void readUltrasonic();
+void readPpmSensor();
+void readPhSensor();
+void readWaterSensor();
+
+// Sampling glue, implemented in app.cpp: lets the channel's sampling policy
+// retune the job period, request an immediate read, or go dense right now.
+void sampleDone(SensorId id, float value);
+void requestSample(SensorId id);
+void kickSampling(SensorId id);
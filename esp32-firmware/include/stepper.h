@@ -0,0 +1,38 @@
+#pragma once
+#include "hal.h"
+
+// ===================================================
+// Stepper class to simplify movement
+// ===================================================
+class Stepper28BYJ {
+private:
+  const uint8_t seq[8][4] = {
+    {1,0,0,0}, {1,1,0,0}, {0,1,0,0}, {0,1,1,0},
+    {0,0,1,0}, {0,0,1,1}, {0,0,0,1}, {1,0,0,1}
+  };
+  int stepIndex = 0;
+  int in1, in2, in3, in4;
+public:
+  Stepper28BYJ(int a, int b, int c, int d)
+      : in1(a), in2(b), in3(c), in4(d) {}
+  void begin() {
+    hal::pinOutput(in1);
+    hal::pinOutput(in2);
+    hal::pinOutput(in3);
+    hal::pinOutput(in4);
+    stop();
+  }
+  void stop() {
+    hal::digitalWrite(in1, false);
+    hal::digitalWrite(in2, false);
+    hal::digitalWrite(in3, false);
+    hal::digitalWrite(in4, false);
+  }
+  void step(bool clockwise) {
+    stepIndex = (stepIndex + (clockwise ? 1 : -1) + 8) % 8;
+    hal::digitalWrite(in1, seq[stepIndex][0]);
+    hal::digitalWrite(in2, seq[stepIndex][1]);
+    hal::digitalWrite(in3, seq[stepIndex][2]);
+    hal::digitalWrite(in4, seq[stepIndex][3]);
+  }
+};
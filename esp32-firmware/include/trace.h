@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// Phase tracing: binary records in a RAM ring buffer
+// ===================================================
+// A TRACE_SCOPE(id) times the rest of the enclosing block with hal::micros()
+// (esp_timer underneath on the ESP32) and appends one 8-byte record when it
+// closes. Scheduler jobs are recorded automatically as TRACE_JOB_BASE + job
+// index. Nothing is formatted on the device: traceDump() prints the raw
+// records as base64 lines between "[TRACE] begin" / "[TRACE] end" and
+// tools/trace_decode.cpp turns a captured log into per-phase histograms and
+// a timeline. Build with -DTRACE_ENABLED=0 to compile every scope out.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY 1024  // records, 8 bytes each
+#endif
+
+enum TracePhase : uint8_t {
+  TRACE_ADC_BURST,    // one oversampled ADC read
+  TRACE_ENCODE,       // frame -> request body
+  TRACE_CONNECT,      // TCP connect + TLS handshake
+  TRACE_POST,         // request out, response in
+  TRACE_PARSE,        // response JSON
+  TRACE_APPLY,        // light, sampling and dosing commands
+  TRACE_CONSOLE,      // serial command handling
+  TRACE_PHASE_COUNT,
+  TRACE_JOB_BASE = 32,  // + scheduler job index
+};
+
+// Wire format, little-endian: start time and a word holding the duration
+// (24 bits, saturating at ~16.7 s) under the phase id (top 8 bits).
+struct TraceRecord {
+  uint32_t startUs;
+  uint32_t durAndId;
+};
+
+const uint32_t TRACE_MAX_DUR_US = 0xFFFFFF;
+
+inline uint32_t tracePack(uint8_t id, uint32_t durUs) {
+  return (durUs > TRACE_MAX_DUR_US ? TRACE_MAX_DUR_US : durUs) | ((uint32_t)id << 24);
+}
+inline uint8_t  traceId(const TraceRecord& r)    { return r.durAndId >> 24; }
+inline uint32_t traceDurUs(const TraceRecord& r) { return r.durAndId & TRACE_MAX_DUR_US; }
+
+void traceRecord(uint8_t id, uint32_t startUs, uint32_t durUs);
+void traceSetName(uint8_t id, const char* name);  // shown by the decoder
+void traceEnable(bool on);
+void traceSetMinUs(uint32_t us);  // drop shorter records (default 50 us)
+void traceClear();
+void traceDump();
+
+#if TRACE_ENABLED
+#include "hal.h"
+
+class TraceScope {
+public:
+  explicit TraceScope(uint8_t id) : id(id), t0(hal::micros()) {}
+  ~TraceScope() { traceRecord(id, t0, hal::micros() - t0); }
+private:
+  uint8_t  id;
+  uint32_t t0;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(id) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(id)
+#else
+#define TRACE_SCOPE(id) do {} while (0)
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+#include <stddef.h>
+#include "sensors.h"
+#include "memstats.h"
+#include "arena.h"
+#include "aggregate.h"
+#include "uplink_policy.h"
+
+// ===================================================
+// Uplink: send latest readings, apply returned commands
+// ===================================================
+struct DeviceCommands {
+  int  light = 0;
+  bool phUp = false, phDown = false, ppmA = false, ppmB = false;
+  unsigned long lockoutMs = 120000UL;
+  unsigned long doseMs = 0;  // optional pump run time; 0 runs dosingDuration
+};
+
+// Which frame this is: (device, session, seq) is unique, so the server can
+// drop one it already stored when a retry repeats it (a POST that timed
+// out after the server had it). A queued window keeps its seq until
+// delivered; a live frame that failed is superseded by the next one.
+struct FrameId {
+  const char* device;  // deviceId() on the device
+  uint32_t session;    // random per boot
+  uint32_t seq;        // per frame since boot, from 1
+};
+
+// Device health sent along with each frame
+struct DeviceHealth {
+  MemSnapshot mem;
+  uint32_t allocs;  // heap allocations since the previous uplink
+};
+
+// -------- Wire formats --------
+// JSON (application/json) spells the keys out. CBOR (application/cbor)
+// uses the small integer keys below, and the server maps them back
+// (src/app/api/sensordata/telemetry.js): keep the tables in sync. A CBOR
+// body is one frame map or an array of them.
+enum FrameKey : uint8_t {
+  FK_TEMPERATURE = 1, FK_HUMIDITY, FK_DISTANCE, FK_PPM, FK_PH, FK_WATER_SUFFICIENT,
+  FK_MEM,     // map of MemKey
+  FK_AGE_MS,  // how long before the upload the frame was taken (batches, windows)
+  FK_WINDOW_MS,                // window summaries: window length; the sensor
+  FK_MIN, FK_MAX, FK_COUNT,    // fields hold the means, these maps of FrameKey the rest
+  FK_DEVICE_ID, FK_FW,         // text: who sent it and what it runs
+  FK_SESSION, FK_SEQ,          // FrameId
+};
+enum MemKey : uint8_t { MK_FREE = 1, MK_LARGEST, MK_MIN_FREE, MK_FRAG, MK_STACK, MK_ALLOCS };
+
+// Frame (+ optional window stats and health) -> body, tagged with its
+// FrameId and FIRMWARE_VERSION; returns bytes written (0 if it didn't fit)
+size_t encodeFrameJson(const SensorFrame& f, const WindowSummary* window, const DeviceHealth* health,
+                       const FrameId& id, char* out, size_t cap);
+size_t encodeFrameCbor(const SensorFrame& f, const WindowSummary* window, const DeviceHealth* health,
+                       const FrameId& id, uint8_t* out, size_t cap);
+// Sensor fields of one CBOR frame map (host side: simulator, tools)
+bool decodeFrameCbor(const uint8_t* in, size_t len, SensorFrame& f);
+
+// -------- Upload modes --------
+// RAW      : every frame, every UPLINK_INTERVAL_MS (debugging)
+// DEADBAND : frames outside the deadband, plus the heartbeat
+// WINDOW   : one min/max/mean summary per UPLINK_WINDOW_MS; a backlog goes
+//            out UPLINK_BATCH_MAX at a time over HTTPS
+enum UplinkMode : uint8_t { UPLINK_RAW, UPLINK_DEADBAND, UPLINK_WINDOW };
+
+UplinkMode uplinkMode();
+void setUplinkMode(UplinkMode m);  // console "uplink", or the server's {"uplink":{...}}
+const char* uplinkModeName(UplinkMode m);
+bool parseUplinkMode(const char* s, UplinkMode& out);
+int uplinkPendingWindows();
+
+void uplinkObserve(SensorId id);  // a sensor job just updated latestFrame
+void uplinkTick();
+// Apply a server reply received outside the uplink cycle (push channel)
+void uplinkApplyCommands(const char* json, size_t len);
+const Arena& uplinkArena();  // for metrics
+const UplinkPolicy& uplinkPolicy();  // backoff / breaker state, for metrics and the console
+const UploadPacer& uplinkPacer();    // current upload gap and what it's based on
@@ -0,0 +1,148 @@
+#pragma once
+#include <stdint.h>
+
+// ===================================================
+// Uplink policy: retry backoff, circuit breaker, pacing
+// ===================================================
+// Decides when the uplink may try the server again. A failed exchange (no
+// HTTP status, 429 or 5xx) holds the next one back for a delay that starts
+// at retryMin and doubles up to retryMax; `breakerFailures` in a row open
+// the breaker, and nothing is tried for the cool-down. After it the next
+// attempt is a probe: success closes the breaker, failure opens it again.
+// Every wait is jittered (x0.5-1), so a fleet that lost the server at the
+// same moment doesn't come back to it in lockstep.
+// Attempts are blocking and one at a time, so "one probe" needs no
+// bookkeeping: a half-open breaker simply allows the next attempt.
+
+enum BreakerState : uint8_t { BREAKER_CLOSED, BREAKER_OPEN, BREAKER_HALF_OPEN };
+
+class UplinkPolicy {
+public:
+  UplinkPolicy(uint32_t retryMinMs, uint32_t retryMaxMs, int breakerFailures, uint32_t cooldownMs)
+      : retryMin(retryMinMs), retryMax(retryMaxMs), maxFailures(breakerFailures), cooldown(cooldownMs) {}
+
+  // Is an attempt allowed now? Ends the cool-down of an open breaker.
+  bool mayAttempt(uint32_t nowMs) {
+    if (!waiting || (int32_t)(nowMs - retryAt) >= 0) {
+      if (breaker == BREAKER_OPEN) breaker = BREAKER_HALF_OPEN;
+      waiting = false;
+      return true;
+    }
+    return false;
+  }
+
+  // The server answered (any status it isn't asking us to back off for)
+  void succeeded() {
+    failures = 0;
+    waiting = false;
+    breaker = BREAKER_CLOSED;
+  }
+
+  // It didn't. `random` is any 32 random bits, for the jitter.
+  void failed(uint32_t nowMs, uint32_t random) {
+    if (failures < 0x7fff) failures++;
+    uint32_t wait;
+    if (breaker == BREAKER_HALF_OPEN || failures >= maxFailures) {
+      if (breaker != BREAKER_OPEN) opened++;
+      breaker = BREAKER_OPEN;
+      wait = cooldown;
+    } else {
+      int doublings = failures - 1 < 16 ? failures - 1 : 16;
+      wait = retryMin << doublings;
+      if (wait > retryMax || wait < retryMin) wait = retryMax;
+    }
+    wait = wait / 2 + random % (wait / 2 + 1);
+    retryAt = nowMs + wait;
+    waiting = true;
+  }
+
+  // Failure statuses: transport errors, rate limiting, server trouble.
+  // Other 4xx mean the server is there and refused this body; retrying
+  // sooner or later won't change that.
+  static bool serverFailure(int code) { return code <= 0 || code == 429 || code >= 500; }
+
+  BreakerState state() const { return breaker; }
+  int consecutiveFailures() const { return failures; }
+  uint32_t opens() const { return opened; }
+  uint32_t waitMs(uint32_t nowMs) const {
+    return waiting && (int32_t)(retryAt - nowMs) > 0 ? retryAt - nowMs : 0;
+  }
+
+private:
+  uint32_t retryMin, retryMax;
+  int maxFailures;
+  uint32_t cooldown;
+  BreakerState breaker = BREAKER_CLOSED;
+  int failures = 0;
+  bool waiting = false;
+  uint32_t retryAt = 0;
+  uint32_t opened = 0;
+};
+
+// -------- Pacing --------
+// The least time between uploads. The server can set it in any reply
+// (next_upload_ms, with batch_hint for windows per upload) to shed load
+// across the fleet; a reply without it hands pacing back to the device,
+// which stretches the gap in proportion to round trips beyond slowRtt, and
+// by another base length for every 25% of recent uploads that failed.
+// While dosing it uploads at the base rate regardless: the readings right
+// after a dose are what the next decision is made on.
+class UploadPacer {
+public:
+  UploadPacer(uint32_t baseMs, uint32_t maxMs, uint32_t slowRttMs)
+      : base(baseMs), max(maxMs), slowRtt(slowRttMs) {}
+
+  // From a server reply; 0 = no hint
+  void hint(uint32_t gapMs, int batch) {
+    serverGap = gapMs && gapMs < base ? base : gapMs > max ? max : gapMs;
+    serverBatch = batch > 0 ? batch : 0;
+  }
+
+  // After every exchange with the server
+  void observe(bool ok, uint32_t rttMs) {
+    if (ok) srtt = srtt ? srtt + ((int32_t)rttMs - (int32_t)srtt) / 8 : rttMs;
+    errPermille += ((ok ? 0 : 1000) - errPermille) / 8;  // about the last eight
+  }
+
+  uint32_t gapMs(bool dense) const {
+    if (dense) return base;
+    if (serverGap) return serverGap;
+    uint64_t gap = base;
+    if (srtt > slowRtt) gap = gap * srtt / slowRtt;
+    gap = gap * (1000 + 4 * errPermille) / 1000;
+    return gap < max ? (uint32_t)gap : max;
+  }
+
+  // Checked once per uplink tick (every `base`), so a base-length gap is
+  // always over: tick jitter mustn't turn it into two
+  uint32_t waitMs(uint32_t nowMs, bool dense) const {
+    uint32_t gap = gapMs(dense);
+    if (gap <= base || !started || nowMs - lastMs >= gap) return 0;
+    return gap - (nowMs - lastMs);
+  }
+  bool due(uint32_t nowMs, bool dense) const { return !waitMs(nowMs, dense); }
+  void attempted(uint32_t nowMs) { lastMs = nowMs; started = true; }
+
+  int batch(int maxBatch) const { return serverBatch && serverBatch < maxBatch ? serverBatch : maxBatch; }
+  bool serverPaced() const { return serverGap != 0; }
+  uint32_t srttMs() const { return srtt; }
+  int errorPermille() const { return errPermille; }
+
+private:
+  uint32_t base, max, slowRtt;
+  uint32_t serverGap = 0;
+  int serverBatch = 0;
+  uint32_t srtt = 0;
+  int32_t errPermille = 0;
+  uint32_t lastMs = 0;
+  bool started = false;
+};
+
+inline const char* breakerStateName(BreakerState s) {
+  switch (s) {
+    case BREAKER_CLOSED:    return "closed";
+    case BREAKER_OPEN:      return "open";
+    case BREAKER_HALF_OPEN: return "half-open";
+  }
+  return "?";
+}
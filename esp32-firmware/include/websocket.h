@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ===================================================
+// Minimal WebSocket (RFC 6455) server side
+// ===================================================
+// Enough for the live dashboard stream: the upgrade handshake, unmasked
+// server frames and parsing of the (masked) control frames a browser
+// sends back. No fragmentation, no extensions. Runs over any byte stream;
+// local_http.cpp uses the HAL's detached sockets.
+
+enum WsOpcode : uint8_t { WS_TEXT = 0x1, WS_BINARY = 0x2, WS_CLOSE = 0x8, WS_PING = 0x9, WS_PONG = 0xA };
+
+// Sec-WebSocket-Accept for a client's Sec-WebSocket-Key (28 chars + NUL)
+void wsAcceptKey(const char* clientKey, char out[29]);
+
+// One final frame; returns bytes written (0 if it didn't fit)
+size_t wsFrame(uint8_t* out, size_t cap, uint8_t opcode, const void* payload, size_t len);
+
+// Next complete client frame in buf[0..have): unmasks the payload in place
+// and returns the frame's total size, 0 if incomplete, -1 if malformed
+// (unmasked, or larger than the buffer could ever hold).
+int wsParse(uint8_t* buf, size_t have, size_t cap, uint8_t& opcode, uint8_t*& payload, size_t& len);
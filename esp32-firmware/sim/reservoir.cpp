@@ -0,0 +1,101 @@
+#include "reservoir.h"
+#include <math.h>
+#include <algorithm>
+
+// Inverse of the firmware calibrations in sensors.cpp
+static const float PH_SLOPE = -9.76f, PH_INTERCEPT = 19.45f;
+static const float PPM_PER_VOLT = 420.0f;
+
+Reservoir::Reservoir(const ReservoirParams& params, float ph0, float ppm0,
+                     float distance0, uint32_t seed)
+    : p(params), rng(seed) {
+  st.ph = ph0;
+  st.ppm = ppm0;
+  st.volumeL = p.volumeL;
+  st.distanceCm = distance0;
+}
+
+float Reservoir::phGainPerMl() const {
+  // Buffering is strongest at the pKa and fades either side of it
+  float away = fabsf(st.ph - p.bufferPka) / p.bufferWidth;
+  return p.phPerMl * (1.0f + away) / st.volumeL;
+}
+
+void Reservoir::step(float dtS, bool phUp, bool phDown, bool ppmA, bool ppmB,
+                     float lamp, float hourOfDay) {
+  const float day = dtS / 86400.0f;
+
+  // -------- Doses enter the plume --------
+  float ml = p.pumpMlPerS * dtS;
+  if (phUp)   { st.plumePh += phGainPerMl() * ml; st.phUpMl += ml; }
+  if (phDown) { st.plumePh -= phGainPerMl() * ml; st.phDownMl += ml; }
+  int nutrientPumps = (ppmA ? 1 : 0) + (ppmB ? 1 : 0);
+  if (nutrientPumps) {
+    float nml = ml * nutrientPumps;
+    st.plumeMg += p.nutrientMgPerMl * nml;
+    st.plumePh += p.nutrientPhPerMl * nml / st.volumeL;
+    st.nutrientMl += nml;
+  }
+
+  // -------- Plume blends into the bulk --------
+  float mix = 1.0f - expf(-dtS / p.mixTauS);
+  st.ph += st.plumePh * mix;  st.plumePh -= st.plumePh * mix;
+  float mg = st.plumeMg * mix; st.plumeMg -= mg;
+  st.ppm += mg / st.volumeL;
+
+  // -------- Uptake and drift (lamp on = plants working) --------
+  float mass = st.ppm * st.volumeL;
+  mass -= p.uptakePpmPerDay * p.volumeL * lamp * day;
+  st.ph += p.phDriftPerDay * lamp * day;
+
+  // -------- Evaporation concentrates, top-up dilutes --------
+  float evap = p.evapLPerDay * day * std::max(0.2f, 1.0f + 0.05f * (st.tempC - 22.0f));
+  st.volumeL -= evap;
+  if (st.volumeL < p.volumeL * p.topUpFraction) {
+    float add = p.volumeL - st.volumeL;
+    mass += p.tapPpm * add;
+    st.ph = (st.ph * st.volumeL + p.tapPh * add) / p.volumeL;
+    st.volumeL = p.volumeL;
+    st.topUps++;
+  }
+  st.ppm = std::max(0.0f, mass / st.volumeL);
+  st.ph = std::min(std::max(st.ph, 2.0f), 12.0f);
+
+  // -------- Air, water temperature, canopy --------
+  float diurnal = sinf((hourOfDay - 9.0f) / 24.0f * 2.0f * (float)M_PI);
+  st.tempC = 21.0f + 2.5f * diurnal + 1.5f * lamp;
+  st.humidity = 62.0f - 8.0f * diurnal - 3.0f * lamp;
+  st.waterC += (st.tempC - 1.0f - st.waterC) * std::min(1.0f, dtS / 3600.0f);
+  st.distanceCm -= p.growthCmPerDay * day;
+}
+
+float Reservoir::sensedPh() const { return st.ph + p.probePlume * st.plumePh; }
+
+float Reservoir::sensedPpm() const {
+  return st.ppm + p.probePlume * st.plumeMg / st.volumeL;
+}
+
+float Reservoir::noisy(float mv, float sigma) {
+  mv += sigma * gauss(rng);
+  if (uni(rng) < p.spikeRate) mv += (uni(rng) < 0.5f ? -1.0f : 1.0f) * (150.0f + 250.0f * uni(rng));
+  return std::min(std::max(mv, 0.0f), 3300.0f);
+}
+
+float Reservoir::phProbeMv() {
+  return noisy((sensedPh() - PH_INTERCEPT) / PH_SLOPE * 1000.0f, p.phNoiseMv);
+}
+
+float Reservoir::ppmProbeMv() {
+  // The probe responds to water temperature; the firmware compensates with
+  // air temperature from the DHT, so some error is expected and intended.
+  float comp = 1.0f + 0.02f * (st.waterC - 25.0f);
+  return noisy(sensedPpm() * comp / PPM_PER_VOLT * 1000.0f, p.ppmNoiseMv);
+}
+
+float Reservoir::waterLevelMv() const {
+  return 3000.0f * std::min(1.0f, st.volumeL / p.volumeL);
+}
+
+uint32_t Reservoir::echoUs() const {
+  return (uint32_t)lroundf(std::max(0.0f, st.distanceCm) * 2.0f / 0.034f);
+}
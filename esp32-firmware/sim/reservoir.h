@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include <random>
+
+// ===================================================
+// Reservoir plant model for the simulator
+// ===================================================
+// Lumped model of a ~20 L nutrient reservoir, the grow lamp and the air:
+//  - Doses land in an unmixed plume that blends into the bulk with a first
+//    order lag; the probes sit near the inlet and see part of the plume.
+//  - pH: acid/base effect per mL scales with 1/volume and is strongest far
+//    from the buffer's pKa. Uptake drifts pH up; nutrient doses pull it down.
+//  - PPM: salt mass over volume. Plants take mass up while the lamp is on,
+//    evaporation concentrates it, top-ups with tap water dilute it.
+//  - Air temperature/humidity follow a daily cycle plus lamp heat.
+//  - The plants grow towards the lamp; the stepper raises/lowers it.
+// Everything the firmware sees goes through hal::native with sensor noise
+// and the odd spike, using the inverse of the firmware's own calibrations.
+
+struct ReservoirParams {
+  float volumeL       = 20.0f;
+  float tapPh         = 7.6f;
+  float tapPpm        = 120.0f;
+  float topUpFraction = 0.8f;    // refill to volumeL below this fraction
+
+  float pumpMlPerS    = 1.5f;    // each peristaltic pump
+  float phPerMl       = 0.9f;    // pH change per mL in 1 L at the pKa
+  float bufferPka     = 6.4f;
+  float bufferWidth   = 0.6f;    // effect doubles this far from the pKa
+  float nutrientMgPerMl = 100.0f;    // A and B concentrate, mg TDS per mL
+  float nutrientPhPerMl = -0.08f;    // acidifying side effect, per mL in 1 L
+
+  float mixTauS       = 90.0f;   // plume -> bulk time constant
+  float probePlume    = 0.3f;    // share of the unmixed plume the probes see
+
+  float uptakePpmPerDay = 60.0f; // at 20 L, while the lamp is on
+  float phDriftPerDay   = 0.25f; // upward drift from nitrate uptake
+  float evapLPerDay     = 0.6f;
+  float growthCmPerDay  = 0.5f;  // canopy rising towards the lamp
+  float cmPerStep       = 0.01f; // lamp travel per stepper half-step
+
+  float phNoiseMv  = 3.0f;
+  float ppmNoiseMv = 6.0f;
+  float spikeRate  = 0.002f;     // per ADC sample
+};
+
+struct ReservoirState {
+  float ph, ppm;          // well-mixed bulk
+  float plumePh = 0, plumeMg = 0;  // dosed but not yet mixed
+  float volumeL;
+  float distanceCm;
+  float tempC = 22.0f, humidity = 60.0f;
+  float waterC = 21.0f;
+  uint32_t topUps = 0;
+  float phUpMl = 0, phDownMl = 0, nutrientMl = 0;
+};
+
+class Reservoir {
+public:
+  Reservoir(const ReservoirParams& p, float ph0, float ppm0, float distance0, uint32_t seed);
+
+  // Integrate dtS seconds with the given pump states and lamp duty (0..1)
+  void step(float dtS, bool phUp, bool phDown, bool ppmA, bool ppmB, float lamp,
+            float hourOfDay);
+  void moveLamp(int steps) { st.distanceCm += steps * p.cmPerStep; }
+
+  // What the probes and sensors read right now (noise included)
+  float phProbeMv();
+  float ppmProbeMv();
+  float waterLevelMv() const;
+  uint32_t echoUs() const;
+
+  const ReservoirState& state() const { return st; }
+  float sensedPh() const;   // bulk plus the plume share the probe sees
+  float sensedPpm() const;
+
+private:
+  float phGainPerMl() const;
+  float noisy(float mv, float sigma);
+
+  ReservoirParams p;
+  ReservoirState st;
+  std::mt19937 rng;
+  std::normal_distribution<float> gauss{0.0f, 1.0f};
+  std::uniform_real_distribution<float> uni{0.0f, 1.0f};
+};
@@ -0,0 +1,337 @@
+// ===================================================
+// Reservoir simulator: the firmware on a virtual clock
+// ===================================================
+//   pio run -e sim && .pio/build/sim/program [days] [policy] [seed]
+//
+// Runs the unmodified app (scheduler, sampling, dosing, uplink) against
+// hal_native's virtual clock and a modelled reservoir (reservoir.h). Uplinks
+// go to an in-process stand-in for the server's decision in
+// backendLogic.js, one dosing policy per forked child, so every policy
+// starts from the same boot state. Reported per policy, on the true bulk
+// values rather than what the probes saw:
+//   t->band   : time until the value first enters the target band
+//   doses     : pump starts (pH up/down, nutrient A->B sequences)
+//   overshoot : worst excursion past the far edge of the band after a dose
+//   in-band   : share of time inside the band after first reaching it
+// Then "open-probe": the pH probe unplugged on a chip whose ADC calibration
+// floors at ESP32-like 142 mV, with everything else in band. The firmware
+// must report no signal (pH 0) and nothing may dose on it.
+
+#include "app.h"
+#include "config.h"
+#include "hal.h"
+#include "hal_native.h"
+#include "reservoir.h"
+#include "uplink.h"
+#include <ArduinoJson.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// -------- Scenario --------
+// Fresh tap-water reservoir, canopy too close to the lamp, lettuce-like
+// targets. The clock starts at 06:00 when the lamp schedule begins.
+static const float PH_MIN = 5.8f, PH_MAX = 6.3f;
+static const float PPM_MIN = 800.0f, PPM_MAX = 1100.0f;
+static const float START_PH = 7.4f, START_PPM = 300.0f, START_DISTANCE_CM = 22.0f;
+static const float LIGHT_HOURS = 16.0f, LIGHT_START_HOUR = 6.0f;
+static const uint32_t SERVER_RTT_MS = 400;  // TLS handshake + POST on the real link
+static const float OPEN_PROBE_OFFSET_MV = 142.0f, OPEN_PROBE_MV_PER_COUNT = 0.78f;
+static const double OPEN_PROBE_DAYS = 2.0 / 24;
+
+// -------- Dosing policies (the server's side of the loop) --------
+// The firmware owns pump timing and lockout; a policy only chooses what the
+// server answers. "bangbang" is what backendLogic.js does today. The
+// proportional policies size dose_ms from the distance to the band centre
+// using a nominal gain for a 20 L reservoir, and only correct part of it.
+struct Policy {
+  const char* name;
+  unsigned long lockoutMs;
+  bool proportional;
+};
+
+static const Policy POLICIES[] = {
+  { "bangbang",     120000, false },  // fixed 2 s dose, 2 min settle
+  { "settle",       360000, false },  // fixed dose, wait ~4 mixing time constants
+  { "proportional", 360000, true  },
+  { "prop-fast",    120000, true  },
+};
+static const int POLICY_COUNT = sizeof(POLICIES) / sizeof(POLICIES[0]);
+
+static const float NOMINAL_PH_PER_S  = 0.07f;  // pH per pump-second
+static const float NOMINAL_PPM_PER_S = 15.0f;  // ppm per second of A and of B
+static const float PROPORTIONAL_SHARE = 0.6f;
+static const unsigned long MIN_DOSE_MS = 250;
+
+// -------- Results --------
+struct ChannelStats {
+  double firstInBandS = -1;
+  double inBandS = 0, afterFirstS = 0;
+  float  overshoot = 0;
+};
+
+struct Result {
+  ChannelStats ph, ppm;
+  uint32_t phUpDoses = 0, phDownDoses = 0, nutrientDoses = 0;
+  float reagentMl = 0;
+  uint32_t topUps = 0, uplinks = 0;
+  double lampInRangeS = 0;
+  float finalPh = 0, finalPpm = 0;
+  float sentPh = 0;  // last pH the firmware uploaded
+  double wallS = 0;
+};
+
+// -------- Simulation state --------
+static Reservoir* res;
+static const Policy* policy;
+static bool openProbe;
+static Result result;
+static uint64_t simUs;
+static int stepperIndex = 0;
+static int lastPhDir = 0;
+static bool nutrientDosed = false;
+static bool prevPhUp, prevPhDown, prevPpmA;
+
+static const uint8_t STEPPER_SEQ[8][4] = {
+  {1,0,0,0}, {1,1,0,0}, {0,1,0,0}, {0,1,1,0},
+  {0,0,1,0}, {0,0,1,1}, {0,0,0,1}, {1,0,0,1}
+};
+
+static float hourOfDay(uint64_t us) {
+  return fmodf(LIGHT_START_HOUR + (float)(us / 1e6 / 3600.0), 24.0f);
+}
+
+// Follow the ULN2003 coil pattern; one sequence position is a half-step
+static void trackStepper() {
+  bool in[4] = { hal::native::pinLevel(MOTOR_IN1), hal::native::pinLevel(MOTOR_IN2),
+                 hal::native::pinLevel(MOTOR_IN3), hal::native::pinLevel(MOTOR_IN4) };
+  for (int i = 0; i < 8; i++) {
+    if (in[0] != STEPPER_SEQ[i][0] || in[1] != STEPPER_SEQ[i][1] ||
+        in[2] != STEPPER_SEQ[i][2] || in[3] != STEPPER_SEQ[i][3]) continue;
+    int diff = (i - stepperIndex + 8) % 8;
+    if (diff == 1) res->moveLamp(+1);       // clockwise raises the lamp
+    else if (diff == 7) res->moveLamp(-1);
+    stepperIndex = i;
+    return;
+  }
+}
+
+static void track(ChannelStats& c, float v, float lo, float hi, double dtS) {
+  bool in = v >= lo && v <= hi;
+  if (c.firstInBandS < 0 && in) c.firstInBandS = simUs / 1e6;
+  if (c.firstInBandS >= 0) {
+    c.afterFirstS += dtS;
+    if (in) c.inBandS += dtS;
+  }
+}
+
+// Pins are constant between two clock advances, so integrating with the
+// levels seen now is exact for the interval that just passed.
+static void onAdvance(uint64_t nowUs) {
+  const uint64_t MAX_STEP_US = 100000;
+  bool phUp = hal::native::pinLevel(PH_UP_PUMP_PIN), phDown = hal::native::pinLevel(PH_DOWN_PUMP_PIN);
+  bool ppmA = hal::native::pinLevel(PPM_A_PUMP_PIN), ppmB = hal::native::pinLevel(PPM_B_PUMP_PIN);
+  float lamp = hal::native::pwmDuty(ledChannel) / 255.0f;
+
+  if (phUp && !prevPhUp)     { result.phUpDoses++;   lastPhDir = +1; }
+  if (phDown && !prevPhDown) { result.phDownDoses++; lastPhDir = -1; }
+  if (ppmA && !prevPpmA)     { result.nutrientDoses++; nutrientDosed = true; }
+  prevPhUp = phUp; prevPhDown = phDown; prevPpmA = ppmA;
+
+  while (simUs < nowUs) {
+    uint64_t h = nowUs - simUs < MAX_STEP_US ? nowUs - simUs : MAX_STEP_US;
+    double dtS = h / 1e6;
+    res->step((float)dtS, phUp, phDown, ppmA, ppmB, lamp, hourOfDay(simUs));
+    simUs += h;
+
+    const ReservoirState& s = res->state();
+    track(result.ph, s.ph, PH_MIN, PH_MAX, dtS);
+    track(result.ppm, s.ppm, PPM_MIN, PPM_MAX, dtS);
+    if (lastPhDir < 0 && s.ph < PH_MIN) result.ph.overshoot = fmaxf(result.ph.overshoot, PH_MIN - s.ph);
+    if (lastPhDir > 0 && s.ph > PH_MAX) result.ph.overshoot = fmaxf(result.ph.overshoot, s.ph - PH_MAX);
+    if (nutrientDosed && s.ppm > PPM_MAX) result.ppm.overshoot = fmaxf(result.ppm.overshoot, s.ppm - PPM_MAX);
+    if (s.distanceCm >= TARGET_MIN_CM && s.distanceCm <= TARGET_MAX_CM) result.lampInRangeS += dtS;
+  }
+
+  trackStepper();
+  hal::native::setAdcMilliVolts(PH_SENSOR_PIN, openProbe ? 0 : (uint16_t)lroundf(res->phProbeMv()));
+  hal::native::setAdcMilliVolts(PPM_SENSOR_PIN, (uint16_t)lroundf(res->ppmProbeMv()));
+  hal::native::setAdcMilliVolts(WATER_SENSOR_PIN, (uint16_t)lroundf(res->waterLevelMv()));
+  hal::native::setEchoPulseUs(ECHO_PIN, res->echoUs());
+  hal::native::setDht(res->state().tempC, res->state().humidity);
+}
+
+// Same curve as computeDaylightPWM() in backendLogic.js (60 min ramps)
+static int daylightPwm(float hour) {
+  float sinceStart = fmodf(hour - LIGHT_START_HOUR + 24.0f, 24.0f) * 60.0f;
+  float untilEnd = LIGHT_HOURS * 60.0f - sinceStart;
+  if (untilEnd <= 0) return 0;
+  auto ease = [](float x) { return 0.5f - 0.5f * cosf(fminf(fmaxf(x, 0.0f), 1.0f) * (float)M_PI); };
+  if (sinceStart < 60.0f) return (int)lroundf(255 * ease(sinceStart / 60.0f));
+  if (untilEnd < 60.0f)   return (int)lroundf(255 * ease(untilEnd / 60.0f));
+  return 255;
+}
+
+static unsigned long proportionalDoseMs(float error, float perSecond) {
+  float ms = PROPORTIONAL_SHARE * fabsf(error) / perSecond * 1000.0f;
+  if (ms < MIN_DOSE_MS) ms = MIN_DOSE_MS;
+  if (ms > MAX_DOSE_MS) ms = MAX_DOSE_MS;
+  return (unsigned long)ms;
+}
+
+static int serverStandIn(const char*, const char* contentType, const uint8_t* body, size_t len,
+                         char* resp, size_t respCap) {
+  hal::native::advanceClock(SERVER_RTT_MS * 1000ULL);
+  result.uplinks++;
+
+  float ph = NAN, ppm = NAN;
+  if (!strcmp(contentType, "application/cbor")) {
+    SensorFrame f;
+    f.ph = f.ppm = NAN;
+    if (!decodeFrameCbor(body, len, f)) return 400;
+    ph = f.ph;
+    ppm = f.ppm;
+  } else {
+    JsonDocument doc;
+    if (deserializeJson(doc, (const char*)body, len)) return 400;
+    ph = doc["ph"] | NAN;
+    ppm = doc["ppm"] | NAN;
+  }
+
+  result.sentPh = ph;
+
+  // One action per tick, pH first (processSensorData); pH 0 is "no signal"
+  bool phValid = ph > 0;
+  bool phUp = phValid && ph < PH_MIN, phDown = phValid && ph > PH_MAX;
+  bool nutrients = !phUp && !phDown && ppm < PPM_MIN;
+  unsigned long lockoutMs = (phUp || phDown || nutrients) ? policy->lockoutMs : 0;
+  unsigned long doseMs = 0;
+  if (policy->proportional) {
+    if (phUp || phDown) doseMs = proportionalDoseMs((PH_MIN + PH_MAX) / 2 - ph, NOMINAL_PH_PER_S);
+    else if (nutrients) doseMs = proportionalDoseMs((PPM_MIN + PPM_MAX) / 2 - ppm, NOMINAL_PPM_PER_S);
+  }
+
+  snprintf(resp, respCap,
+           "{\"light\":%d,\"ph_up_pump\":%s,\"ph_down_pump\":%s,\"ppm_a_pump\":%s,"
+           "\"ppm_b_pump\":%s,\"lockout_ms\":%lu,\"dose_ms\":%lu}",
+           daylightPwm(hourOfDay(hal::native::clockUs())),
+           phUp ? "true" : "false", phDown ? "true" : "false",
+           nutrients ? "true" : "false", nutrients ? "true" : "false",
+           lockoutMs, doseMs);
+  return 200;
+}
+
+static Result runPolicy(const Policy& p, double days, uint32_t seed, bool probeOpen = false) {
+  // The open-probe run starts with everything in band, so any dose is the probe's
+  Reservoir reservoir(ReservoirParams(), probeOpen ? (PH_MIN + PH_MAX) / 2 : START_PH,
+                      probeOpen ? (PPM_MIN + PPM_MAX) / 2 : START_PPM, START_DISTANCE_CM, seed);
+  res = &reservoir;
+  policy = &p;
+  openProbe = probeOpen;
+  if (probeOpen) hal::native::setAdcCalibration(OPEN_PROBE_OFFSET_MV, OPEN_PROBE_MV_PER_COUNT);
+
+  auto wallStart = std::chrono::steady_clock::now();
+  hal::native::setConsoleMuted(true);
+  hal::native::useVirtualClock(onAdvance);
+  hal::native::setHttpHandler(serverStandIn);
+  simUs = hal::native::clockUs();
+  onAdvance(simUs);  // sensors read the model from the first boot sample on
+
+  uint64_t endUs = simUs + (uint64_t)(days * 86400e6);
+  appSetup();
+  while (hal::native::clockUs() < endUs) appLoop();
+
+  result.reagentMl = reservoir.state().phUpMl + reservoir.state().phDownMl + reservoir.state().nutrientMl;
+  result.topUps = reservoir.state().topUps;
+  result.finalPh = reservoir.state().ph;
+  result.finalPpm = reservoir.state().ppm;
+  result.wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  return result;
+}
+
+static void formatDuration(char* out, size_t cap, double s) {
+  if (s < 0) snprintf(out, cap, "never");
+  else if (s < 3600) snprintf(out, cap, "%.1f min", s / 60);
+  else snprintf(out, cap, "%.1f h", s / 3600);
+}
+
+static double percent(const ChannelStats& c) {
+  return c.afterFirstS > 0 ? 100.0 * c.inBandS / c.afterFirstS : 0;
+}
+
+// Each run gets a fresh firmware image: app state lives in globals
+static bool runForked(const Policy& p, double days, uint32_t seed, bool probeOpen, Result& r) {
+  int fds[2];
+  if (pipe(fds) != 0) { perror("pipe"); return false; }
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    Result child = runPolicy(p, days, seed, probeOpen);
+    ssize_t n = write(fds[1], &child, sizeof(child));
+    _exit(n == (ssize_t)sizeof(child) ? 0 : 1);
+  }
+  close(fds[1]);
+  ssize_t n = read(fds[0], &r, sizeof(r));
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (n != (ssize_t)sizeof(r)) { fprintf(stderr, "%s: simulation failed\n", p.name); return false; }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  double days = argc > 1 ? atof(argv[1]) : 14;
+  const char* only = argc > 2 ? argv[2] : nullptr;
+  uint32_t seed = argc > 3 ? (uint32_t)strtoul(argv[3], nullptr, 10) : 1;
+  if (days <= 0 || days > 45) {  // lockout/settle math is 32-bit millis, like the chip
+    fprintf(stderr, "usage: %s [days 0-45] [policy|open-probe|all] [seed]\n", argv[0]);
+    return 2;
+  }
+
+  printf("Reservoir sim: %.1f days, seed %u | pH %.1f-%.1f, ppm %.0f-%.0f | start pH %.1f, %.0f ppm\n\n",
+         days, seed, PH_MIN, PH_MAX, PPM_MIN, PPM_MAX, START_PH, START_PPM);
+  printf("%-13s %7s | %10s %7s %6s %6s | %10s %5s %6s %6s | %7s %5s %6s %6s %7s\n",
+         "policy", "lockout", "pH t->band", "up/dn", "over", "inband",
+         "ppm t->band", "doses", "over", "inband", "reagent", "lamp", "final", "posts", "speedup");
+
+  bool any = false;
+  for (int i = 0; i < POLICY_COUNT; i++) {
+    const Policy& p = POLICIES[i];
+    if (only && strcmp(only, "all") && strcmp(only, p.name)) continue;
+    any = true;
+
+    Result r;
+    if (!runForked(p, days, seed, false, r)) continue;
+
+    char phT[16], ppmT[16], dosesPh[16], finals[24];
+    formatDuration(phT, sizeof(phT), r.ph.firstInBandS);
+    formatDuration(ppmT, sizeof(ppmT), r.ppm.firstInBandS);
+    snprintf(dosesPh, sizeof(dosesPh), "%u/%u", r.phUpDoses, r.phDownDoses);
+    snprintf(finals, sizeof(finals), "%.2f/%.0f", r.finalPh, r.finalPpm);
+    printf("%-13s %6lus | %10s %7s %6.2f %5.1f%% | %10s %5u %6.0f %5.1f%% | %5.0fmL %4.0f%% %6s %6u %6.0fx\n",
+           p.name, p.lockoutMs / 1000, phT, dosesPh, r.ph.overshoot, percent(r.ph),
+           ppmT, r.nutrientDoses, r.ppm.overshoot, percent(r.ppm),
+           r.reagentMl, 100.0 * r.lampInRangeS / (days * 86400), finals, r.uplinks,
+           days * 86400 / r.wallS);
+  }
+
+  if (!only || !strcmp(only, "all") || !strcmp(only, "open-probe")) {
+    any = true;
+    Result r;
+    if (!runForked(POLICIES[0], OPEN_PROBE_DAYS, seed, true, r)) return 1;
+    bool ok = r.sentPh == 0 && !r.phUpDoses && !r.phDownDoses;
+    printf("\nopen-probe: ADC floor %.0f mV, %.0f min | last pH sent %.2f | pH doses %u/%u | %s\n",
+           OPEN_PROBE_OFFSET_MV, OPEN_PROBE_DAYS * 1440, r.sentPh, r.phUpDoses, r.phDownDoses,
+           ok ? "ok" : "FAIL");
+    if (!ok) return 1;
+  }
+  if (!any) {
+    fprintf(stderr, "unknown policy '%s'\n", only);
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include "adc_cal.h"
+#include <esp_adc_cal.h>
+#include <algorithm>
+
+const uint32_t ADC_DEFAULT_VREF_MV = 1100;  // only used when the chip has no eFuse data
+const int ADC_LUT_SIZE = 4096;              // 12-bit
+
+static const uint8_t MAX_PIN = 40;
+static int8_t   pinChannel[MAX_PIN];      // -1 = not attached
+static uint8_t  pinAtten[MAX_PIN];
+static uint16_t* lut[ADC_ATTEN_MAX];      // raw -> mV, one per attenuation in use
+static esp_adc_cal_value_t calSource[ADC_ATTEN_MAX];
+static bool widthSet = false;
+
+static bool buildLut(adc_atten_t atten) {
+  if (lut[atten]) return true;
+  uint16_t* t = (uint16_t*)malloc(ADC_LUT_SIZE * sizeof(uint16_t));
+  if (!t) return false;
+
+  esp_adc_cal_characteristics_t chars;
+  calSource[atten] = esp_adc_cal_characterize(ADC_UNIT_1, atten, ADC_WIDTH_BIT_12,
+                                              ADC_DEFAULT_VREF_MV, &chars);
+  for (int raw = 0; raw < ADC_LUT_SIZE; raw++) {
+    t[raw] = (uint16_t)esp_adc_cal_raw_to_voltage(raw, &chars);
+  }
+  lut[atten] = t;
+
+  const char* src = calSource[atten] == ESP_ADC_CAL_VAL_EFUSE_TP   ? "eFuse two-point" :
+                    calSource[atten] == ESP_ADC_CAL_VAL_EFUSE_VREF ? "eFuse Vref" : "default Vref";
+  Serial.printf("[ADC] atten=%d cal=%s | raw 0 -> %u mV, raw 4095 -> %u mV\n",
+                (int)atten, src, t[0], t[ADC_LUT_SIZE - 1]);
+  return true;
+}
+
+bool adcAttach(uint8_t pin, adc_atten_t atten) {
+  if (!widthSet) {
+    memset(pinChannel, -1, sizeof(pinChannel));
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    widthSet = true;
+  }
+  int8_t ch = pin < MAX_PIN ? digitalPinToAnalogChannel(pin) : -1;
+  if (ch < 0 || ch >= ADC1_CHANNEL_MAX) {
+    Serial.printf("[ADC] GPIO%u is not an ADC1 pin\n", pin);
+    return false;
+  }
+  if (!buildLut(atten)) {
+    Serial.println("[ADC] LUT allocation failed");
+    return false;
+  }
+  adc1_config_channel_atten((adc1_channel_t)ch, atten);
+  pinChannel[pin] = ch;
+  pinAtten[pin] = atten;
+  return true;
+}
+
+int adcReadRaw(uint8_t pin) {
+  return adc1_get_raw((adc1_channel_t)pinChannel[pin]);
+}
+
+uint16_t adcRawToMilliVolts(uint8_t pin, int raw) {
+  return lut[pinAtten[pin]][raw & (ADC_LUT_SIZE - 1)];
+}
+
+uint16_t adcReadMilliVolts(uint8_t pin) {
+  return adcRawToMilliVolts(pin, adcReadRaw(pin));
+}
+
+float adcMilliVoltsToRaw(uint8_t pin, float mv) {
+  const uint16_t* t = lut[pinAtten[pin]];
+  if (mv <= t[0]) return 0;
+  if (mv >= t[ADC_LUT_SIZE - 1]) return ADC_LUT_SIZE - 1;
+  // The table never decreases: the first entry >= mv, and the one before it
+  int hi = std::lower_bound(t, t + ADC_LUT_SIZE, mv) - t;
+  float lo = t[hi - 1], span = t[hi] - lo;
+  return hi - 1 + (mv - lo) / span;
+}
@@ -0,0 +1,179 @@
+#include "app.h"
+#include "config.h"
+#include "hal.h"
+#include "scheduler.h"
+#include "sampling.h"
+#include "sensors.h"
+#include "dosing.h"
+#include "light.h"
+#include "uplink.h"
+#include "console.h"
+#include "local_http.h"
+#include "history.h"
+#include "push.h"
+#include "dns_cache.h"
+#include "metrics.h"
+#include "logger.h"
+
+static constexpr LogModule LOG_THIS = LOG_MOD_SAMPLING;
+
+// ===================================================
+// Job table
+// ===================================================
+// Each job runs at the rate it actually needs instead of once per loop.
+// Budgets are the expected worst case; runs that exceed them are counted
+// as overruns in the periodic [SCHED] report.
+void reportScheduler();
+
+enum JobId { JOB_DOSING, JOB_LIGHT_ADJUST, JOB_ULTRASONIC, JOB_WATER, JOB_DHT,
+             JOB_PPM, JOB_PH, JOB_UPLINK, JOB_REPORT, JOB_CONSOLE, JOB_LOCAL_HTTP,
+             JOB_LOG_DRAIN, JOB_HISTORY, JOB_PUSH, JOB_DNS, JOB_COUNT };
+
+const Job JOBS[JOB_COUNT] = {
+  // name            fn                     period                    prio  budget (us)
+  { "dosing",        dosingTick,            50,                       0,    2000    },
+  { "light_adjust",  adjustLightHeightAuto, LIGHT_ADJUST_INTERVAL_MS, 1,    30000   },
+  { "ultrasonic",    readUltrasonic,        1000,                     2,    35000   },
+  { "water",         readWaterSensor,       5000,                     2,    1000    },
+  { "dht",           readDHT,               2000,                     3,    30000   },
+  { "ppm",           readPpmSensor,         2000,                     3,    170000  },
+  { "ph",            readPhSensor,          5000,                     3,    320000  },
+  { "uplink",        uplinkTick,            UPLINK_INTERVAL_MS,       4,    3000000 },
+  { "sched_report",  reportScheduler,       SCHED_REPORT_INTERVAL_MS, 5,    20000   },
+  { "console",       consoleTick,           100,                      5,    20000   },
+  { "local_http",    localHttpTick,         50,                       4,    50000   },
+  { "log_drain",     logDrainTick,          20,                       6,    5000    },
+  { "history",       historyTick,           HISTORY_INTERVAL_MS,      5,    2000    },
+  { "push",          pushTick,              50,                       4,    3000000 },
+  { "dns",           dnsCacheTick,          250,                      4,    5000    },
+};
+JobStats jobStats[JOB_COUNT];
+Scheduler scheduler(JOBS, jobStats, JOB_COUNT);
+
+void printSchedulerStats() { scheduler.report(); }
+
+void reportScheduler() {
+  if (LOG_ENABLED(LOG_MOD_SCHED, LOG_LVL_DEBUG)) printSchedulerStats();
+}
+
+// ===================================================
+// Sampling policies
+// ===================================================
+// pH drifts over minutes and distance only matters around stepper moves, so
+// steady state is sampled sparsely; doses and moves switch to dense reads.
+struct SensorChannel {
+  const char* name;
+  JobId job;
+  AdaptiveSampler sampler;
+};
+
+SensorChannel channels[SENSOR_COUNT] = {
+  //  name        job             mode             slow    fast   delta
+  { "dht",      JOB_DHT,        {{ SAMPLE_ADAPTIVE, 30000,  5000, 1.0f  }} },
+  { "distance", JOB_ULTRASONIC, {{ SAMPLE_ADAPTIVE, 60000,   500, 1.0f  }} },
+  { "ppm",      JOB_PPM,        {{ SAMPLE_ADAPTIVE, 30000,  2000, 20.0f }} },
+  { "ph",       JOB_PH,         {{ SAMPLE_ADAPTIVE, 60000,  3000, 0.05f }} },
+  { "water",    JOB_WATER,      {{ SAMPLE_FIXED,    10000,     0, 0.0f  }} },
+};
+
+// Is the channel inside a transient that warrants dense sampling?
+bool inTransient(SensorId id) {
+  switch (id) {
+    case SENSOR_PH:
+    case SENSOR_PPM:      return dosingActive();
+    case SENSOR_DISTANCE: return lastStepperMoveMs && hal::millis() - lastStepperMoveMs < STEPPER_SETTLE_MS;
+    default:              return false;
+  }
+}
+
+void sampleDone(SensorId id, float value) {
+  uplinkObserve(id);
+  localLiveObserve();
+  SensorChannel& ch = channels[id];
+  uint32_t next = ch.sampler.update(value, inTransient(id));
+  if (next != scheduler.statsFor(ch.job).periodMs) {
+    scheduler.setPeriod(ch.job, next);
+    LOGD("[SAMPLE] %s -> %lu ms\n", ch.name, (unsigned long)next);
+  }
+}
+
+void requestSample(SensorId id) {
+  scheduler.trigger(channels[id].job);
+}
+
+// A transient just started (e.g. dose): go dense now rather than after the
+// next (possibly minute-long) period expires.
+void kickSampling(SensorId id) {
+  SensorChannel& ch = channels[id];
+  if (ch.sampler.policy().mode == SAMPLE_ADAPTIVE) scheduler.setPeriod(ch.job, ch.sampler.policy().fastMs);
+}
+
+void applySamplingPolicies() {
+  for (auto& ch : channels) {
+    scheduler.setPeriod(ch.job, ch.sampler.intervalMs());
+    scheduler.trigger(ch.job);  // one reading at boot, even for on-demand channels
+  }
+}
+
+// Server may send {"sampling":{"ph":{"mode":"adaptive","slow_ms":60000,
+// "fast_ms":3000,"delta":0.05,"now":true}, ...}}; omitted fields keep their value.
+void applySamplingConfig(JsonVariant cfg) {
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    SensorChannel& ch = channels[i];
+    JsonVariant c = cfg[ch.name];
+    if (c.isNull()) continue;
+
+    SamplingPolicy p = ch.sampler.policy();
+    parseSampleMode(c["mode"] | "", p.mode);
+    p.slowMs = c["slow_ms"] | p.slowMs;
+    p.fastMs = c["fast_ms"] | p.fastMs;
+    p.delta  = c["delta"]   | p.delta;
+    ch.sampler.setPolicy(p);
+    scheduler.setPeriod(ch.job, ch.sampler.intervalMs());
+    if (c["now"] | false) requestSample((SensorId)i);
+
+    LOGI("[SAMPLE] %s policy: %s slow=%lu fast=%lu delta=%.3f\n",
+         ch.name, sampleModeName(p.mode),
+         (unsigned long)p.slowMs, (unsigned long)p.fastMs, p.delta);
+  }
+}
+
+// ===================================================
+// Setup / Loop
+// ===================================================
+#if FILTER_BENCH
+void runFilterBench();  // bench/filter_bench.cpp
+#endif
+
+void appSetup() {
+  hal::consoleBegin(115200);
+  hal::logf("\n[BOOT] Starting...\n");
+
+  hal::networkBegin(ssid, password);
+
+  sensorsBegin();
+  dosingBegin();
+  lightBegin();
+
+  #if FILTER_BENCH
+  runFilterBench();
+  #endif
+
+  localHttpBegin();
+
+  scheduler.begin();
+  applySamplingPolicies();
+  hal::logf("[INIT] Hardware initialized\n");
+}
+
+void appLoop() {
+  uint32_t t0 = hal::micros();
+  int ran = scheduler.runOnce();
+  if (ran < 0) return;
+
+  uint32_t us = hal::micros() - t0;
+  metrics.loopUs.record(us);
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    if (channels[i].job == ran) metrics.sensorUs[i].record(us);
+  }
+}
@@ -0,0 +1,131 @@
+#include "coap.h"
+#include <string.h>
+
+static const uint8_t OPT_URI_PATH = 11;
+static const uint8_t OPT_CONTENT_FORMAT = 12;
+static const uint8_t OPT_URI_QUERY = 15;
+static const uint8_t PAYLOAD_MARKER = 0xFF;
+
+// -------- Writing --------
+namespace {
+struct MessageWriter {
+  MessageWriter(uint8_t* out, size_t cap) : out(out), cap(cap) {}
+
+  uint8_t* out;
+  size_t cap;
+  size_t len = 0;
+  bool ok = true;
+  uint16_t lastOption = 0;
+
+  void byte(uint8_t b) { if (len < cap) out[len++] = b; else ok = false; }
+  void bytes(const void* p, size_t n) {
+    if (len + n > cap) { ok = false; return; }
+    memcpy(out + len, p, n);
+    len += n;
+  }
+
+  // Delta and length share the first byte; 13 / 14 mean one / two more bytes
+  static uint8_t nibble(size_t v) { return v < 13 ? v : v < 269 ? 13 : 14; }
+  void extended(size_t v) {
+    if (v >= 269) { byte((v - 269) >> 8); byte(v - 269); }
+    else if (v >= 13) byte(v - 13);
+  }
+
+  // Options must be written in ascending number
+  void option(uint16_t number, const void* value, size_t n) {
+    size_t delta = number - lastOption;
+    lastOption = number;
+    byte(nibble(delta) << 4 | nibble(n));
+    extended(delta);
+    extended(n);
+    bytes(value, n);
+  }
+  size_t done() const { return ok ? len : 0; }
+};
+}  // namespace
+
+size_t coapEncode(const CoapMessage& m, uint8_t* out, size_t cap) {
+  if (m.tokenLen > 8) return 0;
+  MessageWriter w(out, cap);
+  w.byte(1 << 6 | m.type << 4 | m.tokenLen);  // version 1
+  w.byte(m.code);
+  w.byte(m.messageId >> 8);
+  w.byte(m.messageId);
+  w.bytes(m.token, m.tokenLen);
+
+  if (m.uriPath) w.option(OPT_URI_PATH, m.uriPath, strlen(m.uriPath));
+  if (m.contentFormat != COAP_NO_FORMAT) {
+    // Minimal unsigned: 0 is the empty value
+    uint8_t v[2] = { (uint8_t)(m.contentFormat >> 8), (uint8_t)m.contentFormat };
+    size_t n = m.contentFormat > 0xFF ? 2 : m.contentFormat ? 1 : 0;
+    w.option(OPT_CONTENT_FORMAT, v + 2 - n, n);
+  }
+  if (m.uriQuery) w.option(OPT_URI_QUERY, m.uriQuery, strlen(m.uriQuery));
+
+  if (m.payloadLen) {
+    w.byte(PAYLOAD_MARKER);
+    w.bytes(m.payload, m.payloadLen);
+  }
+  return w.done();
+}
+
+// -------- Reading --------
+// One nibble's worth of delta or length, extended bytes consumed from `p`
+static bool optionField(uint8_t nib, const uint8_t*& p, const uint8_t* end, size_t& v) {
+  if (nib < 13) { v = nib; return true; }
+  if (nib == 13) {
+    if (p >= end) return false;
+    v = 13 + *p++;
+    return true;
+  }
+  if (nib == 14) {
+    if (end - p < 2) return false;
+    v = 269 + (p[0] << 8 | p[1]);
+    p += 2;
+    return true;
+  }
+  return false;  // 15 is reserved
+}
+
+bool coapDecode(const uint8_t* in, size_t len, CoapMessage& m) {
+  if (len < 4 || in[0] >> 6 != 1) return false;
+  m = CoapMessage();
+  m.type = (in[0] >> 4) & 3;
+  m.tokenLen = in[0] & 0x0F;
+  m.code = in[1];
+  m.messageId = in[2] << 8 | in[3];
+  if (m.tokenLen > 8 || len < 4u + m.tokenLen) return false;
+  memcpy(m.token, in + 4, m.tokenLen);
+
+  const uint8_t* p = in + 4 + m.tokenLen;
+  const uint8_t* end = in + len;
+  size_t number = 0;
+  while (p < end && *p != PAYLOAD_MARKER) {
+    uint8_t head = *p++;
+    size_t delta, n;
+    if (!optionField(head >> 4, p, end, delta) || !optionField(head & 0x0F, p, end, n)) return false;
+    if ((size_t)(end - p) < n) return false;
+    number += delta;
+    switch (number) {
+      case OPT_URI_PATH:
+        if (!m.uriPath) { m.uriPath = (const char*)p; m.uriPathLen = n; }
+        break;
+      case OPT_URI_QUERY:
+        if (!m.uriQuery) { m.uriQuery = (const char*)p; m.uriQueryLen = n; }
+        break;
+      case OPT_CONTENT_FORMAT:
+        if (n > 2) return false;
+        m.contentFormat = 0;
+        for (size_t i = 0; i < n; i++) m.contentFormat = m.contentFormat << 8 | p[i];
+        break;
+      default: break;
+    }
+    p += n;
+  }
+  if (p < end) {
+    if (++p == end) return false;  // a marker with no payload is a format error
+    m.payload = p;
+    m.payloadLen = end - p;
+  }
+  return true;
+}
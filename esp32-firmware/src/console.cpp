@@ -0,0 +1,175 @@
+#include "console.h"
+#include "config.h"
+#include "app.h"
+#include "hal.h"
+#include "logger.h"
+#include "memstats.h"
+#include "metrics.h"
+#include "uplink.h"
+#include "history.h"
+#include "push.h"
+#include "gateway.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void cmdHelp(const char* args);
+
+static void cmdTrace(const char* args) {
+  if (!strcmp(args, "dump"))       traceDump();
+  else if (!strcmp(args, "clear")) traceClear();
+  else if (!strcmp(args, "on"))    traceEnable(true);
+  else if (!strcmp(args, "off"))   traceEnable(false);
+  else if (!strncmp(args, "min ", 4)) traceSetMinUs(strtoul(args + 4, nullptr, 10));
+  else hal::logf("[CONSOLE] usage: trace dump|clear|on|off|min <us>\n");
+}
+
+static void cmdSched(const char*) { printSchedulerStats(); }
+
+static void cmdLog(const char* args) {
+  char mod[16];
+  char lvl[8];
+  if (!args[0]) {
+    for (int i = 0; i < LOG_MOD_COUNT; i++) {
+      hal::logf("[LOG] %-8s %-5s (compiled max %s)\n", logModuleName((LogModule)i),
+                logLevelName(logLevels[i]), logLevelName(LOG_COMPILED_MAX[i]));
+    }
+    hal::logf("[LOG] dropped: %lu\n", (unsigned long)logDropped());
+    return;
+  }
+  if (!strcmp(args, "flush")) { logFlush(); return; }
+
+  LogModule m = LOG_MOD_COUNT;
+  uint8_t level;
+  if (sscanf(args, "%15s %7s", mod, lvl) != 2 || !logParseLevel(lvl, level) ||
+      (strcmp(mod, "all") && !logParseModule(mod, m))) {
+    hal::logf("[CONSOLE] usage: log [flush | <module>|all none|error|warn|info|debug]\n");
+    return;
+  }
+  for (int i = 0; i < LOG_MOD_COUNT; i++) {
+    if (m == LOG_MOD_COUNT || m == i) logLevels[i] = level;
+  }
+}
+
+static void cmdMem(const char*) {
+  MemSnapshot m = memSnapshot();
+  hal::logf("[MEM] heap free %lu | largest %lu | min %lu | frag %u%%\n",
+            (unsigned long)m.heap.freeBytes, (unsigned long)m.heap.largestFreeBlock,
+            (unsigned long)m.heap.minFreeBytes, m.fragPct);
+  for (int i = 0; i < MEM_TASK_COUNT; i++) {
+    uint32_t free = hal::stackHighWater(MEM_TASKS[i]);
+    if (free) hal::logf("[MEM] stack %-14s %5lu bytes never used\n", MEM_TASKS[i], (unsigned long)free);
+  }
+  const Arena& a = uplinkArena();
+  hal::logf("[MEM] uplink arena %lu / %lu bytes peak, %lu overflows\n", (unsigned long)a.highWater(),
+            (unsigned long)a.capacity(), (unsigned long)a.overflows());
+  for (int i = 0; i < MEM_REGION_COUNT; i++) {
+    hal::logf("[MEM] %-10s %8lu allocs %10lu bytes\n", memRegionName((MemRegion)i),
+              (unsigned long)memRegions[i].allocs, (unsigned long)memRegions[i].bytes);
+  }
+}
+
+static void cmdUplink(const char* args) {
+  UplinkMode m;
+  if (args[0] && !parseUplinkMode(args, m)) {
+    hal::logf("[CONSOLE] usage: uplink [raw|deadband|window]\n");
+    return;
+  }
+  if (args[0]) setUplinkMode(m);
+  hal::logf("[UPLINK] mode %s | %d window(s) pending, %lu dropped | %lu sent, %lu suppressed, %lu deferred, "
+            "%lu rejected\n",
+            uplinkModeName(uplinkMode()), uplinkPendingWindows(), (unsigned long)metrics.uplinkWindowsDropped,
+            (unsigned long)metrics.uplinks, (unsigned long)metrics.uplinksSuppressed,
+            (unsigned long)metrics.uplinksDeferred, (unsigned long)metrics.uplinkFramesRejected);
+  const UplinkPolicy& p = uplinkPolicy();
+  hal::logf("[UPLINK] breaker %s | %d failure(s) in a row | next attempt in %lu ms | opened %lu times\n",
+            breakerStateName(p.state()), p.consecutiveFailures(), (unsigned long)p.waitMs(hal::millis()),
+            (unsigned long)p.opens());
+  const UploadPacer& pace = uplinkPacer();
+  hal::logf("[UPLINK] gap %lu ms (%s) | batch %d | rtt %lu ms | %d.%d%% failing\n",
+            (unsigned long)pace.gapMs(false), pace.serverPaced() ? "server" : "adaptive",
+            pace.batch(UPLINK_BATCH_MAX), (unsigned long)pace.srttMs(), pace.errorPermille() / 10,
+            pace.errorPermille() % 10);
+}
+
+static void cmdPush(const char* args) {
+  if (!strcmp(args, "on")) pushEnable(true);
+  else if (!strcmp(args, "off")) pushEnable(false);
+  else if (args[0]) { hal::logf("[CONSOLE] usage: push [on|off]\n"); return; }
+  hal::logf("[PUSH] %s | broker %s:%u | %lu sessions, %lu commands\n", pushStateName(), MQTT_HOST,
+            MQTT_PORT, (unsigned long)metrics.pushConnects, (unsigned long)metrics.pushCommands);
+}
+
+static void cmdGateway(const char* args) {
+  if (!strcmp(args, "on")) gatewayEnable(true);
+  else if (!strcmp(args, "off")) gatewayEnable(false);
+  else if (args[0]) { hal::logf("[CONSOLE] usage: gateway [on|off]\n"); return; }
+  hal::logf("[COAP] %s | gateway %s:%u | %lu retransmits\n", gatewayEnabled() ? "on" : "off",
+            GATEWAY_HOST, GATEWAY_PORT, (unsigned long)metrics.coapRetransmits);
+}
+
+static void logText(void*, const char* s, size_t n) { hal::logf("%.*s", (int)n, s); }
+
+static void cmdMetrics(const char*) {
+  MetricsOut out = { logText, nullptr };
+  metricsRender(out);
+}
+
+static void cmdHist(const char* args) {
+  const HistoryStore& h = sensorHistory();
+  if (!strncmp(args, "csv", 3)) {
+    uint32_t minutes = strtoul(args + 3, nullptr, 10);
+    uint32_t now = hal::millis() / 1000;
+    MetricsOut out = { logText, nullptr };
+    historyRender(out, minutes && minutes * 60 < now ? now - minutes * 60 : 0);
+    return;
+  }
+  if (args[0]) { hal::logf("[CONSOLE] usage: hist [csv [minutes]]\n"); return; }
+
+  uint32_t rows = h.rows(), from = 0;
+  size_t used = h.bytesUsed();
+  h.oldest(from);
+  hal::logf("[HIST] %lu rows since t=%lus | %lu / %lu bytes | %.1f bytes/row (raw %u)\n",
+            (unsigned long)rows, (unsigned long)from, (unsigned long)used,
+            (unsigned long)h.capacityBytes(), rows ? (double)used / rows : 0.0,
+            (unsigned)sizeof(HistoryRow));
+}
+
+struct ConsoleCommand {
+  const char* name;
+  void (*fn)(const char* args);
+  const char* help;
+};
+
+static const ConsoleCommand COMMANDS[] = {
+  { "help",  cmdHelp,  "list commands" },
+  { "trace", cmdTrace, "dump|clear|on|off|min <us>  phase trace ring buffer" },
+  { "sched", cmdSched, "scheduler job stats" },
+  { "metrics", cmdMetrics, "latency histograms and counters (Prometheus text)" },
+  { "mem",   cmdMem,   "heap, stack high-water marks and allocations by region" },
+  { "log",   cmdLog,   "[flush | <module>|all <level>]  deferred log levels" },
+  { "hist",  cmdHist,  "[csv [minutes]]  in-RAM sensor history" },
+  { "push",  cmdPush,  "[on|off]  MQTT push channel" },
+  { "gateway", cmdGateway, "[on|off]  uplink via the LAN CoAP gateway" },
+  { "uplink", cmdUplink, "[raw|deadband|window]  upload mode (raw: every frame, for debugging)" },
+};
+
+static void cmdHelp(const char*) {
+  for (const auto& c : COMMANDS) hal::logf("[CONSOLE] %-7s %s\n", c.name, c.help);
+}
+
+void consoleTick() {
+  char line[64];
+  if (!hal::consoleReadLine(line, sizeof(line))) return;
+  TRACE_SCOPE(TRACE_CONSOLE);
+
+  char* args = strchr(line, ' ');
+  if (args) *args++ = '\0';
+  else args = line + strlen(line);
+
+  for (const auto& c : COMMANDS) {
+    if (!strcmp(line, c.name)) { c.fn(args); return; }
+  }
+  if (line[0]) hal::logf("[CONSOLE] unknown command '%s' (try help)\n", line);
+}
@@ -0,0 +1,102 @@
+#include "dns_cache.h"
+#include "config.h"
+#include "hal.h"
+#include "mdns.h"
+#include "metrics.h"
+#include "logger.h"
+#include <string.h>
+
+static constexpr LogModule LOG_THIS = LOG_MOD_UPLINK;
+
+static uint32_t addrs[DNS_MAX_ADDRS];
+static int count = 0;
+static uint32_t expiresAt = 0, refreshAt = 0;
+
+static bool querying = false;
+static uint16_t queryId = 0;
+static uint32_t sentAt = 0, retryAt = 0;
+static uint32_t retryMs = DNS_TIMEOUT_MS;
+
+static void lookupFailed(uint32_t now, const char* why) {
+  metrics.dnsFailures++;
+  LOGD("[DNS] %s: %s (retry in %lu ms)\n", HOSTNAME, why, (unsigned long)retryMs);
+  retryAt = now + retryMs;
+  retryMs = retryMs * 2 < DNS_RETRY_MAX_MS ? retryMs * 2 : DNS_RETRY_MAX_MS;
+}
+
+static void query(uint32_t now) {
+  uint8_t msg[128];
+  queryId = (uint16_t)hal::randomU32();
+  size_t n = dnsQueryA(msg, sizeof(msg), queryId, HOSTNAME);
+  if (!n || !hal::resolverSend(msg, n)) {  // no resolver (yet): nothing to count
+    retryAt = now + DNS_RETRY_MAX_MS;
+    return;
+  }
+  metrics.dnsLookups++;
+  querying = true;
+  sentAt = now;
+}
+
+// The new answer, keeping the address in use first if it's still there
+static void store(const uint32_t* got, int n, uint32_t ttlS, uint32_t now) {
+  uint32_t current = count ? addrs[0] : 0;
+  memcpy(addrs, got, n * sizeof(addrs[0]));
+  count = n;
+  for (int i = 1; i < count; i++) {
+    if (addrs[i] != current) continue;
+    addrs[i] = addrs[0];
+    addrs[0] = current;
+  }
+  if (ttlS < DNS_MIN_TTL_S) ttlS = DNS_MIN_TTL_S;
+  if (ttlS > DNS_MAX_TTL_S) ttlS = DNS_MAX_TTL_S;
+  expiresAt = now + ttlS * 1000;
+  refreshAt = now + ttlS * 750;
+  retryMs = DNS_TIMEOUT_MS;
+  LOGD("[DNS] %s: %d address(es), ttl %lu s\n", HOSTNAME, count, (unsigned long)ttlS);
+}
+
+void dnsCacheTick() {
+  if (!hal::networkUp()) return;
+  uint32_t now = hal::millis();
+  if (count && (int32_t)(now - expiresAt) >= 0) {
+    count = 0;
+    LOGD("[DNS] %s expired\n", HOSTNAME);
+  }
+
+  if (querying) {
+    uint8_t buf[512];
+    int n;
+    while ((n = hal::resolverRecv(buf, sizeof(buf))) > 0) {
+      uint32_t got[DNS_MAX_ADDRS], ttlS;
+      int found = dnsParseA(buf, n, queryId, HOSTNAME, got, DNS_MAX_ADDRS, ttlS);
+      if (found < 0) continue;  // not the answer to this query
+      querying = false;
+      if (found) store(got, found, ttlS, now);
+      else lookupFailed(now, "no addresses");
+      return;
+    }
+    if (now - sentAt >= DNS_TIMEOUT_MS) {
+      querying = false;
+      lookupFailed(now, "timeout");
+    }
+    return;
+  }
+  bool stale = !count || (int32_t)(now - refreshAt) >= 0;
+  if (stale && (int32_t)(now - retryAt) >= 0) query(now);
+}
+
+uint32_t dnsCacheAddress() { return count ? addrs[0] : 0; }
+
+void dnsCacheFailed(uint32_t ipv4) {
+  if (count < 2 || addrs[0] != ipv4) return;
+  memmove(addrs, addrs + 1, (count - 1) * sizeof(addrs[0]));
+  addrs[count - 1] = ipv4;
+  metrics.dnsFailovers++;
+}
+
+int dnsCacheCount() { return count; }
+
+uint32_t dnsCacheTtlMs() {
+  uint32_t now = hal::millis();
+  return count && (int32_t)(expiresAt - now) > 0 ? expiresAt - now : 0;
+}
@@ -0,0 +1,109 @@
+#include "dosing.h"
+#include "config.h"
+#include "hal.h"
+#include "sensors.h"
+#include "metrics.h"
+#include "logger.h"
+
+static constexpr LogModule LOG_THIS = LOG_MOD_DOSING;
+
+// -------- Dosing states --------
+PpmDosingState ppmState = PPM_IDLE;
+PhDosingState  phState  = PH_IDLE;
+
+unsigned long ppmStateChangeTime = 0, phStateChangeTime = 0;
+unsigned long dosingDuration = 2000, delayDuration = 2000;
+// Pump run time of the sequence in progress: dosingDuration, or its dose_ms
+static unsigned long ppmRunMs = 0, phRunMs = 0;
+
+// -------- Global Lockout --------
+unsigned long globalLockoutUntil = 0;
+bool isLockedOut() { return (long)(globalLockoutUntil - hal::millis()) > 0; }  // wrap-safe
+unsigned long lockoutRemaining() { return isLockedOut() ? (globalLockoutUntil - hal::millis()) : 0; }
+
+// How long past its run time the pump stayed on (tick granularity)
+static void recordPumpError(unsigned long now, unsigned long since, unsigned long runMs) {
+  metrics.pumpErrorUs.record((now - since - runMs) * 1000UL);
+}
+
+bool dosingActive() {
+  return ppmState != PPM_IDLE || phState != PH_IDLE || isLockedOut();
+}
+
+void stopAllPumps() {
+  hal::digitalWrite(PH_UP_PUMP_PIN, false);
+  hal::digitalWrite(PH_DOWN_PUMP_PIN, false);
+  hal::digitalWrite(PPM_A_PUMP_PIN, false);
+  hal::digitalWrite(PPM_B_PUMP_PIN, false);
+}
+
+void dosingBegin() {
+  hal::pinOutput(PH_UP_PUMP_PIN); hal::pinOutput(PH_DOWN_PUMP_PIN);
+  hal::pinOutput(PPM_A_PUMP_PIN); hal::pinOutput(PPM_B_PUMP_PIN);
+  stopAllPumps();
+}
+
+void dosingTick() {
+  unsigned long now = hal::millis();
+  if (ppmState == PPM_DOSING_A && now-ppmStateChangeTime>=ppmRunMs){
+    hal::digitalWrite(PPM_A_PUMP_PIN,false);
+    recordPumpError(now, ppmStateChangeTime, ppmRunMs);
+    ppmState=PPM_DELAYING; ppmStateChangeTime=now;
+    LOGI("[PPM] A finished -> DELAY\n");
+  } else if (ppmState==PPM_DELAYING && now-ppmStateChangeTime>=delayDuration){
+    hal::digitalWrite(PPM_B_PUMP_PIN,true);
+    ppmState=PPM_DOSING_B; ppmStateChangeTime=now;
+    LOGI("[PPM] Delay finished -> B START\n");
+  } else if (ppmState==PPM_DOSING_B && now-ppmStateChangeTime>=ppmRunMs){
+    hal::digitalWrite(PPM_B_PUMP_PIN,false); ppmState=PPM_IDLE;
+    recordPumpError(now, ppmStateChangeTime, ppmRunMs);
+    LOGI("[PPM] B finished -> IDLE\n");
+  }
+  if (phState==PH_DOSING_UP && now-phStateChangeTime>=phRunMs){
+    hal::digitalWrite(PH_UP_PUMP_PIN,false); phState=PH_IDLE;
+    recordPumpError(now, phStateChangeTime, phRunMs);
+    LOGI("[pH] UP finished -> IDLE\n");
+  }
+  if (phState==PH_DOSING_DOWN && now-phStateChangeTime>=phRunMs){
+    hal::digitalWrite(PH_DOWN_PUMP_PIN,false); phState=PH_IDLE;
+    recordPumpError(now, phStateChangeTime, phRunMs);
+    LOGI("[pH] DOWN finished -> IDLE\n");
+  }
+}
+
+void applyDosingCommands(bool phUp, bool phDn, bool ppmA, bool ppmB, unsigned long lockoutMs,
+                         unsigned long doseMs) {
+  // Respect local lockout for NEW starts (existing sequences continue)
+  if(!isLockedOut()){
+    // dose_ms sizes the dose it came with; one without it runs the default
+    unsigned long runMs = !doseMs ? dosingDuration : doseMs < MAX_DOSE_MS ? doseMs : MAX_DOSE_MS;
+    if(phUp && phState==PH_IDLE){
+      phState=PH_DOSING_UP; phStateChangeTime=hal::millis(); phRunMs=runMs;
+      hal::digitalWrite(PH_UP_PUMP_PIN,true);
+      metrics.doses++;
+      kickSampling(SENSOR_PH);
+      globalLockoutUntil=hal::millis()+lockoutMs;
+      LOGI("[pH] UP START | lockout until %lu (in %lu ms)\n", globalLockoutUntil, lockoutRemaining());
+    } else if(phDn && phState==PH_IDLE){
+      phState=PH_DOSING_DOWN; phStateChangeTime=hal::millis(); phRunMs=runMs;
+      hal::digitalWrite(PH_DOWN_PUMP_PIN,true);
+      metrics.doses++;
+      kickSampling(SENSOR_PH);
+      globalLockoutUntil=hal::millis()+lockoutMs;
+      LOGI("[pH] DOWN START | lockout until %lu (in %lu ms)\n", globalLockoutUntil, lockoutRemaining());
+    } else if(ppmA && ppmB && ppmState==PPM_IDLE){
+      ppmState=PPM_DOSING_A; ppmStateChangeTime=hal::millis(); ppmRunMs=runMs;
+      hal::digitalWrite(PPM_A_PUMP_PIN,true);
+      metrics.doses++;
+      kickSampling(SENSOR_PPM);
+      // Reserve lockout for A + gap + B + settle(lockoutMs)
+      globalLockoutUntil=hal::millis()+ppmRunMs+delayDuration+ppmRunMs+lockoutMs;
+      LOGI("[PPM] A START | lockout until %lu (in %lu ms)\n", globalLockoutUntil, lockoutRemaining());
+    } else {
+      LOGD("[CMD] No new dosing started (either cmd false or state busy).\n");
+    }
+  } else {
+    if (phUp || phDn || (ppmA && ppmB)) metrics.lockoutRejections++;
+    LOGD("[LOCKOUT] Active; ignoring new starts. Remaining: %lu ms\n", lockoutRemaining());
+  }
+}
@@ -0,0 +1,127 @@
+#include "gateway.h"
+#include "config.h"
+#include "coap.h"
+#include "identity.h"
+#include "metrics.h"
+#include "logger.h"
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+
+static constexpr LogModule LOG_THIS = LOG_MOD_UPLINK;
+
+static bool enabled = GATEWAY_ENABLED;
+static uint16_t nextMessageId = 0;
+static uint32_t lcg = 0;
+
+// Request: 4-byte header, 4-byte token, options and the uplink payload.
+// Reply: the server's command JSON.
+static uint8_t txBuf[UPLINK_PAYLOAD_BYTES + 64];
+static uint8_t rxBuf[UPLINK_RESP_BYTES + 32];
+
+void gatewayEnable(bool on) {
+  if (on != enabled) LOGI("[COAP] gateway transport %s\n", on ? "on" : "off");
+  enabled = on;
+}
+
+bool gatewayEnabled() { return enabled; }
+
+// ACK_TIMEOUT scaled by 1..1.5 (RFC 7252 4.8) so boxes that power up
+// together don't retransmit in lockstep
+static uint32_t initialTimeout() {
+  lcg = lcg * 1664525u + 1013904223u;
+  return COAP_ACK_TIMEOUT_MS + (lcg >> 16) % (COAP_ACK_TIMEOUT_MS / 2 + 1);
+}
+
+static int takeResponse(const CoapMessage& m, char* resp, size_t respCap) {
+  if (respCap) {
+    size_t n = m.payloadLen < respCap - 1 ? m.payloadLen : respCap - 1;
+    if (n) memcpy(resp, m.payload, n);
+    resp[n] = '\0';
+  }
+  return coapStatus(m.code);
+}
+
+int gatewayPost(const uint8_t* body, size_t len, bool cbor,
+                char* resp, size_t respCap, hal::HttpTiming* timing) {
+  TRACE_SCOPE(TRACE_POST);
+  uint32_t t0 = hal::micros();
+  if (respCap) resp[0] = '\0';
+  if (!hal::udpBegin(GATEWAY_PORT)) return GATEWAY_ERR_SOCKET;
+  if (!lcg) {
+    // Unpredictable first message ID, so a reboot doesn't replay IDs the
+    // gateway still remembers as duplicates
+    lcg = hal::micros() | 1;
+    nextMessageId = (uint16_t)hal::randomU32();
+  }
+
+  char query[48];
+  snprintf(query, sizeof(query), "d=%s", deviceId());
+  CoapMessage req;
+  req.type = COAP_CON;
+  req.code = COAP_POST;
+  req.messageId = nextMessageId++;
+  // A random token per request: a separate response carrying commands is
+  // matched on it alone, so it mustn't be guessable (RFC 7252 5.3.1)
+  uint32_t token = hal::randomU32();
+  memcpy(req.token, &token, sizeof(token));
+  req.tokenLen = sizeof(token);
+  req.uriPath = GATEWAY_PATH;
+  req.uriQuery = query;
+  req.contentFormat = cbor ? COAP_FORMAT_CBOR : COAP_FORMAT_JSON;
+  req.payload = body;
+  req.payloadLen = len;
+  size_t n = coapEncode(req, txBuf, sizeof(txBuf));
+  if (!n) return hal::HTTP_ERR_BEGIN;
+
+  // Retransmit with a doubling timeout. An empty ACK means the response
+  // will follow as its own message: stop resending and keep listening.
+  int result = GATEWAY_ERR_TIMEOUT;
+  bool acked = false;
+  uint32_t timeout = initialTimeout();
+  for (int attempt = 0; attempt <= COAP_MAX_RETRANSMIT && result == GATEWAY_ERR_TIMEOUT; attempt++, timeout *= 2) {
+    if (!acked) {
+      if (attempt) {
+        metrics.coapRetransmits++;
+        LOGD("[COAP] retransmit %d of mid %u\n", attempt, req.messageId);
+      }
+      if (!hal::udpSend(GATEWAY_HOST, GATEWAY_PORT, txBuf, n)) { result = GATEWAY_ERR_SOCKET; break; }
+    }
+    uint32_t sentAt = hal::millis();
+    while (result == GATEWAY_ERR_TIMEOUT && hal::millis() - sentAt < timeout) {
+      int got = hal::udpRecv(rxBuf, sizeof(rxBuf));
+      CoapMessage m;
+      if (got <= 0) { hal::delayMs(1); continue; }
+      if (!coapDecode(rxBuf, got, m)) continue;
+
+      bool sameId = m.messageId == req.messageId;
+      bool sameToken = m.tokenLen == req.tokenLen && !memcmp(m.token, req.token, req.tokenLen);
+      if (m.type == COAP_RST && sameId) result = GATEWAY_ERR_RESET;
+      else if (m.type == COAP_ACK && sameId && m.code == COAP_EMPTY) acked = true;
+      else if (m.type == COAP_ACK && sameId) result = takeResponse(m, resp, respCap);
+      else if (m.type != COAP_ACK && sameToken) {
+        if (m.type == COAP_CON) {
+          CoapMessage ack;
+          ack.type = COAP_ACK;
+          ack.messageId = m.messageId;
+          uint8_t out[4];
+          hal::udpSend(GATEWAY_HOST, GATEWAY_PORT, out, coapEncode(ack, out, sizeof(out)));
+        }
+        result = takeResponse(m, resp, respCap);
+      }
+      // anything else is a late answer to an earlier exchange
+    }
+  }
+  if (timing) timing->totalUs = hal::micros() - t0;
+  return result;
+}
+
+const char* gatewayErrorString(int code) {
+  switch (code) {
+    case hal::HTTP_ERR_BEGIN:  return "frame too large for a datagram";
+    case GATEWAY_ERR_SOCKET:   return "UDP send failed";
+    case GATEWAY_ERR_TIMEOUT:  return "no ACK from gateway";
+    case GATEWAY_ERR_RESET:    return "gateway reset the exchange";
+  }
+  return "unknown error";
+}
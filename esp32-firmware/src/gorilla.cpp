@@ -0,0 +1,157 @@
+#include "gorilla.h"
+#include <string.h>
+
+// A full-width row: 4-bit escape + 32-bit timestamp, and per field the
+// 2-bit control + 5-bit leading zeros + 5-bit length + 32 bits
+static const uint32_t MAX_ROW_BITS = 36 + AGG_FIELD_COUNT * (2 + 5 + 5 + 32);
+static const uint8_t NO_WINDOW = 0xFF;
+
+// -------- Bit I/O (MSB first) --------
+static void putBits(HistoryBlock& b, uint32_t v, int n) {
+  while (n--) {
+    uint32_t at = b.bits++;
+    uint8_t mask = 0x80 >> (at & 7);
+    if ((v >> n) & 1) b.data[at >> 3] |= mask;
+    else b.data[at >> 3] &= ~mask;
+  }
+}
+
+static uint32_t getBits(const HistoryBlock& b, uint32_t& at, int n) {
+  uint32_t v = 0;
+  while (n--) {
+    v = v << 1 | ((b.data[at >> 3] >> (7 - (at & 7))) & 1);
+    at++;
+  }
+  return v;
+}
+
+static uint32_t floatBits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float bitsFloat(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+// -------- Encoder --------
+void HistoryStore::clear() {
+  head = live = 0;
+  for (int i = 0; i < count; i++) blocks[i].rows = blocks[i].bits = 0;
+}
+
+void HistoryStore::append(const HistoryRow& r) {
+  HistoryBlock* b = live ? &blocks[(head + live - 1) % count] : nullptr;
+
+  if (!b || b->bits + MAX_ROW_BITS > HistoryBlock::BYTES * 8) {
+    // Start a block: when all are in use the oldest becomes the new one
+    if (live < count) live++;
+    else head = (head + 1) % count;
+    b = &blocks[(head + live - 1) % count];
+    b->rows = b->bits = 0;
+
+    putBits(*b, r.t, 32);
+    for (int i = 0; i < AGG_FIELD_COUNT; i++) {
+      prevBits[i] = floatBits(r.v[i]);
+      prevLead[i] = NO_WINDOW;
+      putBits(*b, prevBits[i], 32);
+    }
+    prevT = r.t;
+    prevDelta = 0;
+    b->rows = 1;
+    return;
+  }
+
+  // Timestamp: delta of delta
+  int32_t delta = (int32_t)(r.t - prevT);
+  int32_t dod = delta - prevDelta;
+  if (dod == 0)                        putBits(*b, 0, 1);
+  else if (dod >= -63 && dod <= 64)     { putBits(*b, 0x2, 2);  putBits(*b, dod + 63, 7); }
+  else if (dod >= -255 && dod <= 256)   { putBits(*b, 0x6, 3);  putBits(*b, dod + 255, 9); }
+  else if (dod >= -2047 && dod <= 2048) { putBits(*b, 0xE, 4);  putBits(*b, dod + 2047, 12); }
+  else                                  { putBits(*b, 0xF, 4);  putBits(*b, (uint32_t)dod, 32); }
+  prevT = r.t;
+  prevDelta = delta;
+
+  // Values: XOR with the previous one; reuse the last bit window if it fits
+  for (int i = 0; i < AGG_FIELD_COUNT; i++) {
+    uint32_t bits = floatBits(r.v[i]);
+    uint32_t x = bits ^ prevBits[i];
+    prevBits[i] = bits;
+    if (!x) { putBits(*b, 0, 1); continue; }
+
+    uint8_t lead = __builtin_clz(x), trail = __builtin_ctz(x);  // x != 0: lead <= 31 fits 5 bits
+    if (prevLead[i] != NO_WINDOW && lead >= prevLead[i] && trail >= prevTrail[i]) {
+      putBits(*b, 0x2, 2);
+      putBits(*b, x >> prevTrail[i], 32 - prevLead[i] - prevTrail[i]);
+    } else {
+      int len = 32 - lead - trail;
+      putBits(*b, 0x3, 2);
+      putBits(*b, lead, 5);
+      putBits(*b, len - 1, 5);
+      putBits(*b, x >> trail, len);
+      prevLead[i] = lead;
+      prevTrail[i] = trail;
+    }
+  }
+  b->rows++;
+}
+
+// -------- Decoder --------
+void HistoryStore::scan(uint32_t fromT, bool (*fn)(void* ctx, const HistoryRow& r), void* ctx) const {
+  for (int k = 0; k < live; k++) {
+    const HistoryBlock& b = blocks[(head + k) % count];
+    uint32_t at = 0;
+    HistoryRow row;
+    uint32_t bits[AGG_FIELD_COUNT];
+    uint8_t lead[AGG_FIELD_COUNT], trail[AGG_FIELD_COUNT];
+    int32_t delta = 0;
+
+    for (uint16_t n = 0; n < b.rows; n++) {
+      if (n == 0) {
+        row.t = getBits(b, at, 32);
+        for (int i = 0; i < AGG_FIELD_COUNT; i++) {
+          bits[i] = getBits(b, at, 32);
+          lead[i] = NO_WINDOW;
+        }
+      } else {
+        int32_t dod;
+        if (!getBits(b, at, 1))      dod = 0;
+        else if (!getBits(b, at, 1)) dod = (int32_t)getBits(b, at, 7) - 63;
+        else if (!getBits(b, at, 1)) dod = (int32_t)getBits(b, at, 9) - 255;
+        else if (!getBits(b, at, 1)) dod = (int32_t)getBits(b, at, 12) - 2047;
+        else                         dod = (int32_t)getBits(b, at, 32);
+        delta += dod;
+        row.t += delta;
+
+        for (int i = 0; i < AGG_FIELD_COUNT; i++) {
+          if (!getBits(b, at, 1)) continue;
+          if (!getBits(b, at, 1)) {
+            bits[i] ^= getBits(b, at, 32 - lead[i] - trail[i]) << trail[i];
+          } else {
+            lead[i] = getBits(b, at, 5);
+            int len = getBits(b, at, 5) + 1;
+            trail[i] = 32 - lead[i] - len;
+            bits[i] ^= getBits(b, at, len) << trail[i];
+          }
+        }
+      }
+      if (row.t < fromT) continue;
+      for (int i = 0; i < AGG_FIELD_COUNT; i++) row.v[i] = bitsFloat(bits[i]);
+      if (!fn(ctx, row)) return;
+    }
+  }
+}
+
+uint32_t HistoryStore::rows() const {
+  uint32_t n = 0;
+  for (int k = 0; k < live; k++) n += blocks[(head + k) % count].rows;
+  return n;
+}
+
+size_t HistoryStore::bytesUsed() const {
+  size_t n = 0;
+  for (int k = 0; k < live; k++) n += (blocks[(head + k) % count].bits + 7) / 8;
+  return n;
+}
+
+bool HistoryStore::oldest(uint32_t& t) const {
+  if (!live) return false;
+  uint32_t at = 0;
+  t = getBits(blocks[head], at, 32);
+  return true;
+}
@@ -0,0 +1,525 @@
+// ===================================================
+// HAL: ESP32 / Arduino implementation
+// ===================================================
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <WiFiUdp.h>
+#include <WebServer.h>
+#include <ESPmDNS.h>
+#include <DHT.h>
+#include <Adafruit_Sensor.h>
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+#include "hal.h"
+#include "config.h"
+#include "adc_cal.h"
+#include "trace.h"
+#include "memstats.h"
+
+static DHT dht(DHTPIN, DHTTYPE);
+
+namespace hal {
+
+// -------- Clock --------
+uint32_t millis() { return ::millis(); }
+uint32_t micros() { return ::micros(); }
+void delayMs(uint32_t ms) { ::delay(ms); }  // vTaskDelay underneath
+void delayUs(uint32_t us) { ::delayMicroseconds(us); }
+void yield() { ::yield(); }
+
+// -------- GPIO --------
+void pinOutput(uint8_t pin) { pinMode(pin, OUTPUT); }
+void pinInput(uint8_t pin) { pinMode(pin, INPUT); }
+void digitalWrite(uint8_t pin, bool high) { ::digitalWrite(pin, high ? HIGH : LOW); }
+uint32_t pulseInHigh(uint8_t pin, uint32_t timeoutUs) { return ::pulseIn(pin, HIGH, timeoutUs); }
+
+// -------- ADC --------
+bool adcAttach(uint8_t pin, uint16_t maxMilliVolts) {
+  // Narrowest attenuation whose usable range covers the signal
+  adc_atten_t atten = maxMilliVolts <= 950  ? ADC_ATTEN_DB_0 :
+                      maxMilliVolts <= 1250 ? ADC_ATTEN_DB_2_5 :
+                      maxMilliVolts <= 1750 ? ADC_ATTEN_DB_6 : ADC_ATTEN_DB_11;
+  return ::adcAttach(pin, atten);
+}
+int adcReadRaw(uint8_t pin) { return ::adcReadRaw(pin); }
+uint16_t adcReadMilliVolts(uint8_t pin) { return ::adcReadMilliVolts(pin); }
+float adcMilliVoltsToRaw(uint8_t pin, float mv) { return ::adcMilliVoltsToRaw(pin, mv); }
+
+// -------- PWM --------
+void pwmAttach(uint8_t pin, uint8_t channel, uint32_t freqHz, uint8_t bits) {
+  ledcSetup(channel, freqHz, bits);
+  ledcAttachPin(pin, channel);
+}
+void pwmWrite(uint8_t channel, uint32_t duty) { ledcWrite(channel, duty); }
+
+// -------- DHT --------
+void dhtBegin() { dht.begin(); }
+void dhtRead(float& tempC, float& humidity) {
+  humidity = dht.readHumidity();
+  tempC = dht.readTemperature();
+}
+
+// -------- Network / HTTP --------
+void networkBegin(const char* ssid, const char* password) {
+  WiFi.begin(ssid, password);
+  Serial.print("[WiFi] Connecting");
+  while (WiFi.status() != WL_CONNECTED) { ::delay(500); Serial.print("."); }
+  Serial.printf("\n[WiFi] CONNECTED | IP: %s\n", WiFi.localIP().toString().c_str());
+}
+
+bool networkUp() { return WiFi.status() == WL_CONNECTED; }
+
+// One TLS connection is kept open across uplinks (HTTP/1.1 keep-alive), so
+// the handshake and its mbedTLS buffers are paid on (re)connect only. The
+// request is written by hand and the response parsed straight into the
+// caller's buffer: a POST on an open connection never touches the heap.
+// Error codes match HTTPClient's (and hal_native.cpp).
+// Timeouts are UPLINK_CONNECT_TIMEOUT_MS / UPLINK_READ_TIMEOUT_MS.
+static const int ERR_CONNECT = HTTP_ERR_CONNECT, ERR_SEND = -3, ERR_NO_RESPONSE = -4, ERR_TIMEOUT = -11;
+
+static WiFiClientSecure tls;
+static char     tlsHost[64];
+static uint16_t tlsPort = 0;
+
+static bool tlsOpen(const char* host, uint16_t port) {
+  return tlsPort == port && !strcmp(tlsHost, host) && tls.connected();
+}
+
+// By address when we have one (no lookup), still naming `host` for SNI
+static bool tlsConnect(const char* host, uint16_t port, uint32_t ipv4) {
+  TRACE_SCOPE(TRACE_CONNECT);
+  MEM_REGION(MEM_TLS);
+  tls.stop();
+  tls.setInsecure();
+  tls.setTimeout(UPLINK_READ_TIMEOUT_MS / 1000);  // seconds in this class
+  tls.setHandshakeTimeout(UPLINK_CONNECT_TIMEOUT_MS / 1000);
+  bool ok = ipv4 ? tls.connect(IPAddress(ipv4), port, host, nullptr, nullptr, nullptr)
+                 : tls.connect(host, port, UPLINK_CONNECT_TIMEOUT_MS);
+  if (!ok) { tlsPort = 0; return false; }
+  snprintf(tlsHost, sizeof(tlsHost), "%s", host);
+  tlsPort = port;
+  return true;
+}
+
+// One header/status line without the CRLF; -1 on timeout
+static int readLine(char* buf, size_t cap) {
+  size_t n = tls.readBytesUntil('\n', buf, cap - 1);
+  if (!n && !tls.connected()) return -1;
+  if (n && buf[n - 1] == '\r') n--;
+  buf[n] = '\0';
+  return (int)n;
+}
+
+// Read `n` body bytes (all of them until close if n < 0), keeping what fits
+static bool readBody(long n, char* resp, size_t respCap, size_t& got) {
+  char scratch[64];
+  while (n != 0) {
+    size_t want = n < 0 || n > (long)sizeof(scratch) ? sizeof(scratch) : (size_t)n;
+    char* dst = got + want < respCap ? resp + got : scratch;
+    size_t r = tls.readBytes(dst, want);
+    if (!r) return n < 0;  // EOF is the end of an unframed body
+    if (dst == scratch && got + 1 < respCap) {
+      size_t keep = min(r, respCap - 1 - got);
+      memcpy(resp + got, scratch, keep);
+      got += keep;
+    } else if (dst != scratch) {
+      got += r;
+    }
+    if (n > 0) n -= r;
+  }
+  return true;
+}
+
+static int exchange(const char* host, uint16_t port, const char* path,
+                    const char* contentType, const uint8_t* body, size_t len,
+                    char* resp, size_t respCap) {
+  char line[256];
+  int hl = snprintf(line, sizeof(line),
+                    "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: %s\r\n"
+                    "Content-Length: %u\r\nConnection: keep-alive\r\n\r\n",
+                    path, host, contentType, (unsigned)len);
+  if (hl <= 0 || hl >= (int)sizeof(line)) return HTTP_ERR_BEGIN;
+  if (tls.write((const uint8_t*)line, hl) != (size_t)hl || tls.write(body, len) != len) return ERR_SEND;
+
+  int code = 0;
+  if (readLine(line, sizeof(line)) < 0) return ERR_NO_RESPONSE;
+  if (sscanf(line, "HTTP/%*s %d", &code) != 1) return ERR_NO_RESPONSE;
+
+  long contentLength = -1;
+  bool chunked = false, keepAlive = true;
+  for (;;) {
+    int n = readLine(line, sizeof(line));
+    if (n < 0) return ERR_TIMEOUT;
+    if (n == 0) break;
+    if (!strncasecmp(line, "Content-Length:", 15)) contentLength = strtol(line + 15, nullptr, 10);
+    else if (!strncasecmp(line, "Transfer-Encoding:", 18)) chunked = strcasestr(line + 18, "chunked");
+    else if (!strncasecmp(line, "Connection:", 11)) keepAlive = !strcasestr(line + 11, "close");
+  }
+
+  size_t got = 0;
+  bool ok = true;
+  if (chunked) {
+    for (;;) {
+      if (readLine(line, sizeof(line)) < 0) { ok = false; break; }
+      long size = strtol(line, nullptr, 16);
+      if (size <= 0) { while (readLine(line, sizeof(line)) > 0) {} break; }  // trailers
+      if (!readBody(size, resp, respCap, got) || readLine(line, sizeof(line)) < 0) { ok = false; break; }
+    }
+  } else {
+    ok = readBody(contentLength, resp, respCap, got);
+    if (contentLength < 0) keepAlive = false;
+  }
+  if (respCap) resp[got] = '\0';
+  if (!ok) { tls.stop(); tlsPort = 0; return ERR_TIMEOUT; }
+  if (!keepAlive) { tls.stop(); tlsPort = 0; }
+  return code;
+}
+
+int httpPost(const char* host, uint16_t port, const char* path,
+             const char* contentType, const uint8_t* body, size_t len,
+             char* resp, size_t respCap, HttpTiming* timing, uint32_t ipv4) {
+  uint32_t t0 = ::micros();
+  if (timing) timing->connectUs = 0;
+  if (respCap) resp[0] = '\0';
+
+  bool reused = tlsOpen(host, port);
+  if (!reused) {
+    bool ok = tlsConnect(host, port, ipv4);
+    if (timing) timing->connectUs = timing->totalUs = ::micros() - t0;
+    if (!ok) return ERR_CONNECT;
+  }
+
+  int code;
+  {
+    TRACE_SCOPE(TRACE_POST);
+    MEM_REGION(MEM_HTTP);
+    code = exchange(host, port, path, contentType, body, len, resp, respCap);
+  }
+  // The server may have dropped an idle connection we thought was open:
+  // reconnect once and resend
+  if (reused && (code == ERR_SEND || code == ERR_NO_RESPONSE)) {
+    uint32_t t1 = ::micros();
+    bool ok = tlsConnect(host, port, ipv4);
+    if (timing) timing->connectUs = ::micros() - t1;
+    if (!ok) code = ERR_CONNECT;
+    else {
+      TRACE_SCOPE(TRACE_POST);
+      MEM_REGION(MEM_HTTP);
+      code = exchange(host, port, path, contentType, body, len, resp, respCap);
+    }
+  }
+  if (code < 0 && code != HTTP_ERR_BEGIN) { tls.stop(); tlsPort = 0; }
+  if (timing) timing->totalUs = ::micros() - t0;
+  return code;
+}
+
+int httpWarm(const char* host, uint16_t port, uint32_t ipv4) {
+  if (tlsOpen(host, port)) return 0;
+  return tlsConnect(host, port, ipv4) ? 1 : ERR_CONNECT;
+}
+
+const char* httpErrorString(int code) {
+  switch (code) {
+    case HTTP_ERR_BEGIN:  return "bad URL or request setup";
+    case ERR_CONNECT:     return "connection refused";
+    case ERR_SEND:        return "send failed";
+    case ERR_NO_RESPONSE: return "no response";
+    case ERR_TIMEOUT:     return "read timeout";
+  }
+  return "unknown error";
+}
+
+// -------- Push channel socket --------
+static WiFiClient streamPlain;
+static WiFiClientSecure streamTls;
+static Client* stream = nullptr;
+
+bool streamConnect(const char* host, uint16_t port, bool useTls) {
+  TRACE_SCOPE(TRACE_CONNECT);
+  MEM_REGION(MEM_TLS);
+  streamClose();
+  if (useTls) {
+    streamTls.setInsecure();
+    streamTls.setTimeout(UPLINK_READ_TIMEOUT_MS / 1000);
+    streamTls.setHandshakeTimeout(UPLINK_CONNECT_TIMEOUT_MS / 1000);
+    if (!streamTls.connect(host, port, UPLINK_CONNECT_TIMEOUT_MS)) return false;
+    stream = &streamTls;
+  } else {
+    if (!streamPlain.connect(host, port, UPLINK_CONNECT_TIMEOUT_MS)) return false;
+    streamPlain.setNoDelay(true);
+    stream = &streamPlain;
+  }
+  return true;
+}
+
+bool streamConnected() { return stream && stream->connected(); }
+
+bool streamWrite(const uint8_t* data, size_t len) {
+  MEM_REGION(MEM_HTTP);
+  if (!stream || stream->write(data, len) != len) { streamClose(); return false; }
+  return true;
+}
+
+int streamRead(uint8_t* buf, size_t cap) {
+  if (!stream) return -1;
+  int n = stream->available();
+  if (n <= 0) return stream->connected() ? 0 : -1;
+  return stream->read(buf, min((size_t)n, cap));
+}
+
+void streamClose() {
+  if (stream) stream->stop();
+  stream = nullptr;
+}
+
+// -------- Datagram socket --------
+static WiFiUDP udp;
+static bool udpOpen = false;
+static IPAddress udpPeer;
+static uint16_t udpPeerPort = 0;
+
+bool udpBegin(uint16_t localPort) {
+  if (!udpOpen) udpOpen = udp.begin(localPort);
+  return udpOpen;
+}
+
+bool udpSend(const char* host, uint16_t port, const uint8_t* data, size_t len) {
+  MEM_REGION(MEM_HTTP);
+  IPAddress peer;
+  if (!udpOpen || !WiFi.hostByName(host, peer) || !udp.beginPacket(peer, port)) return false;
+  udpPeer = peer;
+  udpPeerPort = port;
+  udp.write(data, len);
+  return udp.endPacket();
+}
+
+int udpRecv(uint8_t* buf, size_t cap) {
+  while (udpOpen && udp.parsePacket() > 0) {
+    bool fromPeer = udpPeerPort && udp.remoteIP() == udpPeer && udp.remotePort() == udpPeerPort;
+    int n = fromPeer ? udp.read(buf, cap) : 0;
+    udp.flush();  // drop whatever didn't fit, or wasn't from the peer
+    if (n > 0) return n;
+  }
+  return 0;
+}
+
+// -------- DNS resolver socket --------
+static WiFiUDP resolverUdp;
+static bool resolverOpen = false;
+static IPAddress resolverServer;
+
+bool resolverSend(const uint8_t* data, size_t len) {
+  MEM_REGION(MEM_HTTP);
+  IPAddress server = WiFi.dnsIP();
+  if (!networkUp() || server == IPAddress((uint32_t)0)) return false;
+  // A fresh ephemeral port per query, so a spoofed answer has to guess it as well as the ID
+  if (resolverOpen) resolverUdp.stop();
+  resolverOpen = resolverUdp.begin(49152 + randomU32() % 16384);
+  resolverServer = server;
+  if (!resolverOpen || !resolverUdp.beginPacket(server, 53)) return false;
+  resolverUdp.write(data, len);
+  return resolverUdp.endPacket();
+}
+
+int resolverRecv(uint8_t* buf, size_t cap) {
+  while (resolverOpen && resolverUdp.parsePacket() > 0) {
+    bool fromServer = resolverUdp.remoteIP() == resolverServer && resolverUdp.remotePort() == 53;
+    int n = fromServer ? resolverUdp.read(buf, cap) : 0;
+    resolverUdp.flush();
+    if (n > 0) return n;
+  }
+  return 0;
+}
+
+// -------- Local HTTP server --------
+// WebServer (sync, polled). Every request goes to the one handler through
+// onNotFound; the reply is chunked because bodies are streamed.
+struct HttpConn {};
+static HttpConn conn;
+static WebServer* server = nullptr;
+static HttpServeFn serveFn = nullptr;
+
+static const char* methodName(HTTPMethod m) {
+  switch (m) {
+    case HTTP_GET:    return "GET";
+    case HTTP_POST:   return "POST";
+    case HTTP_PUT:    return "PUT";
+    case HTTP_DELETE: return "DELETE";
+    default:          return "OTHER";
+  }
+}
+
+// WebServer drops request headers it wasn't asked to keep
+static const char* KEPT_HEADERS[] = { "Authorization", "Upgrade", "Sec-WebSocket-Key" };
+
+bool httpServerBegin(uint16_t port, HttpServeFn fn) {
+  if (server) return false;
+  server = new WebServer(port);  // once, at boot
+  serveFn = fn;
+  server->onNotFound([]() { serveFn(&conn, methodName(server->method()), server->uri().c_str()); });
+  server->collectHeaders(KEPT_HEADERS, sizeof(KEPT_HEADERS) / sizeof(KEPT_HEADERS[0]));
+  server->begin();
+  Serial.printf("[HTTPD] listening on %s:%u\n", WiFi.localIP().toString().c_str(), port);
+  return true;
+}
+
+void httpServerPoll() { if (server) server->handleClient(); }
+
+void httpReplyBegin(HttpConn*, int status, const char* contentType) {
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(status, contentType, "");
+}
+
+void httpReplyWrite(HttpConn*, const char* data, size_t len) { server->sendContent(data, len); }
+
+const char* httpHeader(HttpConn*, const char* name) {
+  static char value[96];
+  if (!server->hasHeader(name)) return nullptr;
+  snprintf(value, sizeof(value), "%s", server->header(name).c_str());
+  return value;
+}
+
+size_t httpBody(HttpConn*, char* buf, size_t cap) {
+  // WebServer keeps a non-form body as the "plain" argument
+  const String& body = server->arg("plain");
+  if (!cap) return 0;
+  size_t n = body.length() < cap - 1 ? body.length() : cap - 1;
+  memcpy(buf, body.c_str(), n);
+  buf[n] = '\0';
+  return n;
+}
+
+// A WiFiClient copy shares the socket, so it stays open after WebServer
+// lets go of its own. WebServer still waits out HTTP_MAX_CLOSE_WAIT (2 s)
+// on it before taking the next request.
+static WiFiClient detached[HTTP_DETACHED_MAX];
+
+int httpDetach(HttpConn*) {
+  for (int i = 0; i < HTTP_DETACHED_MAX; i++) {
+    if (detached[i].connected()) continue;
+    detached[i] = server->client();
+    detached[i].setNoDelay(true);
+    return i;
+  }
+  return -1;
+}
+
+bool sockWrite(int s, const uint8_t* data, size_t len) {
+  MEM_REGION(MEM_HTTP);
+  if (detached[s].write(data, len) == len) return true;
+  detached[s].stop();
+  return false;
+}
+
+int sockRead(int s, uint8_t* buf, size_t cap) {
+  int n = detached[s].available();
+  if (n <= 0) return detached[s].connected() ? 0 : -1;
+  return detached[s].read(buf, min((size_t)n, cap));
+}
+
+void sockClose(int s) { detached[s].stop(); }
+
+// -------- Identity --------
+void deviceMac(uint8_t mac[6]) {
+  uint64_t efuse = ESP.getEfuseMac();  // first byte of the MAC in the low bits
+  for (int i = 0; i < 6; i++) mac[i] = efuse >> (8 * i);
+}
+
+uint32_t randomU32() { return esp_random(); }  // true random once the radio is up
+
+// -------- Service discovery --------
+// ESPmDNS answers from its own task and re-announces on reconnect
+bool mdnsAdvertise(const char* service, uint16_t port, const char* const* txt, size_t txtCount) {
+  uint8_t mac[6];
+  deviceMac(mac);
+  char host[32];
+  snprintf(host, sizeof(host), "%s-%02x%02x%02x", service, mac[3], mac[4], mac[5]);
+  if (!MDNS.begin(host)) {
+    Serial.println("[MDNS] responder failed to start");
+    return false;
+  }
+  MDNS.addService(service, "tcp", port);
+  for (size_t i = 0; i < txtCount; i++) {
+    char kv[64];
+    snprintf(kv, sizeof(kv), "%s", txt[i]);
+    char* eq = strchr(kv, '=');
+    if (!eq) continue;
+    *eq = '\0';
+    MDNS.addServiceTxt(service, "tcp", kv, eq + 1);
+  }
+  Serial.printf("[MDNS] %s.local, _%s._tcp port %u\n", host, service, port);
+  return true;
+}
+
+// -------- Memory --------
+HeapStats heapStats() {
+  HeapStats h;
+  h.freeBytes        = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  h.largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  h.minFreeBytes     = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  return h;
+}
+
+uint32_t stackHighWater(const char* task) {
+  TaskHandle_t h = nullptr;
+  if (task && !(h = xTaskGetHandle(task))) return 0;
+  return uxTaskGetStackHighWaterMark(h);  // bytes on ESP-IDF
+}
+
+// -------- Console --------
+void consoleBegin(uint32_t baud) {
+  Serial.setTxBufferSize(1024);  // room for a few deferred log lines per drain tick
+  Serial.begin(baud);
+}
+
+void logf(const char* fmt, ...) {
+  char buf[512];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return;
+  Serial.write((const uint8_t*)buf, min((size_t)n, sizeof(buf) - 1));
+}
+
+size_t consoleWriteSpace() { return Serial.availableForWrite(); }
+
+bool consoleReadLine(char* line, size_t cap) {
+  static char buf[64];
+  static size_t n = 0;
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\r') continue;
+    if (c == '\n') {
+      size_t m = min(n, cap - 1);
+      memcpy(line, buf, m);
+      line[m] = '\0';
+      n = 0;
+      return true;
+    }
+    if (n < sizeof(buf) - 1) buf[n++] = c;
+  }
+  return false;
+}
+
+}  // namespace hal
+
+// -------- Allocation hook --------
+// Linked with -Wl,--wrap=malloc,... (platformio.ini), so every allocation in
+// the image, core and WiFi stack included, passes through here.
+extern TaskHandle_t loopTaskHandle;  // Arduino core, main.cpp
+
+extern "C" {
+void* __real_malloc(size_t n);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t n);
+
+static inline void countAlloc(size_t n) {
+  memRecordAlloc(n, xTaskGetCurrentTaskHandle() == loopTaskHandle);
+}
+
+void* __wrap_malloc(size_t n) { countAlloc(n); return __real_malloc(n); }
+void* __wrap_calloc(size_t n, size_t size) { countAlloc(n * size); return __real_calloc(n, size); }
+void* __wrap_realloc(void* p, size_t n) { countAlloc(n); return __real_realloc(p, n); }
+}
@@ -0,0 +1,701 @@
+// ===================================================
+// HAL: Linux implementation (PlatformIO `native` env)
+// ===================================================
+// Wall clock (or a virtual one for the simulator), simulated pins (see
+// hal_native.h) and plain-HTTP uplink.
+// There is no TLS on the host: requests go to PLANTERBOX_HOST:PLANTERBOX_PORT
+// (default 127.0.0.1:3000, i.e. `npm run dev`) instead of the HTTPS host
+// the firmware is configured for.
+#include "hal.h"
+#include "hal_native.h"
+#include "config.h"
+#include "trace.h"
+#include "memstats.h"
+#include "mdns.h"
+#include <chrono>
+#include <new>
+#include <random>
+#include <thread>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static const int MAX_PINS = 64;
+static const int MAX_PWM = 16;
+
+static bool     pinLevels[MAX_PINS];
+static uint16_t adcMv[MAX_PINS];
+static float adcOffsetMv = 0, adcMvPerCount = 3300.0f / 4095.0f;  // setAdcCalibration()
+static uint32_t echoUs[MAX_PINS];
+static uint32_t pwmDuties[MAX_PWM];
+static float    dhtTemp = 24.0f, dhtHum = 55.0f;
+
+static bool     virtualClock = false;
+static uint64_t virtualUs = 0;
+static void   (*onClockAdvance)(uint64_t) = nullptr;
+static hal::native::HttpHandler httpHandler = nullptr;
+static bool     consoleMuted = false;
+
+static void initDefaults() {
+  static bool done = false;
+  if (done) return;
+  done = true;
+  adcMv[PH_SENSOR_PIN]    = 1276;  // pH ~7.0 with the local calibration
+  adcMv[PPM_SENSOR_PIN]   = 1905;  // ~800 ppm at 25 C
+  adcMv[WATER_SENSOR_PIN] = 1650;  // well above WATER_THRESHOLD
+  echoUs[ECHO_PIN]        = 1588;  // ~27 cm
+}
+
+namespace hal {
+
+// -------- Clock --------
+static const auto bootTime = std::chrono::steady_clock::now();
+
+static uint64_t nowUs() {
+  using namespace std::chrono;
+  if (virtualClock) return virtualUs;
+  return duration_cast<microseconds>(steady_clock::now() - bootTime).count();
+}
+
+uint32_t micros() { return (uint32_t)nowUs(); }
+uint32_t millis() { return (uint32_t)(nowUs() / 1000); }
+void delayMs(uint32_t ms) {
+  if (virtualClock) native::advanceClock(ms * 1000ULL);
+  else std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+void delayUs(uint32_t us) {
+  if (virtualClock) native::advanceClock(us);
+  else std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+void yield() { if (!virtualClock) std::this_thread::yield(); }
+
+// -------- GPIO --------
+void pinOutput(uint8_t) { initDefaults(); }
+void pinInput(uint8_t) { initDefaults(); }
+void digitalWrite(uint8_t pin, bool high) { if (pin < MAX_PINS) pinLevels[pin] = high; }
+uint32_t pulseInHigh(uint8_t pin, uint32_t timeoutUs) {
+  initDefaults();
+  uint32_t us = pin < MAX_PINS ? echoUs[pin] : 0;
+  if (us > timeoutUs) us = 0;
+  if (virtualClock) native::advanceClock(us ? us : timeoutUs);
+  return us;
+}
+
+// -------- ADC --------
+bool adcAttach(uint8_t pin, uint16_t) { initDefaults(); return pin < MAX_PINS; }
+// Calibrated readings floor at the offset, where the raw count is 0
+uint16_t adcReadMilliVolts(uint8_t pin) {
+  initDefaults();
+  return adcMv[pin] > adcOffsetMv ? adcMv[pin] : (uint16_t)lroundf(adcOffsetMv);
+}
+int adcReadRaw(uint8_t pin) { return (int)lroundf(adcMilliVoltsToRaw(pin, adcReadMilliVolts(pin))); }
+float adcMilliVoltsToRaw(uint8_t, float mv) {
+  float raw = (mv - adcOffsetMv) / adcMvPerCount;
+  return raw < 0 ? 0 : raw > 4095 ? 4095 : raw;
+}
+
+// -------- PWM --------
+void pwmAttach(uint8_t, uint8_t, uint32_t, uint8_t) {}
+void pwmWrite(uint8_t channel, uint32_t duty) { if (channel < MAX_PWM) pwmDuties[channel] = duty; }
+
+// -------- DHT --------
+void dhtBegin() {}
+void dhtRead(float& tempC, float& humidity) { tempC = dhtTemp; humidity = dhtHum; }
+
+// -------- Network / HTTP --------
+void networkBegin(const char*, const char*) { logf("[NET] host network, no WiFi join\n"); }
+bool networkUp() { return true; }
+
+// Same codes as the Arduino HTTPClient where they overlap
+static const int ERR_CONNECT = HTTP_ERR_CONNECT, ERR_SEND = -3, ERR_NO_RESPONSE = -4, ERR_TIMEOUT = -11;
+
+static int connectTo(const char* host, const char* port) {
+  addrinfo hints = {}, *res = nullptr;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, port, &hints, &res) != 0) return -1;
+  int fd = -1;
+  for (addrinfo* a = res; a; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd < 0) continue;
+    // On Linux the send timeout also bounds connect()
+    timeval rcv = { UPLINK_READ_TIMEOUT_MS / 1000, (UPLINK_READ_TIMEOUT_MS % 1000) * 1000 };
+    timeval snd = { UPLINK_CONNECT_TIMEOUT_MS / 1000, (UPLINK_CONNECT_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &rcv, sizeof(rcv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &snd, sizeof(snd));
+    if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) break;
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+static bool sendAll(int fd, const void* data, size_t len) {
+  const char* p = (const char*)data;
+  while (len) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    p += n; len -= n;
+  }
+  return true;
+}
+
+// In-place decode of a chunked body; returns the decoded length
+static size_t dechunk(char* body, size_t len) {
+  size_t in = 0, out = 0;
+  while (in < len) {
+    size_t size = strtoul(body + in, nullptr, 16);
+    char* eol = strstr(body + in, "\r\n");
+    if (!eol || size == 0) break;
+    in = (eol - body) + 2;
+    if (in + size > len) size = len - in;
+    memmove(body + out, body + in, size);
+    out += size;
+    in += size + 2;
+  }
+  return out;
+}
+
+// The dev server: PLANTERBOX_HOST:PLANTERBOX_PORT (127.0.0.1:3000), or the
+// given address on that port; returns the port. Plain HTTP, a connection
+// per request: one opened by httpWarm() is used by the next POST.
+static int warmFd = -1;
+
+static const char* serverAddr(uint32_t ipv4, char* host, size_t cap) {
+  const char* h = getenv("PLANTERBOX_HOST");
+  const char* port = getenv("PLANTERBOX_PORT");
+  if (ipv4) inet_ntop(AF_INET, &ipv4, host, cap);
+  else snprintf(host, cap, "%s", h ? h : "127.0.0.1");
+  return port ? port : "3000";
+}
+
+int httpPost(const char*, uint16_t, const char* path,
+             const char* contentType, const uint8_t* body, size_t len,
+             char* resp, size_t respCap, HttpTiming* timing, uint32_t ipv4) {
+  uint32_t t0 = micros();
+  if (httpHandler) {
+    TRACE_SCOPE(TRACE_POST);
+    int code = httpHandler(path, contentType, body, len, resp, respCap);
+    if (timing) { timing->connectUs = 0; timing->totalUs = micros() - t0; }
+    return code;
+  }
+
+  char host[64];
+  const char* port = serverAddr(ipv4, host, sizeof(host));
+  int fd = warmFd;
+  warmFd = -1;
+  char probe;
+  if (fd >= 0 && recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {  // closed while it waited
+    close(fd);
+    fd = -1;
+  }
+  if (fd < 0) {
+    TRACE_SCOPE(TRACE_CONNECT);
+    fd = connectTo(host, port);
+    if (timing) timing->connectUs = timing->totalUs = micros() - t0;
+  } else if (timing) {
+    timing->connectUs = 0;
+  }
+  if (fd < 0) return ERR_CONNECT;
+  TRACE_SCOPE(TRACE_POST);
+
+  char head[512];
+  int hl = snprintf(head, sizeof(head),
+                    "POST %s HTTP/1.1\r\nHost: %s:%s\r\nContent-Type: %s\r\n"
+                    "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                    path, host, port, contentType, len);
+  if (!sendAll(fd, head, hl) || !sendAll(fd, body, len)) { close(fd); return ERR_SEND; }
+
+  static char raw[16384];
+  size_t got = 0;
+  for (;;) {
+    ssize_t n = recv(fd, raw + got, sizeof(raw) - 1 - got, 0);
+    if (n < 0) { close(fd); return got ? ERR_TIMEOUT : ERR_NO_RESPONSE; }
+    if (n == 0 || got + n >= sizeof(raw) - 1) { got += n; break; }
+    got += n;
+  }
+  close(fd);
+  raw[got] = '\0';
+
+  int code = 0;
+  if (sscanf(raw, "HTTP/%*s %d", &code) != 1) return ERR_NO_RESPONSE;
+  char* bodyStart = strstr(raw, "\r\n\r\n");
+  size_t bodyLen = 0;
+  if (bodyStart) {
+    *bodyStart = '\0';
+    bodyStart += 4;
+    bodyLen = got - (bodyStart - raw);
+    if (strcasestr(raw, "transfer-encoding: chunked")) bodyLen = dechunk(bodyStart, bodyLen);
+  }
+  if (respCap) {
+    size_t n = bodyLen < respCap - 1 ? bodyLen : respCap - 1;
+    if (n) memcpy(resp, bodyStart, n);
+    resp[n] = '\0';
+  }
+  if (timing) timing->totalUs = micros() - t0;
+  return code;
+}
+
+int httpWarm(const char*, uint16_t, uint32_t ipv4) {
+  if (httpHandler || warmFd >= 0) return 0;  // the simulator's server needs no connection
+  char host[64];
+  const char* port = serverAddr(ipv4, host, sizeof(host));
+  TRACE_SCOPE(TRACE_CONNECT);
+  warmFd = connectTo(host, port);
+  return warmFd >= 0 ? 1 : ERR_CONNECT;
+}
+
+const char* httpErrorString(int code) {
+  switch (code) {
+    case HTTP_ERR_BEGIN:  return "begin() failed (bad URL or client)";
+    case ERR_CONNECT:     return "connection refused";
+    case ERR_SEND:        return "send failed";
+    case ERR_NO_RESPONSE: return "no response";
+    case ERR_TIMEOUT:     return "read timeout";
+  }
+  return "unknown error";
+}
+
+// -------- DNS resolver socket --------
+static int resolverFd = -1;
+static sockaddr_in resolverAddr;
+
+bool resolverSend(const uint8_t* data, size_t len) {
+  const char* server = getenv("PLANTERBOX_DNS");
+  if (!server || virtualClock) return false;
+  char host[64];
+  snprintf(host, sizeof(host), "%s", server);
+  char* colon = strchr(host, ':');
+  sockaddr_in to = {};
+  to.sin_family = AF_INET;
+  to.sin_port = htons(colon ? atoi(colon + 1) : 53);
+  if (colon) *colon = '\0';
+  if (inet_pton(AF_INET, host, &to.sin_addr) != 1) return false;
+  // A new socket (new ephemeral port) per query, as on the ESP32
+  if (resolverFd >= 0) close(resolverFd);
+  resolverFd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (resolverFd < 0) return false;
+  fcntl(resolverFd, F_SETFL, O_NONBLOCK);
+  resolverAddr = to;
+  return sendto(resolverFd, data, len, 0, (sockaddr*)&to, sizeof(to)) == (ssize_t)len;
+}
+
+int resolverRecv(uint8_t* buf, size_t cap) {
+  if (resolverFd < 0) return 0;
+  for (;;) {
+    sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    ssize_t n = recvfrom(resolverFd, buf, cap, 0, (sockaddr*)&from, &fromLen);
+    if (n <= 0) return 0;
+    if (from.sin_addr.s_addr == resolverAddr.sin_addr.s_addr && from.sin_port == resolverAddr.sin_port)
+      return (int)n;
+  }
+}
+
+// -------- Push channel socket --------
+// Plain TCP to PLANTERBOX_MQTT_HOST:PLANTERBOX_MQTT_PORT when set (e.g. a
+// local mosquitto or tools/mqtt_bridge), else the configured broker.
+static int streamFd = -1;
+
+bool streamConnect(const char* host, uint16_t port, bool) {
+  streamClose();
+  if (virtualClock) return false;  // no sockets in the simulator
+  const char* h = getenv("PLANTERBOX_MQTT_HOST");
+  const char* p = getenv("PLANTERBOX_MQTT_PORT");
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%u", port);
+  streamFd = connectTo(h ? h : host, p ? p : portStr);
+  if (streamFd < 0) return false;
+  fcntl(streamFd, F_SETFL, O_NONBLOCK);
+  return true;
+}
+
+bool streamConnected() { return streamFd >= 0; }
+
+bool streamWrite(const uint8_t* data, size_t len) {
+  // Non-blocking socket: wait out a full send buffer rather than split a packet
+  while (streamFd >= 0 && len) {
+    ssize_t n = send(streamFd, data, len, MSG_NOSIGNAL);
+    if (n > 0) { data += n; len -= n; continue; }
+    pollfd pw = { streamFd, POLLOUT, 0 };
+    if (n < 0 && errno == EAGAIN && poll(&pw, 1, 5000) == 1) continue;
+    streamClose();
+  }
+  return streamFd >= 0;
+}
+
+int streamRead(uint8_t* buf, size_t cap) {
+  if (streamFd < 0) return -1;
+  ssize_t n = recv(streamFd, buf, cap, 0);
+  if (n > 0) return (int)n;
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+  streamClose();
+  return -1;
+}
+
+void streamClose() {
+  if (streamFd >= 0) close(streamFd);
+  streamFd = -1;
+}
+
+// -------- Datagram socket --------
+// Ephemeral local port (a gateway on the same host has the CoAP one);
+// PLANTERBOX_GATEWAY_HOST / _PORT override the destination, like the MQTT
+// variables above.
+static int udpFd = -1;
+static sockaddr_in udpPeer;
+
+bool udpBegin(uint16_t) {
+  if (virtualClock) return false;  // no sockets in the simulator
+  if (udpFd >= 0) return true;
+  udpFd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (udpFd < 0) return false;
+  fcntl(udpFd, F_SETFL, O_NONBLOCK);
+  return true;
+}
+
+bool udpSend(const char* host, uint16_t port, const uint8_t* data, size_t len) {
+  if (udpFd < 0) return false;
+  const char* h = getenv("PLANTERBOX_GATEWAY_HOST");
+  const char* p = getenv("PLANTERBOX_GATEWAY_PORT");
+  char portStr[8];
+  snprintf(portStr, sizeof(portStr), "%u", port);
+  addrinfo hints = {}, *res = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  if (getaddrinfo(h ? h : host, p ? p : portStr, &hints, &res) != 0) return false;
+  bool ok = sendto(udpFd, data, len, 0, res->ai_addr, res->ai_addrlen) == (ssize_t)len;
+  if (ok) memcpy(&udpPeer, res->ai_addr, sizeof(udpPeer));
+  freeaddrinfo(res);
+  return ok;
+}
+
+int udpRecv(uint8_t* buf, size_t cap) {
+  if (udpFd < 0) return 0;
+  for (;;) {
+    sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    // excess bytes of the datagram are discarded
+    ssize_t n = recvfrom(udpFd, buf, cap, 0, (sockaddr*)&from, &fromLen);
+    if (n <= 0) return 0;
+    if (from.sin_addr.s_addr == udpPeer.sin_addr.s_addr && from.sin_port == udpPeer.sin_port)
+      return (int)n;
+  }
+}
+
+// -------- Local HTTP server --------
+// Non-blocking listener, one short-lived connection per poll. Binds
+// PLANTERBOX_LOCAL_PORT if set, else 8080: ports below 1024 need root.
+struct HttpConn {
+  int fd;
+  char* head;        // request line + headers, NUL-terminated
+  const char* body;
+  size_t bodyLen;
+  bool detached;
+};
+static int listenFd = -1;
+static uint16_t listenPort = 0;
+static HttpServeFn serveFn = nullptr;
+static int detachedFd[HTTP_DETACHED_MAX] = { -1, -1, -1, -1 };
+
+bool httpServerBegin(uint16_t, HttpServeFn fn) {
+  if (virtualClock || listenFd >= 0) return false;  // no sockets in the simulator
+  const char* env = getenv("PLANTERBOX_LOCAL_PORT");
+  uint16_t port = env ? (uint16_t)atoi(env) : 8080;
+
+  listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 4) != 0) {
+    logf("[HTTPD] cannot listen on :%u\n", port);
+    close(listenFd);
+    listenFd = -1;
+    return false;
+  }
+  fcntl(listenFd, F_SETFL, O_NONBLOCK);
+  listenPort = port;
+  serveFn = fn;
+  logf("[HTTPD] listening on :%u\n", port);
+  return true;
+}
+
+void httpServerPoll() {
+  if (listenFd < 0) return;
+  int fd = accept(listenFd, nullptr, nullptr);
+  if (fd < 0) return;
+  timeval tv = { 0, 200000 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  // Headers, then as much body as Content-Length announces (and fits)
+  char req[4096];
+  size_t got = 0, want = 0;
+  char* end = nullptr;
+  while (got < sizeof(req) - 1 && (!end || got < want)) {
+    ssize_t n = recv(fd, req + got, sizeof(req) - 1 - got, 0);
+    if (n <= 0) break;
+    got += n;
+    req[got] = '\0';
+    if (!end && (end = strstr(req, "\r\n\r\n"))) {
+      const char* cl = strcasestr(req, "\r\ncontent-length:");
+      want = (end - req) + 4 + (cl && cl < end ? strtoul(cl + 17, nullptr, 10) : 0);
+    }
+  }
+  char method[8], path[256];
+  if (end && sscanf(req, "%7s %255s", method, path) == 2) {
+    *end = '\0';
+    char* query = strchr(path, '?');
+    if (query) *query = '\0';
+    HttpConn c = { fd, req, end + 4, got - (end + 4 - req), false };
+    serveFn(&c, method, path);
+    if (c.detached) return;
+  }
+  close(fd);
+}
+
+void httpReplyBegin(HttpConn* c, int status, const char* contentType) {
+  char head[160];
+  int hl = snprintf(head, sizeof(head),
+                    "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nConnection: close\r\n\r\n",
+                    status, status < 400 ? "OK" : "Error", contentType);
+  sendAll(c->fd, head, hl);
+}
+
+void httpReplyWrite(HttpConn* c, const char* data, size_t len) { sendAll(c->fd, data, len); }
+
+const char* httpHeader(HttpConn* c, const char* name) {
+  static char value[96];
+  size_t n = strlen(name);
+  for (const char* line = strstr(c->head, "\r\n"); line; line = strstr(line + 2, "\r\n")) {
+    if (strncasecmp(line + 2, name, n) || line[2 + n] != ':') continue;
+    const char* v = line + 3 + n;
+    while (*v == ' ') v++;
+    size_t len = strcspn(v, "\r");
+    if (len >= sizeof(value)) len = sizeof(value) - 1;
+    memcpy(value, v, len);
+    value[len] = '\0';
+    return value;
+  }
+  return nullptr;
+}
+
+size_t httpBody(HttpConn* c, char* buf, size_t cap) {
+  if (!cap) return 0;
+  size_t n = c->bodyLen < cap - 1 ? c->bodyLen : cap - 1;
+  memcpy(buf, c->body, n);
+  buf[n] = '\0';
+  return n;
+}
+
+int httpDetach(HttpConn* c) {
+  for (int i = 0; i < HTTP_DETACHED_MAX; i++) {
+    if (detachedFd[i] >= 0) continue;
+    fcntl(c->fd, F_SETFL, O_NONBLOCK);
+    detachedFd[i] = c->fd;
+    c->detached = true;
+    return i;
+  }
+  return -1;
+}
+
+bool sockWrite(int s, const uint8_t* data, size_t len) {
+  // Non-blocking: a client that lets its receive window fill up is dropped
+  if (detachedFd[s] >= 0 && sendAll(detachedFd[s], data, len)) return true;
+  sockClose(s);
+  return false;
+}
+
+int sockRead(int s, uint8_t* buf, size_t cap) {
+  if (detachedFd[s] < 0) return -1;
+  ssize_t n = recv(detachedFd[s], buf, cap, 0);
+  if (n > 0) return (int)n;
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+  sockClose(s);
+  return -1;
+}
+
+void sockClose(int s) {
+  if (detachedFd[s] >= 0) close(detachedFd[s]);
+  detachedFd[s] = -1;
+}
+
+// -------- Identity --------
+// 02:xx:... is locally administered, so it can't collide with a real board
+void deviceMac(uint8_t mac[6]) {
+  char host[64] = "";
+  gethostname(host, sizeof(host) - 1);
+  const char* port = getenv("PLANTERBOX_LOCAL_PORT");
+  uint32_t h = 2166136261u;  // FNV-1a over "host:port"
+  for (const char* p = host; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+  h = (h ^ ':') * 16777619u;
+  for (const char* p = port ? port : "8080"; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+  mac[0] = 0x02;
+  mac[1] = 0x50;  // 'P'
+  for (int i = 0; i < 4; i++) mac[2 + i] = h >> (24 - 8 * i);
+}
+
+uint32_t randomU32() {
+  static std::random_device rd;
+  return rd();
+}
+
+// -------- Service discovery --------
+// A small responder thread on 224.0.0.251:5353, shared (SO_REUSEADDR)
+// with any other instance on the host. The host name carries the HTTP port
+// so simulated fleets on one machine stay distinct; the address is left
+// out and collectors use the reply's source. Queries from a port other
+// than 5353 (one-shot resolvers, tools/fleet_collector.cpp) get a unicast
+// reply, everything else a multicast one (RFC 6762 section 6.7).
+static uint8_t mdnsReply[512];
+static size_t mdnsReplyLen = 0;
+
+static void mdnsServe(int fd, const char* serviceName) {
+  for (;;) {
+    uint8_t q[512];
+    sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    ssize_t n = recvfrom(fd, q, sizeof(q), 0, (sockaddr*)&from, &fromLen);
+    uint16_t id;
+    if (n <= 0 || !mdnsAsks(q, n, serviceName, id)) continue;
+    uint8_t out[sizeof(mdnsReply)];
+    memcpy(out, mdnsReply, mdnsReplyLen);
+    sockaddr_in to = from;
+    if (ntohs(from.sin_port) == 5353) {
+      id = 0;
+      to.sin_addr.s_addr = inet_addr("224.0.0.251");
+    }
+    out[0] = id >> 8;
+    out[1] = id;
+    sendto(fd, out, mdnsReplyLen, 0, (sockaddr*)&to, sizeof(to));
+  }
+}
+
+bool mdnsAdvertise(const char* service, uint16_t port, const char* const* txt, size_t txtCount) {
+  if (virtualClock || mdnsReplyLen) return false;  // no sockets in the simulator
+  if (listenFd >= 0) port = listenPort;  // the port actually bound, not the ESP32's
+  static char serviceName[32];
+  snprintf(serviceName, sizeof(serviceName), "_%s._tcp.local", service);
+  MdnsService s;
+  snprintf(s.host, sizeof(s.host), "%s-%u.local", service, port);
+  snprintf(s.instance, sizeof(s.instance), "%s-%u.%s", service, port, serviceName);
+  s.port = port;
+  for (size_t i = 0; i < txtCount && s.txtCount < MDNS_MAX_TXT; i++)
+    snprintf(s.txt[s.txtCount++], sizeof(s.txt[0]), "%s", txt[i]);
+  mdnsReplyLen = mdnsAnswer(mdnsReply, sizeof(mdnsReply), 0, serviceName, s);
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(5353);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  ip_mreq group = {};
+  group.imr_multiaddr.s_addr = inet_addr("224.0.0.251");
+  group.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (!mdnsReplyLen || bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+      setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) != 0) {
+    logf("[MDNS] cannot join 224.0.0.251:5353\n");
+    close(fd);
+    mdnsReplyLen = 0;
+    return false;
+  }
+  // Announce once, then answer queries
+  sockaddr_in to = addr;
+  to.sin_addr.s_addr = group.imr_multiaddr.s_addr;
+  sendto(fd, mdnsReply, mdnsReplyLen, 0, (sockaddr*)&to, sizeof(to));
+  std::thread(mdnsServe, fd, serviceName).detach();
+  logf("[MDNS] %s, %s port %u\n", s.host, serviceName, port);
+  return true;
+}
+
+// -------- Console --------
+void consoleBegin(uint32_t) { setvbuf(stdout, nullptr, _IOLBF, 0); }
+
+void logf(const char* fmt, ...) {
+  if (consoleMuted) return;
+  va_list ap;
+  va_start(ap, fmt);
+  vfprintf(stdout, fmt, ap);
+  va_end(ap);
+}
+
+size_t consoleWriteSpace() { return SIZE_MAX; }  // stdout never backs up the loop
+
+bool consoleReadLine(char* line, size_t cap) {
+  if (virtualClock) return false;  // the simulator owns stdin/stdout
+  static char buf[64];
+  static size_t n = 0;
+  pollfd p = { 0, POLLIN, 0 };
+  while (poll(&p, 1, 0) == 1 && (p.revents & POLLIN)) {
+    char c;
+    if (read(0, &c, 1) != 1) return false;
+    if (c == '\r') continue;
+    if (c == '\n') {
+      size_t m = n < cap - 1 ? n : cap - 1;
+      memcpy(line, buf, m);
+      line[m] = '\0';
+      n = 0;
+      return true;
+    }
+    if (n < sizeof(buf) - 1) buf[n++] = c;
+  }
+  return false;
+}
+
+// -------- Memory --------
+// glibc's heap grows on demand, so there is no meaningful free/largest
+// figure to report; allocation counting below still works.
+HeapStats heapStats() { return HeapStats(); }
+uint32_t stackHighWater(const char*) { return 0; }
+
+// -------- Host-only hooks --------
+namespace native {
+void setAdcMilliVolts(uint8_t pin, uint16_t mv) { initDefaults(); if (pin < MAX_PINS) adcMv[pin] = mv; }
+void setAdcCalibration(float offsetMv, float mvPerCount) { adcOffsetMv = offsetMv; adcMvPerCount = mvPerCount; }
+void setEchoPulseUs(uint8_t pin, uint32_t us) { initDefaults(); if (pin < MAX_PINS) echoUs[pin] = us; }
+void setDht(float tempC, float humidity) { dhtTemp = tempC; dhtHum = humidity; }
+bool pinLevel(uint8_t pin) { return pin < MAX_PINS && pinLevels[pin]; }
+uint32_t pwmDuty(uint8_t channel) { return channel < MAX_PWM ? pwmDuties[channel] : 0; }
+
+void useVirtualClock(void (*onAdvance)(uint64_t)) {
+  virtualUs = nowUs();  // continue from wherever the wall clock was
+  virtualClock = true;
+  onClockAdvance = onAdvance;
+}
+void advanceClock(uint64_t us) {
+  virtualUs += us;
+  if (onClockAdvance) onClockAdvance(virtualUs);
+}
+uint64_t clockUs() { return nowUs(); }
+
+void setHttpHandler(HttpHandler fn) { httpHandler = fn; }
+void setConsoleMuted(bool muted) { consoleMuted = muted; }
+}  // namespace native
+
+}  // namespace hal
+
+// -------- Allocation hook --------
+// C++ allocations only (ArduinoJson's pool goes through malloc directly);
+// the firmware runs on a single thread here, so all of it is loop task.
+void* operator new(size_t n) {
+  memRecordAlloc(n, true);
+  if (void* p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
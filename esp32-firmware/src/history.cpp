@@ -0,0 +1,35 @@
+#include "history.h"
+#include "config.h"
+#include "hal.h"
+#include <math.h>
+
+static StaticHistory<HISTORY_BLOCKS> store;
+
+// Sensor resolution per AggField: finer digits are noise
+static const float RESOLUTION[AGG_FIELD_COUNT] = {
+  // temperature  humidity  distance  ppm   ph
+  0.1f,           1.0f,     0.1f,     1.0f, 0.01f
+};
+
+const HistoryStore& sensorHistory() { return store; }
+
+void historyTick() {
+  const float v[AGG_FIELD_COUNT] = { latestFrame.temperature, latestFrame.humidity,
+                                     latestFrame.distance, latestFrame.ppm, latestFrame.ph };
+  HistoryRow row;
+  row.t = hal::millis() / 1000;
+  for (int i = 0; i < AGG_FIELD_COUNT; i++) row.v[i] = roundf(v[i] / RESOLUTION[i]) * RESOLUTION[i];
+  store.append(row);
+}
+
+static bool renderRow(void* ctx, const HistoryRow& r) {
+  ((MetricsOut*)ctx)->printf("%lu,%.1f,%.0f,%.1f,%.0f,%.2f\n", (unsigned long)r.t,
+                             r.v[AGG_TEMPERATURE], r.v[AGG_HUMIDITY], r.v[AGG_DISTANCE],
+                             r.v[AGG_PPM], r.v[AGG_PH]);
+  return true;
+}
+
+void historyRender(MetricsOut& out, uint32_t sinceS) {
+  out.printf("t_s,temperature,humidity,distance,ppm,ph\n");
+  store.scan(sinceS, renderRow, &out);
+}
@@ -0,0 +1,19 @@
+#include "identity.h"
+#include "config.h"
+#include "hal.h"
+#include <stdio.h>
+
+const char* deviceId() {
+  static char id[32];
+  if (!id[0]) {
+    if (DEVICE_ID[0]) {
+      snprintf(id, sizeof(id), "%s", DEVICE_ID);
+    } else {
+      uint8_t mac[6];
+      hal::deviceMac(mac);
+      snprintf(id, sizeof(id), "planterbox-%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4],
+               mac[5]);
+    }
+  }
+  return id;
+}
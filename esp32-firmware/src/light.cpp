@@ -0,0 +1,73 @@
+#include "light.h"
+#include "config.h"
+#include "hal.h"
+#include "sensors.h"
+#include "stepper.h"
+#include "logger.h"
+#include <algorithm>
+
+static constexpr LogModule LOG_THIS = LOG_MOD_LIGHT;
+
+Stepper28BYJ stepper(MOTOR_IN1, MOTOR_IN2, MOTOR_IN3, MOTOR_IN4);
+unsigned long lastStepperMoveMs = 0;
+
+void lightBegin() {
+  stepper.begin();
+  hal::pwmAttach(LIGHT_PIN, ledChannel, ledFreq, ledResolution);
+}
+
+static int level = 0;
+static unsigned long overrideUntil = 0;
+
+static void setLevel(int brightness) {
+  level = std::min(std::max(brightness, 0), 255);
+  hal::pwmWrite(ledChannel, level);
+  LOGD("[LIGHT] PWM: %d (0-255)\n", level);
+}
+
+void controlGrowLight(int brightness) {
+  if ((long)(overrideUntil - hal::millis()) > 0) {  // wrap-safe
+    LOGD("[LIGHT] manual override, ignoring %d\n", brightness);
+    return;
+  }
+  setLevel(brightness);
+}
+
+void overrideGrowLight(int brightness, unsigned long holdMs) {
+  overrideUntil = hal::millis() + holdMs;
+  setLevel(brightness);
+  LOGI("[LIGHT] manual %d for %lu s\n", level, holdMs / 1000);
+}
+
+int growLightLevel() { return level; }
+
+void adjustLightHeightAuto() {
+  if (currentDistanceCm == 0.0f) {
+    LOGD("[STEPPER] Skipped adjust: no valid distance yet\n");
+    requestSample(SENSOR_DISTANCE);
+    return;
+  }
+  // Never act twice on the same (pre-move) distance reading
+  if (lastStepperMoveMs && (long)(lastDistanceReadMs - lastStepperMoveMs) < 0) {
+    LOGD("[STEPPER] Waiting for a fresh distance after last move\n");
+    return;
+  }
+
+  if (currentDistanceCm < TARGET_MIN_CM) {
+    LOGI("[STEPPER] Too close (%.2f < %.2f): moving UP, %d steps\n",
+         currentDistanceCm, TARGET_MIN_CM, LIGHT_ADJUST_STEPS);
+    for (int i=0;i<LIGHT_ADJUST_STEPS;i++){ stepper.step(true); hal::delayUs(MOTOR_STEP_DELAY_US);}
+    lastStepperMoveMs = hal::millis();
+    requestSample(SENSOR_DISTANCE);
+  } else if (currentDistanceCm > TARGET_MAX_CM) {
+    LOGI("[STEPPER] Too far (%.2f > %.2f): moving DOWN, %d steps\n",
+         currentDistanceCm, TARGET_MAX_CM, LIGHT_ADJUST_STEPS);
+    for (int i=0;i<LIGHT_ADJUST_STEPS;i++){ stepper.step(false); hal::delayUs(MOTOR_STEP_DELAY_US);}
+    lastStepperMoveMs = hal::millis();
+    requestSample(SENSOR_DISTANCE);
+  } else {
+    stepper.stop();
+    LOGD("[STEPPER] In range (%.2f within [%.2f, %.2f]): STOP\n",
+         currentDistanceCm, TARGET_MIN_CM, TARGET_MAX_CM);
+  }
+}
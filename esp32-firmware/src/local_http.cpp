@@ -0,0 +1,291 @@
+#include "local_http.h"
+#include "config.h"
+#include "hal.h"
+#include "metrics.h"
+#include "history.h"
+#include "sensors.h"
+#include "dosing.h"
+#include "light.h"
+#include "websocket.h"
+#include "identity.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ArduinoJson.h>
+
+static void writeReply(void* ctx, const char* s, size_t n) {
+  hal::httpReplyWrite((hal::HttpConn*)ctx, s, n);
+}
+
+static void replyJson(hal::HttpConn* c, int status, const char* json) {
+  hal::httpReplyBegin(c, status, "application/json");
+  hal::httpReplyWrite(c, json, strlen(json));
+}
+
+// -------- Live frame --------
+static const char* phStateName() {
+  switch (phState) {
+    case PH_IDLE:        return "idle";
+    case PH_DOSING_UP:   return "up";
+    case PH_DOSING_DOWN: return "down";
+  }
+  return "?";
+}
+
+static const char* ppmStateName() {
+  switch (ppmState) {
+    case PPM_IDLE:     return "idle";
+    case PPM_DOSING_A: return "a";
+    case PPM_DELAYING: return "delay";
+    case PPM_DOSING_B: return "b";
+  }
+  return "?";
+}
+
+static size_t liveJson(char* out, size_t cap) {
+  const SensorFrame& f = latestFrame;
+  int n = snprintf(out, cap,
+                   "{\"id\":\"%s\",\"fw\":\"%s\",\"t\":%lu,\"temperature\":%.1f,\"humidity\":%.1f,\"distance\":%.1f,\"ppm\":%.0f,"
+                   "\"ph\":%.2f,\"water_sufficient\":%s,\"light\":%d,\"ph_pump\":\"%s\",\"ppm_pump\":\"%s\","
+                   "\"lockout_ms\":%lu}",
+                   deviceId(), FIRMWARE_VERSION, (unsigned long)hal::millis(), f.temperature, f.humidity, f.distance, f.ppm, f.ph,
+                   f.waterSufficient ? "true" : "false", growLightLevel(), phStateName(), ppmStateName(),
+                   lockoutRemaining());
+  return n > 0 && (size_t)n < cap ? n : 0;
+}
+
+// -------- WebSocket clients --------
+struct LiveClient {
+  int sock = -1;
+  uint8_t rx[128];  // control frames only; browsers send nothing else here
+  size_t have = 0;
+};
+static LiveClient clients[hal::HTTP_DETACHED_MAX];
+static bool frameDirty = false;
+static uint32_t lastLiveMs = 0;
+
+void localLiveObserve() { frameDirty = true; }
+
+static void dropClient(LiveClient& cl) {
+  hal::sockClose(cl.sock);
+  cl.sock = -1;
+}
+
+static void sendLive(LiveClient& cl, const char* json, size_t len) {
+  uint8_t frame[384];
+  size_t n = wsFrame(frame, sizeof(frame), WS_TEXT, json, len);
+  if (n && !hal::sockWrite(cl.sock, frame, n)) dropClient(cl);
+}
+
+// Answer pings and closes; anything else from the browser is ignored
+static void serviceClient(LiveClient& cl) {
+  int n = hal::sockRead(cl.sock, cl.rx + cl.have, sizeof(cl.rx) - cl.have);
+  if (n < 0) { dropClient(cl); return; }
+  cl.have += n;
+
+  uint8_t opcode;
+  uint8_t* payload;
+  size_t len;
+  int used;
+  while ((used = wsParse(cl.rx, cl.have, sizeof(cl.rx), opcode, payload, len)) > 0) {
+    uint8_t out[sizeof(cl.rx)];
+    if (opcode == WS_CLOSE) {
+      hal::sockWrite(cl.sock, out, wsFrame(out, sizeof(out), WS_CLOSE, payload, len < 2 ? len : 2));
+      dropClient(cl);
+      return;
+    }
+    if (opcode == WS_PING) hal::sockWrite(cl.sock, out, wsFrame(out, sizeof(out), WS_PONG, payload, len));
+    memmove(cl.rx, cl.rx + used, cl.have - used);
+    cl.have -= used;
+  }
+  if (used < 0) dropClient(cl);
+}
+
+static void serveLive(hal::HttpConn* c) {
+  const char* upgrade = hal::httpHeader(c, "Upgrade");
+  if (!upgrade || strcasecmp(upgrade, "websocket")) { replyJson(c, 426, "{\"error\":\"websocket only\"}"); return; }
+  const char* key = hal::httpHeader(c, "Sec-WebSocket-Key");
+  if (!key) { replyJson(c, 400, "{\"error\":\"missing Sec-WebSocket-Key\"}"); return; }
+  char accept[29];
+  wsAcceptKey(key, accept);
+
+  LiveClient* cl = nullptr;
+  for (auto& x : clients) if (x.sock < 0) { cl = &x; break; }
+  int sock = cl ? hal::httpDetach(c) : -1;
+  if (sock < 0) { replyJson(c, 503, "{\"error\":\"too many live clients\"}"); return; }
+
+  char head[160];
+  int hl = snprintf(head, sizeof(head),
+                    "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+  if (!hal::sockWrite(sock, (const uint8_t*)head, hl)) return;
+  cl->sock = sock;
+  cl->have = 0;
+  frameDirty = true;  // first frame on the next tick
+}
+
+// On a sensor update (rate-limited) or the heartbeat, to every client
+static void liveTick() {
+  uint32_t now = hal::millis();
+  bool any = false;
+  for (auto& cl : clients) {
+    if (cl.sock < 0) continue;
+    serviceClient(cl);
+    any |= cl.sock >= 0;
+  }
+  uint32_t since = now - lastLiveMs;
+  if (!any || since < LIVE_INTERVAL_MS || (!frameDirty && since < LIVE_HEARTBEAT_MS)) return;
+
+  char json[320];
+  size_t n = liveJson(json, sizeof(json));
+  if (!n) return;
+  for (auto& cl : clients) if (cl.sock >= 0) sendLive(cl, json, n);
+  frameDirty = false;
+  lastLiveMs = now;
+}
+
+// -------- Control --------
+// Bearer token, compared in constant time
+static bool authorized(hal::HttpConn* c) {
+  const char* h = hal::httpHeader(c, "Authorization");
+  size_t n = strlen(LOCAL_API_TOKEN);
+  if (!n || !h || strncmp(h, "Bearer ", 7) || strlen(h + 7) != n) return false;
+  uint8_t diff = 0;
+  for (size_t i = 0; i < n; i++) diff |= h[7 + i] ^ LOCAL_API_TOKEN[i];
+  return !diff;
+}
+
+// Authorized JSON body into `doc`; replies with the error otherwise
+static bool controlRequest(hal::HttpConn* c, JsonDocument& doc) {
+  if (!LOCAL_API_TOKEN[0]) { replyJson(c, 403, "{\"error\":\"LAN control disabled (LOCAL_API_TOKEN)\"}"); return false; }
+  if (!authorized(c)) { replyJson(c, 401, "{\"error\":\"bad token\"}"); return false; }
+  char body[256];
+  hal::httpBody(c, body, sizeof(body));
+  if (deserializeJson(doc, body)) { replyJson(c, 400, "{\"error\":\"bad JSON\"}"); return false; }
+  return true;
+}
+
+static void serveLight(hal::HttpConn* c) {
+  JsonDocument doc;
+  if (!controlRequest(c, doc)) return;
+  if (!doc["light"].is<int>()) { replyJson(c, 400, "{\"error\":\"light: 0-255\"}"); return; }
+  overrideGrowLight(doc["light"].as<int>(), doc["hold_ms"] | MANUAL_LIGHT_HOLD_MS);
+  frameDirty = true;
+  char reply[48];
+  snprintf(reply, sizeof(reply), "{\"light\":%d}", growLightLevel());
+  replyJson(c, 200, reply);
+}
+
+static void serveDose(hal::HttpConn* c) {
+  JsonDocument doc;
+  if (!controlRequest(c, doc)) return;
+  const char* pump = doc["pump"] | "";
+  bool up = !strcmp(pump, "ph_up"), down = !strcmp(pump, "ph_down"), nutrients = !strcmp(pump, "nutrients");
+  if (!up && !down && !nutrients) { replyJson(c, 400, "{\"error\":\"pump: ph_up|ph_down|nutrients\"}"); return; }
+
+  uint32_t before = metrics.doses;
+  applyDosingCommands(up, down, nutrients, nutrients, doc["lockout_ms"] | 120000UL);
+  bool started = metrics.doses != before;
+  frameDirty = true;
+  char reply[64];
+  snprintf(reply, sizeof(reply), "{\"started\":%s,\"lockout_ms\":%lu}", started ? "true" : "false",
+           lockoutRemaining());
+  replyJson(c, started ? 200 : 409, reply);
+}
+
+// -------- Pages --------
+static const char PAGE[] = R"HTML(<!doctype html>
+<html><head><meta charset="utf-8"><meta name="viewport" content="width=device-width">
+<title>planterbox</title>
+<style>body{font:15px system-ui;margin:1.5em;max-width:34em}td{padding:.2em 1em .2em 0}
+.v{font-weight:600;text-align:right}button{margin:.2em}#st{color:#888}</style></head><body>
+<h2>planterbox <small id="st">connecting</small></h2>
+<table id="t"></table>
+<h3>Manual</h3>
+<p>Token <input id="tok" type="password" size="16"></p>
+<p>Light <input id="lv" type="range" min="0" max="255"> <button onclick="light()">set</button></p>
+<p><button onclick="dose('ph_up')">pH up</button><button onclick="dose('ph_down')">pH down</button>
+<button onclick="dose('nutrients')">nutrients A+B</button></p>
+<p id="msg"></p>
+<script>
+const tok=document.getElementById('tok');tok.value=localStorage.tok||'';
+tok.onchange=()=>localStorage.tok=tok.value;
+function post(p,b){fetch(p,{method:'POST',headers:{Authorization:'Bearer '+tok.value,'Content-Type':'application/json'},
+body:JSON.stringify(b)}).then(r=>r.text()).then(t=>msg.textContent=t)}
+function light(){post('/api/light',{light:+lv.value})}
+function dose(p){post('/api/dose',{pump:p})}
+function open_(){const ws=new WebSocket('ws://'+location.host+'/live');let n=0,t0=Date.now();
+ws.onmessage=e=>{const f=JSON.parse(e.data);n++;
+st.textContent=(n*1000/Math.max(1,Date.now()-t0)).toFixed(1)+' frames/s';
+t.innerHTML=Object.entries(f).map(([k,v])=>'<tr><td>'+k+'</td><td class=v>'+v+'</td></tr>').join('')};
+ws.onclose=()=>{st.textContent='reconnecting';setTimeout(open_,1000)}}
+open_();
+</script></body></html>
+)HTML";
+
+static void servePage(hal::HttpConn* c) {
+  hal::httpReplyBegin(c, 200, "text/html; charset=utf-8");
+  hal::httpReplyWrite(c, PAGE, sizeof(PAGE) - 1);
+}
+
+static void serveStatus(hal::HttpConn* c) {
+  char json[320];
+  liveJson(json, sizeof(json));
+  replyJson(c, 200, json);
+}
+
+static void serveMetrics(hal::HttpConn* c) {
+  hal::httpReplyBegin(c, 200, "text/plain; version=0.0.4");
+  MetricsOut out = { writeReply, c };
+  metricsRender(out);
+}
+
+static void serveHistory(hal::HttpConn* c) {
+  hal::httpReplyBegin(c, 200, "text/csv");
+  MetricsOut out = { writeReply, c };
+  historyRender(out, 0);
+}
+
+struct Route {
+  const char* method;
+  const char* path;
+  void (*fn)(hal::HttpConn* c);
+};
+
+static const Route ROUTES[] = {
+  { "GET",  "/",          servePage },
+  { "GET",  "/status",    serveStatus },
+  { "GET",  "/live",      serveLive },
+  { "POST", "/api/light", serveLight },
+  { "POST", "/api/dose",  serveDose },
+  { "GET",  "/metrics",   serveMetrics },
+  { "GET",  "/history",   serveHistory },
+};
+
+static void serve(hal::HttpConn* c, const char* method, const char* path) {
+  metrics.localRequests++;
+  for (const auto& r : ROUTES) {
+    if (!strcmp(method, r.method) && !strcmp(path, r.path)) { r.fn(c); return; }
+  }
+  hal::httpReplyBegin(c, 404, "text/plain");
+  static const char msg[] = "not found\n";
+  hal::httpReplyWrite(c, msg, sizeof(msg) - 1);
+}
+
+// Collectors browse _planterbox._tcp and read the rest from TXT
+static void advertise() {
+  char id[48], fw[32];
+  snprintf(id, sizeof(id), "id=%s", deviceId());
+  snprintf(fw, sizeof(fw), "fw=%s", FIRMWARE_VERSION);
+  const char* const txt[] = { id, fw, "metrics=/metrics", "status=/status" };
+  hal::mdnsAdvertise(MDNS_SERVICE, LOCAL_HTTP_PORT, txt, sizeof(txt) / sizeof(txt[0]));
+}
+
+void localHttpBegin() {
+  if (hal::httpServerBegin(LOCAL_HTTP_PORT, serve) && MDNS_ENABLED) advertise();
+}
+
+void localHttpTick() {
+  hal::httpServerPoll();
+  liveTick();
+}
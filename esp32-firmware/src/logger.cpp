@@ -0,0 +1,277 @@
+#include "logger.h"
+#include "hal.h"
+#include <atomic>
+#include <ctype.h>
+#include <stdio.h>
+
+uint8_t logLevels[LOG_MOD_COUNT] = {
+  LOG_LVL_INFO, LOG_LVL_INFO, LOG_LVL_INFO, LOG_LVL_INFO, LOG_LVL_INFO, LOG_LVL_INFO,
+};
+
+static const char* const MODULE_NAMES[LOG_MOD_COUNT] = {
+  "sensors", "dosing", "light", "uplink", "sampling", "sched",
+};
+static const char* const LEVEL_NAMES[] = { "none", "error", "warn", "info", "debug" };
+
+// -------- Ring --------
+// Records are [header][args] copied in byte by byte with wrap-around, so no
+// space is lost to padding. head is only written by the producer (log call
+// sites, all on the loop task), tail only by the consumer (the drain job).
+struct RecordHeader {
+  uint16_t size;  // header + args
+  uint8_t  nargs;
+  uint8_t  reserved;
+  uint32_t ms;
+  const LogSite* site;
+};
+
+static const uint32_t RING_MASK = LOG_RING_BYTES - 1;
+static_assert((LOG_RING_BYTES & RING_MASK) == 0, "LOG_RING_BYTES must be a power of two");
+static const size_t MAX_RECORD = 512;
+
+static uint8_t ring[LOG_RING_BYTES];
+static std::atomic<uint32_t> head(0), tail(0);
+static uint32_t dropped = 0, droppedReported = 0;
+
+static uint8_t produce[MAX_RECORD];  // record being built at a call site
+static uint8_t consume[MAX_RECORD];  // record being formatted by the drain
+
+static void copyIn(uint32_t at, const uint8_t* src, size_t n) {
+  for (size_t i = 0; i < n; i++) ring[(at + i) & RING_MASK] = src[i];
+}
+static void copyOut(uint32_t at, uint8_t* dst, size_t n) {
+  for (size_t i = 0; i < n; i++) dst[i] = ring[(at + i) & RING_MASK];
+}
+
+namespace logdetail {
+
+uint8_t* begin(const LogSite* site, size_t argBytes, uint8_t nargs) {
+  size_t size = sizeof(RecordHeader) + argBytes;
+  uint32_t h = head.load(std::memory_order_relaxed);
+  uint32_t used = h - tail.load(std::memory_order_acquire);
+  if (size > MAX_RECORD || size > LOG_RING_BYTES - used) { dropped++; return nullptr; }
+
+  RecordHeader hdr = { (uint16_t)size, nargs, 0, hal::millis(), site };
+  memcpy(produce, &hdr, sizeof(hdr));
+  return produce + sizeof(hdr);
+}
+
+void commit() {
+  RecordHeader hdr;
+  memcpy(&hdr, produce, sizeof(hdr));
+  uint32_t h = head.load(std::memory_order_relaxed);
+  copyIn(h, produce, hdr.size);
+  head.store(h + hdr.size, std::memory_order_release);
+}
+
+}  // namespace logdetail
+
+// -------- Formatting --------
+// Walks the format string and re-issues each conversion through snprintf
+// with the stored value widened to (unsigned) long long / double, so the
+// original length modifiers don't matter.
+class ArgReader {
+public:
+  ArgReader(const uint8_t* p, uint8_t n) : p(p), left(n) {}
+
+  long long nextInt() {
+    Value v = next();
+    switch (v.tag) {
+      case LOG_ARG_I32: return (int32_t)v.u32;
+      case LOG_ARG_U32: return v.u32;
+      case LOG_ARG_I64: return v.i64;
+      case LOG_ARG_F32: return (long long)v.f;
+      default:          return 0;
+    }
+  }
+  unsigned long long nextUnsigned() {
+    Value v = next();
+    switch (v.tag) {
+      case LOG_ARG_I32:
+      case LOG_ARG_U32: return v.u32;  // same bits a 32-bit printf would see
+      case LOG_ARG_I64: return (unsigned long long)v.i64;
+      case LOG_ARG_F32: return (unsigned long long)v.f;
+      default:          return 0;
+    }
+  }
+  double nextFloat() {
+    Value v = next();
+    switch (v.tag) {
+      case LOG_ARG_F32: return v.f;
+      case LOG_ARG_I32: return (int32_t)v.u32;
+      case LOG_ARG_U32: return v.u32;
+      case LOG_ARG_I64: return (double)v.i64;
+      default:          return 0;
+    }
+  }
+  // NUL-terminated copy of a string argument
+  const char* nextStr(char* buf, size_t cap) {
+    Value v = next();
+    if (v.tag != LOG_ARG_STR) return "?";
+    size_t n = v.len < cap - 1 ? v.len : cap - 1;
+    memcpy(buf, v.str, n);
+    buf[n] = '\0';
+    return buf;
+  }
+
+private:
+  struct Value {
+    uint8_t tag = 0xFF;
+    uint32_t u32 = 0;
+    int64_t i64 = 0;
+    float f = 0;
+    const uint8_t* str = nullptr;
+    uint8_t len = 0;
+  };
+
+  Value next() {
+    Value v;
+    if (!left) return v;  // more conversions than arguments
+    left--;
+    v.tag = *p++;
+    switch (v.tag) {
+      case LOG_ARG_I32:
+      case LOG_ARG_U32: memcpy(&v.u32, p, 4); p += 4; break;
+      case LOG_ARG_I64: memcpy(&v.i64, p, 8); p += 8; break;
+      case LOG_ARG_F32: memcpy(&v.f, p, 4); p += 4; break;
+      case LOG_ARG_STR: v.len = *p++; v.str = p; p += v.len; break;
+    }
+    return v;
+  }
+
+  const uint8_t* p;
+  uint8_t left;
+};
+
+static size_t formatRecord(const RecordHeader& hdr, const uint8_t* args, char* out, size_t cap) {
+  ArgReader r(args, hdr.nargs);
+  int o = snprintf(out, cap, "[%lu.%03lu] ", (unsigned long)(hdr.ms / 1000),
+                   (unsigned long)(hdr.ms % 1000));
+  size_t len = o > 0 ? o : 0;
+  auto emit = [&](const char* s, size_t n) {
+    if (len + n > cap - 1) n = cap - 1 - len;
+    memcpy(out + len, s, n);
+    len += n;
+  };
+
+  const char* f = hdr.site->fmt;
+  while (*f) {
+    if (*f != '%') {
+      const char* pct = strchr(f, '%');
+      size_t n = pct ? (size_t)(pct - f) : strlen(f);
+      emit(f, n);
+      f += n;
+      continue;
+    }
+    if (f[1] == '%') { emit("%", 1); f += 2; continue; }
+
+    char spec[32];
+    size_t sl = 0;
+    spec[sl++] = *f++;
+    while (*f && strchr("-+ #0", *f) && sl < 8) spec[sl++] = *f++;
+    for (int part = 0; part < 2; part++) {  // width, then precision
+      if (part == 1) {
+        if (*f != '.') break;
+        spec[sl++] = *f++;
+      }
+      if (*f == '*') {
+        f++;
+        sl += snprintf(spec + sl, sizeof(spec) - sl - 4, "%d", (int)r.nextInt());
+      } else {
+        while (isdigit((unsigned char)*f) && sl < 20) spec[sl++] = *f++;
+      }
+    }
+    while (*f && strchr("hlLqjzt", *f)) f++;  // widths come from the stored tag
+    char conv = *f ? *f++ : 's';
+
+    char piece[LOG_MAX_STR + 64], str[LOG_MAX_STR + 1];
+    int n = 0;
+    if (strchr("di", conv)) {
+      memcpy(spec + sl, "lld", 4);
+      n = snprintf(piece, sizeof(piece), spec, r.nextInt());
+    } else if (strchr("uxXo", conv)) {
+      spec[sl++] = 'l'; spec[sl++] = 'l'; spec[sl++] = conv; spec[sl] = '\0';
+      n = snprintf(piece, sizeof(piece), spec, r.nextUnsigned());
+    } else if (strchr("fFeEgGaA", conv)) {
+      spec[sl++] = conv; spec[sl] = '\0';
+      n = snprintf(piece, sizeof(piece), spec, r.nextFloat());
+    } else if (conv == 'c') {
+      spec[sl++] = 'c'; spec[sl] = '\0';
+      n = snprintf(piece, sizeof(piece), spec, (int)r.nextInt());
+    } else if (conv == 's') {
+      spec[sl++] = 's'; spec[sl] = '\0';
+      n = snprintf(piece, sizeof(piece), spec, r.nextStr(str, sizeof(str)));
+    } else if (conv == 'p') {
+      spec[sl++] = 'p'; spec[sl] = '\0';
+      n = snprintf(piece, sizeof(piece), spec, (void*)(uintptr_t)r.nextUnsigned());
+    }
+    if (n > 0) emit(piece, (size_t)n < sizeof(piece) ? n : sizeof(piece) - 1);
+  }
+  out[len] = '\0';
+  return len;
+}
+
+// -------- Drain --------
+// Format the oldest record into `line`; returns its length, 0 if empty
+static size_t peekLine(char* line, size_t cap, uint32_t& size) {
+  uint32_t t = tail.load(std::memory_order_relaxed);
+  if (t == head.load(std::memory_order_acquire)) return 0;
+  RecordHeader hdr;
+  copyOut(t, (uint8_t*)&hdr, sizeof(hdr));
+  copyOut(t + sizeof(hdr), consume, hdr.size - sizeof(hdr));
+  size = hdr.size;
+  return formatRecord(hdr, consume, line, cap);
+}
+
+static void reportDrops() {
+  if (dropped == droppedReported) return;
+  hal::logf("[LOG] %lu records dropped (ring full)\n", (unsigned long)(dropped - droppedReported));
+  droppedReported = dropped;
+}
+
+void logDrainTick() {
+  static const int MAX_PER_TICK = 16;
+  char line[384];
+  reportDrops();
+  for (int i = 0; i < MAX_PER_TICK; i++) {
+    uint32_t size = 0;
+    size_t len = peekLine(line, sizeof(line), size);
+    if (!len && !size) return;
+    if (len > hal::consoleWriteSpace()) return;  // would block: next tick
+    hal::logf("%s", line);
+    tail.store(tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+  }
+}
+
+void logFlush() {
+  char line[384];
+  reportDrops();
+  for (;;) {
+    uint32_t size = 0;
+    size_t len = peekLine(line, sizeof(line), size);
+    if (!len && !size) return;
+    hal::logf("%s", line);
+    tail.store(tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+  }
+}
+
+uint32_t logDropped() { return dropped; }
+
+// -------- Names --------
+const char* logModuleName(LogModule m) { return m < LOG_MOD_COUNT ? MODULE_NAMES[m] : "?"; }
+
+bool logParseModule(const char* name, LogModule& out) {
+  for (int i = 0; i < LOG_MOD_COUNT; i++) {
+    if (!strcmp(name, MODULE_NAMES[i])) { out = (LogModule)i; return true; }
+  }
+  return false;
+}
+
+const char* logLevelName(uint8_t level) { return level <= LOG_LVL_DEBUG ? LEVEL_NAMES[level] : "?"; }
+
+bool logParseLevel(const char* name, uint8_t& out) {
+  for (uint8_t i = 0; i <= LOG_LVL_DEBUG; i++) {
+    if (!strcmp(name, LEVEL_NAMES[i])) { out = i; return true; }
+  }
+  return false;
+}
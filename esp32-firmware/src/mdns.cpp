@@ -0,0 +1,244 @@
+#include "mdns.h"
+#include <string.h>
+#include <strings.h>
+
+enum : uint16_t { TYPE_A = 1, TYPE_CNAME = 5, TYPE_PTR = 12, TYPE_TXT = 16, TYPE_SRV = 33, CLASS_IN = 1 };
+const uint16_t CACHE_FLUSH = 0x8000;  // rrclass bit on records only we answer for
+const uint32_t TTL_HOST = 120, TTL_SERVICE = 4500;  // RFC 6762 section 10
+
+// -------- Writing --------
+struct Out {
+  uint8_t* p;
+  size_t cap, len;
+  bool ok;
+  void u8(uint8_t v) { if (len < cap) p[len++] = v; else ok = false; }
+  void u16(uint16_t v) { u8(v >> 8); u8(v); }
+  void u32(uint32_t v) { u16(v >> 16); u16(v); }
+  void bytes(const void* b, size_t n) { for (size_t i = 0; i < n; i++) u8(((const uint8_t*)b)[i]); }
+};
+
+// "a.b.local" as labels; no compression, the answers are small
+static void name(Out& o, const char* dotted) {
+  while (*dotted) {
+    const char* dot = strchr(dotted, '.');
+    size_t n = dot ? (size_t)(dot - dotted) : strlen(dotted);
+    if (n == 0 || n > 63) { o.ok = false; return; }
+    o.u8(n);
+    o.bytes(dotted, n);
+    dotted += n + (dot ? 1 : 0);
+  }
+  o.u8(0);
+}
+
+static void header(Out& o, uint16_t id, uint16_t flags, uint16_t qd, uint16_t an, uint16_t ar) {
+  o.u16(id); o.u16(flags); o.u16(qd); o.u16(an); o.u16(0); o.u16(ar);
+}
+
+// Owner, type, class, TTL and a placeholder length; returns where RDATA starts
+static size_t record(Out& o, const char* owner, uint16_t type, uint16_t cls, uint32_t ttl) {
+  name(o, owner);
+  o.u16(type); o.u16(cls); o.u32(ttl); o.u16(0);
+  return o.len;
+}
+
+static void endRecord(Out& o, size_t rdata) {
+  if (!o.ok) return;
+  size_t n = o.len - rdata;
+  o.p[rdata - 2] = n >> 8;
+  o.p[rdata - 1] = n;
+}
+
+size_t mdnsQuery(uint8_t* out, size_t cap, uint16_t id, const char* service) {
+  Out o = { out, cap, 0, true };
+  header(o, id, 0, 1, 0, 0);
+  name(o, service);
+  o.u16(TYPE_PTR);
+  o.u16(CLASS_IN);
+  return o.ok ? o.len : 0;
+}
+
+size_t mdnsAnswer(uint8_t* out, size_t cap, uint16_t id, const char* service, const MdnsService& s) {
+  Out o = { out, cap, 0, true };
+  header(o, id, 0x8400, 0, 1, s.ipv4 ? 3 : 2);  // response, authoritative
+
+  size_t at = record(o, service, TYPE_PTR, CLASS_IN, TTL_SERVICE);
+  name(o, s.instance);
+  endRecord(o, at);
+
+  at = record(o, s.instance, TYPE_SRV, CLASS_IN | CACHE_FLUSH, TTL_HOST);
+  o.u16(0); o.u16(0); o.u16(s.port);  // priority, weight, port
+  name(o, s.host);
+  endRecord(o, at);
+
+  at = record(o, s.instance, TYPE_TXT, CLASS_IN | CACHE_FLUSH, TTL_SERVICE);
+  for (int i = 0; i < s.txtCount; i++) {
+    size_t n = strlen(s.txt[i]);
+    o.u8(n);
+    o.bytes(s.txt[i], n);
+  }
+  if (!s.txtCount) o.u8(0);  // an empty TXT still holds one empty string
+  endRecord(o, at);
+
+  if (s.ipv4) {
+    at = record(o, s.host, TYPE_A, CLASS_IN | CACHE_FLUSH, TTL_HOST);
+    o.bytes(&s.ipv4, 4);
+    endRecord(o, at);
+  }
+  return o.ok ? o.len : 0;
+}
+
+// -------- Reading --------
+struct In {
+  const uint8_t* p;
+  size_t len, at;
+  bool ok;
+  uint8_t u8() { if (at < len) return p[at++]; ok = false; return 0; }
+  uint16_t u16() { uint16_t hi = u8(); return hi << 8 | u8(); }
+  uint32_t u32() { uint32_t hi = u16(); return hi << 16 | u16(); }
+};
+
+// Dotted name at in.at, following compression pointers; advances past it
+static void readName(In& in, char* out, size_t cap) {
+  size_t pos = in.at, n = 0;
+  bool jumped = false;
+  for (int hops = 0; hops < 32; hops++) {
+    if (pos >= in.len) break;
+    uint8_t l = in.p[pos];
+    if (l == 0) {
+      if (!jumped) in.at = pos + 1;
+      if (cap) out[n < cap ? n : cap - 1] = '\0';
+      return;
+    }
+    if ((l & 0xC0) == 0xC0) {
+      if (pos + 1 >= in.len) break;
+      if (!jumped) in.at = pos + 2;
+      jumped = true;
+      pos = (l & 0x3F) << 8 | in.p[pos + 1];
+      continue;
+    }
+    if (pos + 1 + l > in.len) break;
+    if (n && n < cap) out[n++] = '.';
+    for (size_t i = 0; i < l; i++) if (n < cap) out[n++] = in.p[pos + 1 + i];
+    pos += 1 + l;
+  }
+  in.ok = false;
+}
+
+bool mdnsAsks(const uint8_t* msg, size_t len, const char* service, uint16_t& id) {
+  In in = { msg, len, 0, true };
+  id = in.u16();
+  uint16_t flags = in.u16(), qd = in.u16();
+  in.at = 12;
+  if (!in.ok || flags & 0x8000) return false;  // responses don't ask
+  for (int i = 0; i < qd && in.ok; i++) {
+    char q[96];
+    readName(in, q, sizeof(q));
+    uint16_t type = in.u16();
+    in.u16();  // class; the unicast-response bit doesn't change what we send
+    if (in.ok && (type == TYPE_PTR || type == 255) && !strcasecmp(q, service)) return true;
+  }
+  return false;
+}
+
+static void copyName(char* dst, size_t cap, const char* src) {
+  size_t n = strlen(src);
+  if (n >= cap) n = cap - 1;
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+bool mdnsParseAnswer(const uint8_t* msg, size_t len, const char* service, MdnsService& s) {
+  In in = { msg, len, 0, true };
+  in.u16();
+  uint16_t flags = in.u16(), qd = in.u16(), an = in.u16(), ns = in.u16(), ar = in.u16();
+  if (!in.ok || !(flags & 0x8000)) return false;
+  for (int i = 0; i < qd && in.ok; i++) {  // a legacy unicast reply repeats the question
+    char q[96];
+    readName(in, q, sizeof(q));
+    in.at += 4;
+  }
+
+  s = MdnsService();
+  bool found = false;
+  char aOwner[4][48];  // A records may come before the SRV naming the host
+  uint32_t aAddr[4];
+  int aCount = 0;
+  for (int i = 0; i < an + ns + ar && in.ok; i++) {
+    char owner[96];
+    readName(in, owner, sizeof(owner));
+    uint16_t type = in.u16();
+    in.u16();
+    in.u32();
+    uint16_t rdlen = in.u16();
+    size_t end = in.at + rdlen;
+    if (!in.ok || end > len) return false;
+
+    if (type == TYPE_PTR && !strcasecmp(owner, service)) {
+      readName(in, s.instance, sizeof(s.instance));
+      found = true;
+    } else if (type == TYPE_SRV && found && !strcasecmp(owner, s.instance)) {
+      in.u16(); in.u16();
+      s.port = in.u16();
+      readName(in, s.host, sizeof(s.host));
+    } else if (type == TYPE_TXT && found && !strcasecmp(owner, s.instance)) {
+      while (in.at < end && s.txtCount < MDNS_MAX_TXT) {
+        uint8_t n = in.u8();
+        if (in.at + n > end) return false;
+        char str[256];
+        memcpy(str, in.p + in.at, n);
+        str[n] = '\0';
+        if (n) copyName(s.txt[s.txtCount++], sizeof(s.txt[0]), str);
+        in.at += n;
+      }
+    } else if (type == TYPE_A && rdlen == 4 && aCount < 4) {
+      copyName(aOwner[aCount], sizeof(aOwner[0]), owner);
+      memcpy(&aAddr[aCount++], in.p + in.at, 4);
+    }
+    in.at = end;
+  }
+  for (int i = 0; i < aCount; i++) if (!strcasecmp(aOwner[i], s.host)) s.ipv4 = aAddr[i];
+  return found && s.port;
+}
+
+// -------- Unicast DNS --------
+size_t dnsQueryA(uint8_t* out, size_t cap, uint16_t id, const char* host) {
+  Out o = { out, cap, 0, true };
+  header(o, id, 0x0100, 1, 0, 0);  // recursion desired
+  name(o, host);
+  o.u16(TYPE_A);
+  o.u16(CLASS_IN);
+  return o.ok ? o.len : 0;
+}
+
+int dnsParseA(const uint8_t* msg, size_t len, uint16_t id, const char* host,
+              uint32_t* addrs, int max, uint32_t& ttlS) {
+  In in = { msg, len, 0, true };
+  uint16_t got = in.u16(), flags = in.u16(), qd = in.u16(), an = in.u16();
+  in.at = 12;
+  if (!in.ok || got != id || !(flags & 0x8000) || qd != 1) return -1;
+  // The question must be ours echoed back: the ID alone is only 16 bits to guess
+  char q[96];
+  readName(in, q, sizeof(q));
+  uint16_t qtype = in.u16(), qclass = in.u16();
+  if (!in.ok || strcasecmp(q, host) || qtype != TYPE_A || qclass != CLASS_IN) return -1;
+  if (flags & 0x000F) return 0;  // rcode: NXDOMAIN, SERVFAIL, ...
+
+  int n = 0;
+  ttlS = 0;
+  for (int i = 0; i < an && in.ok; i++) {  // the resolver's answer: the CNAME chain, then A records
+    char owner[96];
+    readName(in, owner, sizeof(owner));
+    uint16_t type = in.u16();
+    in.u16();
+    uint32_t ttl = in.u32();
+    uint16_t rdlen = in.u16();
+    size_t end = in.at + rdlen;
+    if (!in.ok || end > len) return -1;
+    if ((type == TYPE_A && rdlen == 4) || type == TYPE_CNAME) {
+      if (!ttlS || ttl < ttlS) ttlS = ttl;
+    }
+    if (type == TYPE_A && rdlen == 4 && n < max) memcpy(&addrs[n++], in.p + in.at, 4);
+    in.at = end;
+  }
+  return in.ok ? n : -1;
+}
@@ -0,0 +1,40 @@
+#include "memstats.h"
+
+MemRegionStats memRegions[MEM_REGION_COUNT];
+
+static MemRegion current = MEM_OTHER;  // only touched by the loop task
+
+static const char* const REGION_NAMES[MEM_REGION_COUNT] = {
+  "other", "sensing", "json", "tls", "http", "background",
+};
+
+const char* const MEM_TASKS[] = { "loopTask", "arduino_events", "wifi", "tiT" };
+const int MEM_TASK_COUNT = sizeof(MEM_TASKS) / sizeof(MEM_TASKS[0]);
+
+const char* memRegionName(MemRegion r) { return r < MEM_REGION_COUNT ? REGION_NAMES[r] : "?"; }
+
+uint32_t memTotalAllocs() {
+  uint32_t n = 0;
+  for (const auto& r : memRegions) n += __atomic_load_n(&r.allocs, __ATOMIC_RELAXED);
+  return n;
+}
+
+void memRecordAlloc(size_t bytes, bool onLoopTask) {
+  MemRegionStats& r = memRegions[onLoopTask ? current : MEM_BACKGROUND];
+  __atomic_fetch_add(&r.allocs, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&r.bytes, (uint32_t)bytes, __ATOMIC_RELAXED);
+}
+
+MemRegion memSetRegion(MemRegion r) {
+  MemRegion prev = current;
+  current = r;
+  return prev;
+}
+
+MemSnapshot memSnapshot() {
+  MemSnapshot s;
+  s.heap = hal::heapStats();
+  s.fragPct = s.heap.freeBytes ? (uint8_t)(100 - (uint64_t)100 * s.heap.largestFreeBlock / s.heap.freeBytes) : 0;
+  s.loopStackFree = hal::stackHighWater();
+  return s;
+}
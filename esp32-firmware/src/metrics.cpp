@@ -0,0 +1,189 @@
+#include "metrics.h"
+#include "config.h"
+#include "memstats.h"
+#include "uplink.h"
+#include "push.h"
+#include "gateway.h"
+#include "dns_cache.h"
+#include "identity.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+Metrics metrics;
+
+// -------- LatencyHistogram --------
+// Values below SUB get one bucket each; from there on, bucket =
+// (exponent block, top SUB_BITS bits below the leading one).
+int LatencyHistogram::bucketOf(uint32_t us) {
+  if (us < (uint32_t)SUB) return us;
+  int e = 31 - __builtin_clz(us);
+  if (e > MAX_EXP) return BUCKETS - 1;
+  return (e - SUB_BITS + 1) * SUB + ((us >> (e - SUB_BITS)) & (SUB - 1));
+}
+
+uint32_t LatencyHistogram::bucketLow(int b) {
+  if (b < SUB) return b;
+  int e = b / SUB + SUB_BITS - 1;
+  return (uint32_t)(SUB + b % SUB) << (e - SUB_BITS);
+}
+
+void LatencyHistogram::record(uint32_t us) {
+  buckets[bucketOf(us)]++;
+  n++;
+  sum += us;
+  if (us > max) max = us;
+}
+
+void LatencyHistogram::reset() {
+  memset(buckets, 0, sizeof(buckets));
+  n = max = 0;
+  sum = 0;
+}
+
+uint32_t LatencyHistogram::countBelow(uint32_t us) const {
+  uint32_t c = 0;
+  for (int b = 0; b < BUCKETS && bucketLow(b) < us; b++) c += buckets[b];
+  return c;
+}
+
+// -------- Prometheus text rendering --------
+void MetricsOut::printf(const char* fmt, ...) {
+  char line[160];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(line, sizeof(line), fmt, ap);
+  va_end(ap);
+  if (n > 0) write(ctx, line, (size_t)n < sizeof(line) ? n : sizeof(line) - 1);
+}
+
+// Exported le edges: powers of two from 64 us to ~134 s, in seconds
+static const int LE_FIRST_EXP = 6;
+
+static void renderHistogram(MetricsOut& out, const char* name, const char* labels,
+                            const LatencyHistogram& h) {
+  const char* sep = labels[0] ? "," : "";
+  for (int e = LE_FIRST_EXP; e <= LatencyHistogram::MAX_EXP; e++) {
+    uint32_t edge = 1UL << e;
+    out.printf("%s_bucket{%s%sle=\"%.6f\"} %lu\n", name, labels, sep, edge / 1e6,
+               (unsigned long)h.countBelow(edge));
+  }
+  out.printf("%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, sep, (unsigned long)h.count());
+  const char* open = labels[0] ? "{" : "";
+  const char* close = labels[0] ? "}" : "";
+  out.printf("%s_sum%s%s%s %.6f\n", name, open, labels, close, h.sumUs() / 1e6);
+  out.printf("%s_count%s%s%s %lu\n", name, open, labels, close, (unsigned long)h.count());
+}
+
+static void header(MetricsOut& out, const char* name, const char* type, const char* help) {
+  out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void counter(MetricsOut& out, const char* name, const char* help, uint32_t v) {
+  header(out, name, "counter", help);
+  out.printf("%s %lu\n", name, (unsigned long)v);
+}
+
+static void gauge(MetricsOut& out, const char* name, const char* help, uint32_t v) {
+  header(out, name, "gauge", help);
+  out.printf("%s %lu\n", name, (unsigned long)v);
+}
+
+static void renderMemory(MetricsOut& out) {
+  MemSnapshot m = memSnapshot();
+  gauge(out, "planterbox_heap_free_bytes", "Free heap", m.heap.freeBytes);
+  gauge(out, "planterbox_heap_largest_free_block_bytes", "Largest allocatable block", m.heap.largestFreeBlock);
+  gauge(out, "planterbox_heap_min_free_bytes", "Lowest free heap since boot", m.heap.minFreeBytes);
+  gauge(out, "planterbox_heap_fragmentation_percent", "100 * (1 - largest block / free)", m.fragPct);
+
+  header(out, "planterbox_task_stack_free_bytes", "gauge", "Stack never used since the task started");
+  for (int i = 0; i < MEM_TASK_COUNT; i++) {
+    uint32_t free = hal::stackHighWater(MEM_TASKS[i]);
+    if (free) out.printf("planterbox_task_stack_free_bytes{task=\"%s\"} %lu\n", MEM_TASKS[i], (unsigned long)free);
+  }
+
+  const Arena& a = uplinkArena();
+  gauge(out, "planterbox_uplink_arena_high_water_bytes", "Most of the uplink arena used by one cycle", a.highWater());
+  gauge(out, "planterbox_uplink_arena_capacity_bytes", "Uplink arena size", a.capacity());
+  counter(out, "planterbox_uplink_arena_overflows_total", "Uplink arena allocations that didn't fit", a.overflows());
+
+  header(out, "planterbox_allocs_total", "counter", "Heap allocations by code region");
+  for (int i = 0; i < MEM_REGION_COUNT; i++) {
+    out.printf("planterbox_allocs_total{region=\"%s\"} %lu\n", memRegionName((MemRegion)i),
+               (unsigned long)memRegions[i].allocs);
+  }
+  header(out, "planterbox_alloc_bytes_total", "counter", "Bytes requested from the heap by code region");
+  for (int i = 0; i < MEM_REGION_COUNT; i++) {
+    out.printf("planterbox_alloc_bytes_total{region=\"%s\"} %lu\n", memRegionName((MemRegion)i),
+               (unsigned long)memRegions[i].bytes);
+  }
+}
+
+static const char* const SENSOR_NAMES[SENSOR_COUNT] = { "dht", "distance", "ppm", "ph", "water" };
+
+void metricsRender(MetricsOut& out) {
+  header(out, "planterbox_build_info", "gauge", "Firmware version and device id (always 1)");
+  out.printf("planterbox_build_info{version=\"%s\",device=\"%s\"} 1\n", FIRMWARE_VERSION, deviceId());
+
+  struct { const char* name; const char* help; const LatencyHistogram& h; } hists[] = {
+    { "planterbox_loop_seconds",        "Scheduler passes that ran a job",        metrics.loopUs },
+    { "planterbox_post_seconds",        "Uplink POST round trip incl. connect",   metrics.postUs },
+    { "planterbox_connect_seconds",     "TCP connect + TLS handshake",            metrics.connectUs },
+    { "planterbox_pump_error_seconds",  "Pump on-time beyond the requested dose", metrics.pumpErrorUs },
+  };
+  for (const auto& h : hists) {
+    header(out, h.name, "histogram", h.help);
+    renderHistogram(out, h.name, "", h.h);
+    out.printf("# TYPE %s_max gauge\n%s_max %.6f\n", h.name, h.name, h.h.maxUs() / 1e6);
+  }
+
+  header(out, "planterbox_sensor_read_seconds", "histogram", "Sensor job run time");
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    char labels[32];
+    snprintf(labels, sizeof(labels), "sensor=\"%s\"", SENSOR_NAMES[i]);
+    renderHistogram(out, "planterbox_sensor_read_seconds", labels, metrics.sensorUs[i]);
+  }
+
+  counter(out, "planterbox_uplinks_total", "Uplink attempts", metrics.uplinks);
+  counter(out, "planterbox_uplinks_suppressed_total", "Frames not sent: inside the deadband (deadband mode)", metrics.uplinksSuppressed);
+  counter(out, "planterbox_uplinks_deferred_total", "Uploads held back by pacing, retry backoff or the breaker",
+          metrics.uplinksDeferred);
+  counter(out, "planterbox_uplink_windows_dropped_total", "Unsent windows discarded from a full backlog",
+          metrics.uplinkWindowsDropped);
+  counter(out, "planterbox_uplink_frames_rejected_total", "Frames the server refused (4xx other than 429), dropped",
+          metrics.uplinkFramesRejected);
+  const UploadPacer& pacer = uplinkPacer();
+  gauge(out, "planterbox_uplink_gap_ms", "Least time between uploads outside dosing", pacer.gapMs(false));
+  gauge(out, "planterbox_uplink_server_paced", "Upload gap set by the server (0/1)", pacer.serverPaced());
+  gauge(out, "planterbox_uplink_srtt_ms", "Smoothed upload round trip", pacer.srttMs());
+  gauge(out, "planterbox_uplink_error_permille", "Recent uploads that failed, per mille", pacer.errorPermille());
+  const UplinkPolicy& policy = uplinkPolicy();
+  gauge(out, "planterbox_uplink_breaker_state", "Uplink circuit breaker (0 closed, 1 open, 2 half-open)",
+        policy.state());
+  counter(out, "planterbox_uplink_breaker_opens_total", "Times the uplink breaker opened", policy.opens());
+  gauge(out, "planterbox_uplink_consecutive_failures", "Failed uploads since the last success",
+        policy.consecutiveFailures());
+  header(out, "planterbox_http_failures_total", "counter", "Failed uplinks by kind");
+  out.printf("planterbox_http_failures_total{kind=\"transport\"} %lu\n",
+             (unsigned long)metrics.httpTransportErrors);
+  out.printf("planterbox_http_failures_total{kind=\"status\"} %lu\n",
+             (unsigned long)metrics.httpStatusErrors);
+  counter(out, "planterbox_json_parse_errors_total", "Unparseable server responses", metrics.jsonParseErrors);
+  gauge(out, "planterbox_push_up", "Push channel connected (0/1)", pushUp());
+  counter(out, "planterbox_push_connects_total", "Push channel sessions established", metrics.pushConnects);
+  counter(out, "planterbox_push_commands_total", "Commands received over the push channel", metrics.pushCommands);
+  gauge(out, "planterbox_gateway_enabled", "Uplink via the LAN CoAP gateway (0/1)", gatewayEnabled());
+  counter(out, "planterbox_coap_retransmits_total", "CoAP confirmable retransmissions", metrics.coapRetransmits);
+  gauge(out, "planterbox_dns_cached_addresses", "Server addresses in the DNS cache", dnsCacheCount());
+  counter(out, "planterbox_dns_lookups_total", "DNS queries for the server", metrics.dnsLookups);
+  counter(out, "planterbox_dns_failures_total", "DNS queries that timed out or found nothing", metrics.dnsFailures);
+  counter(out, "planterbox_dns_failovers_total", "Cached server addresses that refused a connection",
+          metrics.dnsFailovers);
+  counter(out, "planterbox_uplink_warmups_total", "Server connections opened ahead of an upload",
+          metrics.uplinkWarmups);
+  counter(out, "planterbox_local_requests_total", "Requests served by the local HTTP server", metrics.localRequests);
+  counter(out, "planterbox_lockout_rejections_total", "Dose requests ignored during lockout", metrics.lockoutRejections);
+  counter(out, "planterbox_doses_total", "Pump sequences started", metrics.doses);
+
+  renderMemory(out);
+}
@@ -0,0 +1,153 @@
+#include "mqtt.h"
+#include <string.h>
+
+// -------- Writing --------
+namespace {
+struct PacketWriter {
+  PacketWriter(uint8_t* out, size_t cap) : out(out), cap(cap) {}
+
+  uint8_t* out;
+  size_t cap;
+  size_t len = 0;
+  bool ok = true;
+
+  void byte(uint8_t b) { if (len < cap) out[len++] = b; else ok = false; }
+  void u16(uint16_t v) { byte(v >> 8); byte(v); }
+  void bytes(const void* p, size_t n) {
+    if (len + n > cap) { ok = false; return; }
+    memcpy(out + len, p, n);
+    len += n;
+  }
+  void str(const char* s) { size_t n = strlen(s); u16((uint16_t)n); bytes(s, n); }
+
+  // Fixed header: type/flags, then the remaining length as a varint
+  void header(uint8_t typeFlags, size_t remaining) {
+    byte(typeFlags);
+    do {
+      uint8_t b = remaining & 0x7F;
+      remaining >>= 7;
+      byte(remaining ? b | 0x80 : b);
+    } while (remaining);
+  }
+  size_t done() const { return ok ? len : 0; }
+};
+}  // namespace
+
+size_t mqttConnect(uint8_t* out, size_t cap, const char* clientId, uint16_t keepAliveS,
+                   const char* user, const char* password) {
+  uint8_t flags = 0x02;  // clean session
+  size_t remaining = 10 + 2 + strlen(clientId);
+  if (user) { flags |= 0x80; remaining += 2 + strlen(user); }
+  if (password) { flags |= 0x40; remaining += 2 + strlen(password); }
+
+  PacketWriter w(out, cap);
+  w.header(MQTT_CONNECT << 4, remaining);
+  w.str("MQTT");
+  w.byte(4);  // protocol level 3.1.1
+  w.byte(flags);
+  w.u16(keepAliveS);
+  w.str(clientId);
+  if (user) w.str(user);
+  if (password) w.str(password);
+  return w.done();
+}
+
+size_t mqttSubscribe(uint8_t* out, size_t cap, uint16_t packetId, const char* topic) {
+  PacketWriter w(out, cap);
+  w.header(MQTT_SUBSCRIBE << 4 | 0x02, 2 + 2 + strlen(topic) + 1);
+  w.u16(packetId);
+  w.str(topic);
+  w.byte(0);  // QoS 0
+  return w.done();
+}
+
+size_t mqttPublish(uint8_t* out, size_t cap, const char* topic, const uint8_t* payload, size_t len) {
+  PacketWriter w(out, cap);
+  w.header(MQTT_PUBLISH << 4, 2 + strlen(topic) + len);
+  w.str(topic);
+  w.bytes(payload, len);
+  return w.done();
+}
+
+static size_t empty(uint8_t* out, size_t cap, uint8_t type) {
+  PacketWriter w(out, cap);
+  w.header(type << 4, 0);
+  return w.done();
+}
+
+size_t mqttPingReq(uint8_t* out, size_t cap) { return empty(out, cap, MQTT_PINGREQ); }
+size_t mqttPingResp(uint8_t* out, size_t cap) { return empty(out, cap, MQTT_PINGRESP); }
+size_t mqttDisconnect(uint8_t* out, size_t cap) { return empty(out, cap, MQTT_DISCONNECT); }
+
+size_t mqttConnAck(uint8_t* out, size_t cap, uint8_t returnCode) {
+  PacketWriter w(out, cap);
+  w.header(MQTT_CONNACK << 4, 2);
+  w.byte(0);  // no session present
+  w.byte(returnCode);
+  return w.done();
+}
+
+size_t mqttSubAck(uint8_t* out, size_t cap, uint16_t packetId) {
+  PacketWriter w(out, cap);
+  w.header(MQTT_SUBACK << 4, 3);
+  w.u16(packetId);
+  w.byte(0);  // granted QoS 0
+  return w.done();
+}
+
+// -------- Reading --------
+void MqttReader::commit(size_t n) {
+  if (skip) {  // bytes of an oversized packet land at the start of buf
+    size_t d = n < skip ? n : skip;
+    skip -= d;
+    n -= d;
+    if (n) memmove(buf, buf + d, n);
+  }
+  have += n;
+}
+
+bool MqttReader::next(MqttPacket& p) {
+  if (used) {
+    memmove(buf, buf + used, have - used);
+    have -= used;
+    used = 0;
+  }
+  if (skip || have < 2) return false;
+
+  size_t len = 0, i = 1;
+  for (int shift = 0;; shift += 7) {
+    if (shift > 21) { reset(); return false; }  // malformed length
+    if (i >= have) return false;
+    uint8_t b = buf[i++];
+    len |= (size_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) break;
+  }
+  size_t total = i + len;
+  if (total > cap) {
+    dropped++;
+    skip = total - have;
+    have = 0;
+    return false;
+  }
+  if (have < total) return false;
+
+  p.type = buf[0] >> 4;
+  p.flags = buf[0] & 0x0F;
+  p.body = buf + i;
+  p.len = len;
+  used = total;
+  return true;
+}
+
+bool mqttParsePublish(const MqttPacket& p, const char*& topic, size_t& topicLen,
+                      const uint8_t*& payload, size_t& len) {
+  if (p.type != MQTT_PUBLISH || p.len < 2) return false;
+  topicLen = (size_t)p.body[0] << 8 | p.body[1];
+  size_t at = 2 + topicLen;
+  if (p.flags & 0x06) at += 2;  // QoS > 0 carries a packet id
+  if (at > p.len) return false;
+  topic = (const char*)p.body + 2;
+  payload = p.body + at;
+  len = p.len - at;
+  return true;
+}
@@ -0,0 +1,11 @@
+// ===================================================
+// Linux entry point (PlatformIO `native` env)
+// ===================================================
+// Runs the same app as the ESP32 against hal_native.cpp:
+//   pio run -e native && PLANTERBOX_PORT=3000 .pio/build/native/program
+#include "app.h"
+
+int main() {
+  appSetup();
+  for (;;) appLoop();
+}
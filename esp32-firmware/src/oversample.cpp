@@ -0,0 +1,74 @@
+#include "oversample.h"
+#include "hal.h"
+#include "trace.h"
+#include <string.h>
+#include <algorithm>
+
+const float NOISE_EMA_ALPHA = 0.25f;  // weight of the newest burst in the noise estimate
+const float MIN_SIGMA_MV = 2.0f;  // floor for spike detection on very quiet channels
+
+uint8_t AdaptiveOversampler::samplesFor(float var) const {
+  float n = var / (pol.targetSE * pol.targetSE);
+  if (n < pol.minN) return pol.minN;
+  if (n > pol.maxN) return pol.maxN;
+  return (uint8_t)ceilf(n);
+}
+
+float AdaptiveOversampler::read() {
+  TRACE_SCOPE(TRACE_ADC_BURST);
+  uint16_t buf[OVERSAMPLE_MAX_N];
+  Welford w;
+
+  // Start from what the last known noise level needs; with no history, be
+  // conservative and take the maximum.
+  uint8_t want = hasNoise ? samplesFor(noiseVar) : pol.maxN;
+  if (want == 0) want = 1;
+  uint8_t n = 0;
+  while (n < want) {
+    buf[n] = hal::adcReadMilliVolts(pin);
+    w.add(buf[n]);
+    n++;
+    // This burst turned out noisier than predicted: extend it
+    if (n == want && want < pol.maxN) want = std::max(want, samplesFor(w.variance()));
+    if (n < want && pol.spacingMs) hal::delayMs(pol.spacingMs);
+  }
+
+  // Spike check against the median, scaled by a robust sigma (MAD) so a
+  // single outlier can't hide by inflating this burst's own variance.
+  uint16_t sorted[OVERSAMPLE_MAX_N];
+  memcpy(sorted, buf, n * sizeof(uint16_t));
+  std::sort(sorted, sorted + n);
+  float median = sorted[n / 2];
+
+  float dev[OVERSAMPLE_MAX_N];
+  for (uint8_t i = 0; i < n; i++) dev[i] = fabsf(buf[i] - median);
+  std::nth_element(dev, dev + n / 2, dev + n);
+  float robustSigma = 1.4826f * dev[n / 2];
+  float sig = std::max(robustSigma, MIN_SIGMA_MV);
+
+  bool spiky = false;
+  for (uint8_t i = 0; i < n; i++) {
+    if (fabsf(buf[i] - median) > pol.spikeK * sig) { spiky = true; break; }
+  }
+
+  float result;
+  float burstVar;
+  if (spiky) {
+    // Trimmed mean: drop the outer quarter on each side
+    uint8_t cut = n / 4;
+    Welford t;
+    for (uint8_t i = cut; i < n - cut; i++) t.add(sorted[i]);
+    result = t.mean;
+    burstVar = robustSigma * robustSigma;  // trimmed variance would understate the noise
+    spikes++;
+  } else {
+    result = w.mean;
+    burstVar = w.variance();
+  }
+
+  noiseVar = hasNoise ? noiseVar + NOISE_EMA_ALPHA * (burstVar - noiseVar) : burstVar;
+  hasNoise = true;
+  lastN = n;
+  trimmed = spiky;
+  return result;
+}
@@ -0,0 +1,142 @@
+#include "push.h"
+#include "config.h"
+#include "hal.h"
+#include "mqtt.h"
+#include "identity.h"
+#include "uplink.h"
+#include "metrics.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+
+static constexpr LogModule LOG_THIS = LOG_MOD_UPLINK;
+
+enum PushState : uint8_t { PUSH_IDLE, PUSH_CONNECTING, PUSH_UP };
+
+static PushState state = PUSH_IDLE;
+static bool enabled = PUSH_ENABLED;
+static uint32_t retryAt = 0, backoffMs = PUSH_RETRY_MIN_MS;
+static uint32_t connectedAt = 0, lastRx = 0, lastTx = 0;
+
+// Commands are small JSON objects; telemetry is an uplink payload plus topic
+static uint8_t rxBuf[UPLINK_RESP_BYTES];
+static MqttReader reader(rxBuf, sizeof(rxBuf));
+static uint8_t txBuf[UPLINK_PAYLOAD_BYTES + 64];
+
+static char cmdTopic[64];
+static char telemetryTopic[64];
+
+static bool send(size_t n) {
+  if (!n || !hal::streamWrite(txBuf, n)) return false;
+  lastTx = hal::millis();
+  return true;
+}
+
+static void drop(const char* why) {
+  hal::streamClose();
+  if (state == PUSH_UP) LOGW("[PUSH] disconnected: %s\n", why);
+  else LOGD("[PUSH] connect failed: %s (retry in %lu ms)\n", why, (unsigned long)backoffMs);
+  state = PUSH_IDLE;
+  retryAt = hal::millis() + backoffMs;
+  backoffMs = backoffMs * 2 < PUSH_RETRY_MAX_MS ? backoffMs * 2 : PUSH_RETRY_MAX_MS;
+}
+
+static void connect() {
+  snprintf(cmdTopic, sizeof(cmdTopic), "planterbox/%s/cmd", deviceId());
+  snprintf(telemetryTopic, sizeof(telemetryTopic), "planterbox/%s/telemetry", deviceId());
+  char clientId[40];
+  snprintf(clientId, sizeof(clientId), "%s", deviceId());
+
+  if (!hal::streamConnect(MQTT_HOST, MQTT_PORT, MQTT_TLS)) { drop("no connection"); return; }
+  reader.reset();
+  if (!send(mqttConnect(txBuf, sizeof(txBuf), clientId, PUSH_KEEPALIVE_S))) { drop("send"); return; }
+  state = PUSH_CONNECTING;
+  connectedAt = lastRx = hal::millis();
+}
+
+static void handle(const MqttPacket& p) {
+  switch (p.type) {
+    case MQTT_CONNACK:
+      if (p.len < 2 || p.body[1] != 0) { drop("refused"); return; }
+      if (!send(mqttSubscribe(txBuf, sizeof(txBuf), 1, cmdTopic))) { drop("send"); return; }
+      state = PUSH_UP;
+      backoffMs = PUSH_RETRY_MIN_MS;
+      metrics.pushConnects++;
+      LOGI("[PUSH] connected to %s:%u, listening on %s\n", MQTT_HOST, MQTT_PORT, cmdTopic);
+      break;
+
+    case MQTT_PUBLISH: {
+      const char* topic;
+      size_t topicLen, len;
+      const uint8_t* payload;
+      if (!mqttParsePublish(p, topic, topicLen, payload, len)) return;
+      if (topicLen != strlen(cmdTopic) || memcmp(topic, cmdTopic, topicLen)) return;
+      metrics.pushCommands++;
+      LOGD("[PUSH] command: %.*s\n", (int)len, (const char*)payload);
+      uplinkApplyCommands((const char*)payload, len);
+      break;
+    }
+
+    default: break;  // SUBACK, PINGRESP: lastRx already says the link is alive
+  }
+}
+
+void pushTick() {
+  if (!enabled || !hal::networkUp()) {
+    if (state != PUSH_IDLE) drop("disabled");
+    return;
+  }
+  uint32_t now = hal::millis();
+  if (state == PUSH_IDLE) {
+    if ((int32_t)(now - retryAt) >= 0) connect();
+    return;
+  }
+
+  while (reader.writeSpace()) {
+    int n = hal::streamRead(reader.writePtr(), reader.writeSpace());
+    if (n < 0) { drop("closed by broker"); return; }
+    if (n == 0) break;
+    reader.commit(n);
+    lastRx = now;
+    MqttPacket p;
+    while (reader.next(p)) {
+      handle(p);
+      if (state == PUSH_IDLE) return;
+    }
+  }
+
+  // Keepalive: ping at half the interval, give up at 1.5x without traffic
+  uint32_t keepMs = PUSH_KEEPALIVE_S * 1000UL;
+  if (state == PUSH_CONNECTING && now - connectedAt > 5000) { drop("no CONNACK"); return; }
+  if (now - lastRx > keepMs + keepMs / 2) { drop("keepalive timeout"); return; }
+  if (state == PUSH_UP && now - lastTx >= keepMs / 2 && !send(mqttPingReq(txBuf, sizeof(txBuf)))) drop("send");
+}
+
+bool pushUp() { return state == PUSH_UP; }
+
+bool pushTelemetry(const uint8_t* payload, size_t len, bool cbor) {
+  if (state != PUSH_UP) return false;
+  char topic[sizeof(telemetryTopic) + 8];
+  snprintf(topic, sizeof(topic), "%s/%s", telemetryTopic, cbor ? "cbor" : "json");
+  if (send(mqttPublish(txBuf, sizeof(txBuf), topic, payload, len))) return true;
+  drop("publish failed");
+  return false;
+}
+
+void pushEnable(bool on) {
+  enabled = on;
+  backoffMs = PUSH_RETRY_MIN_MS;
+  retryAt = hal::millis();
+}
+
+bool pushEnabled() { return enabled; }
+
+const char* pushStateName() {
+  if (!enabled) return "off";
+  switch (state) {
+    case PUSH_IDLE:       return "retrying";
+    case PUSH_CONNECTING: return "connecting";
+    case PUSH_UP:         return "up";
+  }
+  return "?";
+}
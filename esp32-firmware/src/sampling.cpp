@@ -0,0 +1,43 @@
+#include "sampling.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+void AdaptiveSampler::setPolicy(const SamplingPolicy& p) {
+  pol = p;
+  if (pol.fastMs == 0 || pol.fastMs > pol.slowMs) pol.fastMs = pol.slowMs;
+  switch (pol.mode) {
+    case SAMPLE_FIXED:     interval = pol.slowMs; break;
+    case SAMPLE_ADAPTIVE:  interval = pol.fastMs; break;  // start dense, back off
+    case SAMPLE_ON_DEMAND: interval = 0; break;
+  }
+}
+
+uint32_t AdaptiveSampler::update(float value, bool transient) {
+  bool moved = hasLast && fabsf(value - last) > pol.delta;
+  last = value;
+  hasLast = true;
+
+  if (pol.mode != SAMPLE_ADAPTIVE) return interval;
+
+  if (transient || moved) interval = pol.fastMs;
+  else interval = std::min(interval * 2, pol.slowMs);
+  return interval;
+}
+
+const char* sampleModeName(SampleMode m) {
+  switch (m) {
+    case SAMPLE_FIXED:     return "fixed";
+    case SAMPLE_ADAPTIVE:  return "adaptive";
+    case SAMPLE_ON_DEMAND: return "on_demand";
+  }
+  return "?";
+}
+
+bool parseSampleMode(const char* s, SampleMode& out) {
+  if (!s) return false;
+  if (!strcmp(s, "fixed"))     { out = SAMPLE_FIXED;     return true; }
+  if (!strcmp(s, "adaptive"))  { out = SAMPLE_ADAPTIVE;  return true; }
+  if (!strcmp(s, "on_demand")) { out = SAMPLE_ON_DEMAND; return true; }
+  return false;
+}
@@ -0,0 +1,122 @@
+#include "scheduler.h"
+#include "hal.h"
+#include "trace.h"
+
+// Wrap-safe "a is at or after b" for 32-bit microsecond timestamps
+static inline bool reached(uint32_t now, uint32_t due) {
+  return (int32_t)(now - due) >= 0;
+}
+
+void Scheduler::begin() {
+  uint32_t now = hal::micros();
+  for (size_t i = 0; i < count; i++) {
+    stats[i] = JobStats{};
+    stats[i].periodMs    = jobs[i].periodMs;
+    stats[i].nextDueUs   = now;  // everything runs once right after boot
+    stats[i].lastStartUs = now;
+    if (TRACE_JOB_BASE + i <= 0xFF) traceSetName(TRACE_JOB_BASE + i, jobs[i].name);
+  }
+}
+
+int Scheduler::runOnce() {
+  uint32_t now = hal::micros();
+
+  // Pick the most urgent due job (lowest priority value, then earliest deadline)
+  int pick = -1;
+  for (size_t i = 0; i < count; i++) {
+    if (stats[i].dormant || !reached(now, stats[i].nextDueUs)) continue;
+    if (pick < 0 ||
+        jobs[i].priority < jobs[pick].priority ||
+        (jobs[i].priority == jobs[pick].priority &&
+         (int32_t)(stats[i].nextDueUs - stats[pick].nextDueUs) < 0)) {
+      pick = (int)i;
+    }
+  }
+
+  if (pick < 0) {
+    // Nothing due: sleep until the nearest deadline. On the ESP32 this is
+    // vTaskDelay, so the core idles instead of spinning; the sub-ms remainder
+    // is a short busy wait (and moves a virtual clock, which yield() can't).
+    uint32_t wait = 1000000UL;
+    for (size_t i = 0; i < count; i++) {
+      if (stats[i].dormant) continue;
+      uint32_t d = stats[i].nextDueUs - now;
+      if (d < wait) wait = d;
+    }
+    if (wait >= 1000) hal::delayMs(wait / 1000);
+    else hal::delayUs(wait);
+    return -1;
+  }
+
+  const Job& job = jobs[pick];
+  JobStats& st = stats[pick];
+
+  uint32_t jitter = now - st.nextDueUs;
+
+  // Advance on the original grid so periods don't drift. This happens before
+  // the call so a job can retune itself via setPeriod() while it runs.
+  st.lastStartUs = now;
+  if (st.periodMs == 0) st.dormant = true;
+  else st.nextDueUs += st.periodMs * 1000UL;
+
+  job.fn();
+  uint32_t after = hal::micros();
+  uint32_t ran = after - now;
+  #if TRACE_ENABLED
+  traceRecord(TRACE_JOB_BASE + pick, now, ran);
+  #endif
+
+  st.runs++;
+  st.lastRunUs = ran;
+  if (ran > st.maxRunUs) st.maxRunUs = ran;
+  if (ran > job.budgetUs) st.overruns++;
+  if (jitter > st.maxJitterUs) st.maxJitterUs = jitter;
+  st.sumJitterUs += jitter;
+
+  // If we fell more than a full period behind, drop the backlog instead of
+  // bursting to catch up.
+  uint32_t periodUs = st.periodMs * 1000UL;
+  if (!st.dormant && periodUs && reached(after, st.nextDueUs + periodUs)) {
+    st.missed += (after - st.nextDueUs) / periodUs;
+    st.nextDueUs = after + periodUs;
+  }
+  return pick;
+}
+
+void Scheduler::report() const {
+  hal::logf("[SCHED] job            period  runs    overrun missed  maxRun(us) avgJit(us) maxJit(us)\n");
+  for (size_t i = 0; i < count; i++) {
+    const JobStats& st = stats[i];
+    uint32_t avgJitter = st.runs ? (uint32_t)(st.sumJitterUs / st.runs) : 0;
+    hal::logf("[SCHED] %-14s %6lu  %-7lu %-7lu %-7lu %-10lu %-10lu %lu\n",
+                  jobs[i].name, (unsigned long)st.periodMs,
+                  (unsigned long)st.runs, (unsigned long)st.overruns,
+                  (unsigned long)st.missed, (unsigned long)st.maxRunUs,
+                  (unsigned long)avgJitter, (unsigned long)st.maxJitterUs);
+  }
+}
+
+void Scheduler::resetStats() {
+  for (size_t i = 0; i < count; i++) {
+    JobStats& st = stats[i];
+    st.runs = st.overruns = st.missed = 0;
+    st.maxRunUs = st.maxJitterUs = 0;
+    st.sumJitterUs = 0;
+  }
+}
+
+void Scheduler::setPeriod(size_t id, uint32_t periodMs) {
+  JobStats& st = stats[id];
+  st.periodMs = periodMs;
+  if (periodMs == 0) { st.dormant = true; return; }
+
+  uint32_t now = hal::micros();
+  st.dormant = false;
+  st.nextDueUs = st.lastStartUs + periodMs * 1000UL;
+  if (reached(now, st.nextDueUs)) st.nextDueUs = now;
+}
+
+void Scheduler::trigger(size_t id) {
+  stats[id].dormant = false;
+  stats[id].nextDueUs = hal::micros();
+}
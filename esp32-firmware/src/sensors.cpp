@@ -0,0 +1,167 @@
+#include "sensors.h"
+#include "config.h"
+#include "hal.h"
+#include "oversample.h"
+#include "filter_pipeline.h"
+#include "logger.h"
+#include "memstats.h"
+#include <math.h>
+#include <algorithm>
+
+static constexpr LogModule LOG_THIS = LOG_MOD_SENSORS;
+
+SensorFrame latestFrame;
+float currentTempC = 25.0;
+float currentDistanceCm = 0.0;
+unsigned long lastDistanceReadMs = 0;
+
+// Ultrasonic (debug)
+static long lastEchoDurationUs = 0;
+
+// -------- Cached raw readings for logs --------
+static int   lastWaterADC = 0;
+static long  lastPhSum = 0;
+static float lastPhAvg = 0;
+static float lastPhVolt = 0;
+static float lastPhValue = 0;
+static long  lastPpmSum = 0;
+static float lastPpmVolt = 0;
+static float lastPpmVal  = 0;
+
+// Analog channels are read as calibrated millivolts (hal::adcReadMilliVolts),
+// so there is no Vref/full-scale constant to get wrong any more.
+// Oversampling targets are in mV: 1.2 mV is ~0.012 pH with the local
+// calibration below, 4 mV is ~1.7 ppm.
+//                                        minN maxN targetSE spikeK spacing
+AdaptiveOversampler phSampler (PH_SENSOR_PIN,  { 4,  64,  1.2f,   4.0f,  5 });
+AdaptiveOversampler ppmSampler(PPM_SENSOR_PIN, { 4,  32,  4.0f,   4.0f,  5 });
+
+const int ADC_FRAC = 16;  // burst means enter the filters in 1/16 mV
+
+// --- Jonathan’s 5–9 pH local calibration ---
+// Fitted on the old analogRead()*3.3/4095 scale, which at 11 dB sits
+// 100-150 mV off calibrated mV mid-range (~1 pH). Readings are mapped back
+// onto that scale until these are refitted against buffers in calibrated mV.
+const float PH_SLOPE     = -9.76f;  // pH per V
+const float PH_INTERCEPT = 19.45f;
+const float PPM_PER_VOLT = 420.0f;
+
+// Calibrated mV -> the legacy scale the constants above expect
+static float legacyMilliVolts(uint8_t pin, float mv) {
+  return hal::adcMilliVoltsToRaw(pin, mv) * 3300.0f / 4095.0f;
+}
+
+// Reject a single bad burst, lightly smooth, then calibrate. Outputs are
+// milli-pH and deci-ppm so the whole chain stays in integers.
+typedef FilterPipeline<MedianFilter<3>, EmaFilter<1>, LinearCal> SensorFilter;
+SensorFilter phFilter({}, {}, LinearCal::fromFloat(
+    PH_SLOPE / ADC_FRAC, PH_INTERCEPT * 1000.0f));
+SensorFilter ppmFilter;
+
+void sensorsBegin() {
+  hal::dhtBegin();
+  hal::pinOutput(TRIG_PIN); hal::pinInput(ECHO_PIN);
+  hal::pinInput(PPM_SENSOR_PIN); hal::pinInput(PH_SENSOR_PIN);
+  hal::pinInput(WATER_SENSOR_PIN);
+  hal::adcAttach(PH_SENSOR_PIN,    3100);  // probe board swings ~0-3 V
+  hal::adcAttach(PPM_SENSOR_PIN,   2450);  // TDS board tops out ~2.3 V
+  hal::adcAttach(WATER_SENSOR_PIN, 3100);
+}
+
+void readDHT() {
+  MEM_REGION(MEM_SENSING);
+  float h, t;
+  hal::dhtRead(t, h);
+  if (isnan(h)) { h = 0; }
+  if (isnan(t)) { t = 0; }
+  latestFrame.temperature = t;
+  latestFrame.humidity    = h;
+  currentTempC = t;
+
+  LOGD("[DHT11] Temp: %.2f C | Humidity: %.2f %%\n", t, h);
+  sampleDone(SENSOR_DHT, t);
+}
+
+void readUltrasonic() {
+  MEM_REGION(MEM_SENSING);
+  hal::digitalWrite(TRIG_PIN, false); hal::delayUs(2);
+  hal::digitalWrite(TRIG_PIN, true); hal::delayUs(10);
+  hal::digitalWrite(TRIG_PIN, false);
+  long duration = hal::pulseInHigh(ECHO_PIN, 30000); // 30 ms timeout
+  float dist = duration * 0.034f / 2.0f;
+  if (dist > 0 && dist < 400) {
+    currentDistanceCm = dist;
+    lastEchoDurationUs = duration;
+  }
+  latestFrame.distance = currentDistanceCm;
+  lastDistanceReadMs = hal::millis();
+
+  LOGD("[ULTRASONIC] Duration: %ld us | Distance: %.2f cm\n", lastEchoDurationUs, currentDistanceCm);
+  sampleDone(SENSOR_DISTANCE, currentDistanceCm);
+}
+
+void readPpmSensor() {
+  MEM_REGION(MEM_SENSING);
+  float mv = ppmSampler.read();
+  long sum = lroundf(mv * ppmSampler.lastCount());
+  float v = mv / 1000.0f;
+  float comp = 1.0f + 0.02f*(currentTempC-25.0f);
+  // Temperature compensation folds into the calibration gain
+  ppmFilter.cal = LinearCal::fromFloat(PPM_PER_VOLT / 1000.0f / ADC_FRAC * 10.0f / comp, 0);
+  float ppm = ppmFilter.process(lroundf(legacyMilliVolts(PPM_SENSOR_PIN, mv) * ADC_FRAC)) / 10.0f;
+
+  latestFrame.ppm = ppm;
+
+  lastPpmSum = sum;
+  lastPpmVolt = v;
+  lastPpmVal = ppm;
+
+  LOGD("[PPM] avg: %.1f mV (n=%u, sigma=%.1f%s) | Volt: %.3f V | Temp: %.2f C | CompPPM: %.2f\n",
+       mv, ppmSampler.lastCount(), ppmSampler.sigma(), ppmSampler.lastTrimmed() ? ", trimmed" : "",
+       v, currentTempC, ppm);
+  sampleDone(SENSOR_PPM, ppm);
+}
+
+void readPhSensor() {
+  MEM_REGION(MEM_SENSING);
+  float mv = phSampler.read();
+  long sum = lroundf(mv * phSampler.lastCount());
+  float v = mv / 1000.0f;
+  float legacyMv = legacyMilliVolts(PH_SENSOR_PIN, mv);
+
+    // If no signal, set pH = 0. Checked on the legacy scale: calibrated mV
+    // never gets there, raw 0 reads as 75-150 mV at 11 dB
+  float ph;
+  if (legacyMv <= 10.0f) {   // ~10 mV tolerance to catch open/faulty readings
+    ph = 0.0f;
+    phFilter.reset();  // don't blend the dead probe into the next real reading
+  } else {
+  ph = phFilter.process(lroundf(legacyMv * ADC_FRAC)) / 1000.0f;
+
+  // Clamp to a reasonable plant range
+  ph = std::min(std::max(ph, 4.5f), 9.5f);
+  }
+  latestFrame.ph = ph;
+
+  lastPhSum   = sum;
+  lastPhAvg   = mv;
+  lastPhVolt  = v;
+  lastPhValue = ph;
+
+  LOGD("[pH] avg: %.1f mV (n=%u, sigma=%.1f%s) | Volt: %.3f V | pH: %.2f\n",
+       mv, phSampler.lastCount(), phSampler.sigma(), phSampler.lastTrimmed() ? ", trimmed" : "",
+       v, ph);
+  sampleDone(SENSOR_PH, ph);
+}
+
+void readWaterSensor() {
+  MEM_REGION(MEM_SENSING);
+  int val = hal::adcReadRaw(WATER_SENSOR_PIN);  // threshold is in raw counts
+  bool ok = val > WATER_THRESHOLD;
+  latestFrame.waterSufficient = ok;
+  lastWaterADC = val;
+
+  LOGD("[WATER] ADC: %d | threshold: %d | Sufficient: %s\n",
+       val, WATER_THRESHOLD, ok ? "YES" : "NO");
+  sampleDone(SENSOR_WATER, (float)val);
+}
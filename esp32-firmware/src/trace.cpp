@@ -0,0 +1,73 @@
+#include "trace.h"
+#include "hal.h"
+
+static const uint32_t CAPACITY = TRACE_ENABLED ? TRACE_CAPACITY : 1;
+static TraceRecord ring[CAPACITY];
+static uint32_t head = 0;     // total records written; ring index is head % CAPACITY
+static uint32_t dropped = 0;  // overwritten before a dump
+static uint32_t minUs = 50;   // the 50 ms dosing tick would flood the ring otherwise
+static bool enabled = TRACE_ENABLED;
+
+static const char* names[256] = {
+  "adc_burst", "encode", "connect", "post", "parse", "apply", "console",
+};
+
+void traceRecord(uint8_t id, uint32_t startUs, uint32_t durUs) {
+  if (!enabled || durUs < minUs) return;
+  if (head >= CAPACITY) dropped++;
+  TraceRecord& r = ring[head % CAPACITY];
+  r.startUs = startUs;
+  r.durAndId = tracePack(id, durUs);
+  head++;
+}
+
+void traceSetName(uint8_t id, const char* name) { names[id] = name; }
+void traceEnable(bool on) { enabled = on; }
+void traceSetMinUs(uint32_t us) { minUs = us; }
+void traceClear() { head = dropped = 0; }
+
+static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Up to 48 bytes (6 records) -> 64 base64 chars per line
+static void dumpLine(const uint8_t* p, size_t n) {
+  char out[65];
+  size_t o = 0;
+  for (size_t i = 0; i < n; i += 3) {
+    uint32_t v = p[i] << 16 | (i + 1 < n ? p[i + 1] << 8 : 0) | (i + 2 < n ? p[i + 2] : 0);
+    out[o++] = B64[v >> 18 & 63];
+    out[o++] = B64[v >> 12 & 63];
+    out[o++] = i + 1 < n ? B64[v >> 6 & 63] : '=';
+    out[o++] = i + 2 < n ? B64[v & 63] : '=';
+  }
+  out[o] = '\0';
+  hal::logf("[TRACE] data %s\n", out);
+}
+
+void traceDump() {
+  // Stop recording so the dump's own logging can't overwrite what it prints
+  bool was = enabled;
+  enabled = false;
+
+  uint32_t count = head < CAPACITY ? head : CAPACITY;
+  hal::logf("[TRACE] begin 1 %lu %lu %lu\n", (unsigned long)count,
+            (unsigned long)dropped, (unsigned long)hal::micros());
+  for (int id = 0; id < 256; id++) {
+    if (names[id]) hal::logf("[TRACE] name %d %s\n", id, names[id]);
+  }
+
+  // Oldest first, serialised little-endian whatever the host order
+  uint8_t line[6 * sizeof(TraceRecord)];
+  size_t fill = 0;
+  for (uint32_t i = head - count; i != head; i++) {
+    const TraceRecord& r = ring[i % CAPACITY];
+    const uint32_t words[2] = { r.startUs, r.durAndId };
+    for (uint32_t w : words) {
+      for (int b = 0; b < 4; b++) line[fill++] = w >> (8 * b);
+    }
+    if (fill == sizeof(line)) { dumpLine(line, fill); fill = 0; }
+  }
+  if (fill) dumpLine(line, fill);
+  hal::logf("[TRACE] end\n");
+
+  enabled = was;
+}
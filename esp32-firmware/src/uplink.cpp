@@ -0,0 +1,539 @@
+#include "uplink.h"
+#include "config.h"
+#include "hal.h"
+#include "dosing.h"
+#include "light.h"
+#include "app.h"
+#include "trace.h"
+#include "metrics.h"
+#include "logger.h"
+#include "memstats.h"
+#include "cbor.h"
+#include "deadband.h"
+#include "push.h"
+#include "gateway.h"
+#include "identity.h"
+#include "dns_cache.h"
+#include <string.h>
+#include <ArduinoJson.h>
+
+static constexpr LogModule LOG_THIS = LOG_MOD_UPLINK;
+
+// -------- Per-cycle arena --------
+// Everything the upload path needs comes from here and is dropped at the
+// start of the next cycle, so after boot it does no heap allocation.
+static StaticArena<UPLINK_ARENA_BYTES> arena;
+
+class ArenaJsonAllocator : public ArduinoJson::Allocator {
+public:
+  void* allocate(size_t n) override { return arena.alloc(n); }
+  void deallocate(void*) override {}  // freed wholesale by arena.reset()
+  void* reallocate(void* p, size_t n) override { return arena.realloc(p, n); }
+};
+static ArenaJsonAllocator jsonAllocator;
+
+const Arena& uplinkArena() { return arena; }
+
+// -------- Deadband --------
+// A stable reservoir produces near-identical frames; only send when a value
+// leaves its band, or on the heartbeat. Bands sit around sensor noise and
+// well inside the dosing targets.
+static const Deadband DEADBAND = {
+  // temperature  humidity  distance  ppm    ph
+  0.5f,           2.0f,     1.0f,     20.0f, 0.05f
+};
+static DeadbandFilter deadband(DEADBAND, UPLINK_HEARTBEAT_MS);
+
+// -------- Windows --------
+// Closed windows wait here until the server has them; when full the oldest
+// is dropped (uplinkWindowsDropped). In the other modes they are
+// only kept while the breaker is open, so an outage leaves summaries
+// rather than a gap; the backlog goes out before the next live frame.
+static WindowAggregator windows(UPLINK_WINDOW_MS);
+static WindowSummary pending[UPLINK_WINDOW_BACKLOG];
+static uint32_t pendingSeq[UPLINK_WINDOW_BACKLOG];  // fixed at queueing, so resends repeat it
+static int pendingHead = 0, pendingCount = 0;
+
+// -------- Frame IDs --------
+static uint32_t session = 0;
+static uint32_t nextSeq = 1;
+
+static FrameId frameId(uint32_t seq) {
+  if (!session) session = hal::randomU32() | 1;  // 0 means "not yet"
+  FrameId id = { deviceId(), session, seq };
+  return id;
+}
+
+static UplinkMode mode = UPLINK_DEADBAND;
+
+// -------- Retry policy and pacing --------
+static UplinkPolicy policy(UPLINK_RETRY_MIN_MS, UPLINK_RETRY_MAX_MS, UPLINK_BREAKER_FAILURES,
+                           UPLINK_BREAKER_COOLDOWN_MS);
+static UploadPacer pacer(UPLINK_INTERVAL_MS, UPLINK_GAP_MAX_MS, UPLINK_SLOW_RTT_MS);
+
+const UplinkPolicy& uplinkPolicy() { return policy; }
+const UploadPacer& uplinkPacer() { return pacer; }
+
+// Outcome of one exchange with the server (HTTPS or the gateway)
+static void recordOutcome(int code, uint32_t now, uint32_t rttMs) {
+  BreakerState was = policy.state();
+  bool failed = UplinkPolicy::serverFailure(code);
+  pacer.observe(!failed, rttMs);
+  if (failed) policy.failed(now, hal::randomU32());
+  else policy.succeeded();
+  BreakerState is = policy.state();
+  if (is == BREAKER_OPEN && was != BREAKER_OPEN) {
+    LOGW("[HTTP] %d failures in a row: pausing uploads for %lu s\n", policy.consecutiveFailures(),
+         (unsigned long)(policy.waitMs(now) / 1000));
+  } else if (is == BREAKER_OPEN) {
+    LOGW("[HTTP] server still failing: next probe in %lu s\n", (unsigned long)(policy.waitMs(now) / 1000));
+  } else if (is == BREAKER_CLOSED && was != BREAKER_CLOSED) {
+    LOGI("[HTTP] server back, %d window(s) to catch up\n", pendingCount);
+  } else if (policy.waitMs(now)) {
+    LOGD("[HTTP] retry in %lu ms\n", (unsigned long)policy.waitMs(now));
+  }
+}
+
+static void queueWindow(const WindowSummary& s) {
+  if (pendingCount == UPLINK_WINDOW_BACKLOG) {
+    pendingHead = (pendingHead + 1) % UPLINK_WINDOW_BACKLOG;
+    pendingCount--;
+    metrics.uplinkWindowsDropped++;
+  }
+  int slot = (pendingHead + pendingCount++) % UPLINK_WINDOW_BACKLOG;
+  pending[slot] = s;
+  pendingSeq[slot] = nextSeq++;
+}
+
+void uplinkObserve(SensorId id) { windows.add(id, latestFrame); }
+
+UplinkMode uplinkMode() { return mode; }
+int uplinkPendingWindows() { return pendingCount; }
+
+void setUplinkMode(UplinkMode m) {
+  if (m == mode) return;
+  mode = m;
+  pendingCount = 0;
+  windows.close(hal::millis(), latestFrame);  // start a clean window
+  deadband.force();
+  LOGI("[HTTP] uplink mode: %s\n", uplinkModeName(m));
+}
+
+const char* uplinkModeName(UplinkMode m) {
+  switch (m) {
+    case UPLINK_RAW:      return "raw";
+    case UPLINK_DEADBAND: return "deadband";
+    case UPLINK_WINDOW:   return "window";
+  }
+  return "?";
+}
+
+bool parseUplinkMode(const char* s, UplinkMode& out) {
+  if (!s) return false;
+  if (!strcmp(s, "raw"))      { out = UPLINK_RAW;      return true; }
+  if (!strcmp(s, "deadband")) { out = UPLINK_DEADBAND; return true; }
+  if (!strcmp(s, "window"))   { out = UPLINK_WINDOW;   return true; }
+  return false;
+}
+
+// Field names / keys in AggField order
+static const char* const AGG_NAMES[AGG_FIELD_COUNT] = { "temperature", "humidity", "distance", "ppm", "ph" };
+static const FrameKey AGG_KEYS[AGG_FIELD_COUNT] = { FK_TEMPERATURE, FK_HUMIDITY, FK_DISTANCE, FK_PPM, FK_PH };
+
+size_t encodeFrameJson(const SensorFrame& f, const WindowSummary* window, const DeviceHealth* health,
+                       const FrameId& id, char* out, size_t cap) {
+  JsonDocument doc(&jsonAllocator);
+  doc["deviceId"] = id.device;
+  doc["fw"]       = FIRMWARE_VERSION;
+  doc["session"]  = id.session;
+  doc["seq"]      = id.seq;
+  doc["temperature"] = f.temperature;
+  doc["humidity"]    = f.humidity;
+  doc["distance"]    = f.distance;
+  doc["ppm"]         = f.ppm;
+  doc["ph"]          = f.ph;
+  doc["water_sufficient"] = f.waterSufficient;
+  if (window) {
+    doc["window_ms"] = window->endMs - window->startMs;
+    doc["age_ms"]    = hal::millis() - window->endMs;
+    JsonObject mn = doc["min"].to<JsonObject>();
+    JsonObject mx = doc["max"].to<JsonObject>();
+    JsonObject n  = doc["count"].to<JsonObject>();
+    for (int i = 0; i < AGG_FIELD_COUNT; i++) {
+      const FieldWindow& w = window->fields[i];
+      n[AGG_NAMES[i]] = w.count;
+      if (!w.count) continue;
+      mn[AGG_NAMES[i]] = w.min;
+      mx[AGG_NAMES[i]] = w.max;
+    }
+  }
+  if (health) {
+    JsonObject mem = doc["mem"].to<JsonObject>();
+    mem["free"]     = health->mem.heap.freeBytes;
+    mem["largest"]  = health->mem.heap.largestFreeBlock;
+    mem["min_free"] = health->mem.heap.minFreeBytes;
+    mem["frag"]     = health->mem.fragPct;
+    mem["stack"]    = health->mem.loopStackFree;
+    mem["allocs"]   = health->allocs;
+  }
+  if (doc.overflowed()) return 0;
+  size_t n = serializeJson(doc, out, cap);
+  return n < cap ? n : 0;
+}
+
+// One of min / max / count as a FrameKey map over the fields that had readings
+static void writeWindowStat(CborWriter& w, const WindowSummary& s, int which) {
+  size_t present = 0;
+  for (const auto& f : s.fields) present += which == 2 || f.count;
+  w.map(present);
+  for (int i = 0; i < AGG_FIELD_COUNT; i++) {
+    const FieldWindow& f = s.fields[i];
+    if (which != 2 && !f.count) continue;
+    w.integer(AGG_KEYS[i]);
+    if (which == 0) w.number(f.min);
+    else if (which == 1) w.number(f.max);
+    else w.integer(f.count);
+  }
+}
+
+size_t encodeFrameCbor(const SensorFrame& f, const WindowSummary* window, const DeviceHealth* health,
+                       const FrameId& id, uint8_t* out, size_t cap) {
+  CborWriter w(out, cap);
+  w.map(10 + (window ? 5 : 0) + (health ? 1 : 0));
+  w.integer(FK_DEVICE_ID);   w.text(id.device);
+  w.integer(FK_FW);          w.text(FIRMWARE_VERSION);
+  w.integer(FK_SESSION);     w.integer(id.session);
+  w.integer(FK_SEQ);         w.integer(id.seq);
+  w.integer(FK_TEMPERATURE); w.number(f.temperature);
+  w.integer(FK_HUMIDITY);    w.number(f.humidity);
+  w.integer(FK_DISTANCE);    w.number(f.distance);
+  w.integer(FK_PPM);         w.number(f.ppm);
+  w.integer(FK_PH);          w.number(f.ph);
+  w.integer(FK_WATER_SUFFICIENT); w.boolean(f.waterSufficient);
+  if (window) {
+    w.integer(FK_WINDOW_MS); w.integer(window->endMs - window->startMs);
+    w.integer(FK_AGE_MS);    w.integer(hal::millis() - window->endMs);
+    w.integer(FK_MIN);       writeWindowStat(w, *window, 0);
+    w.integer(FK_MAX);       writeWindowStat(w, *window, 1);
+    w.integer(FK_COUNT);     writeWindowStat(w, *window, 2);
+  }
+  if (health) {
+    w.integer(FK_MEM);
+    w.map(6);
+    w.integer(MK_FREE);     w.integer(health->mem.heap.freeBytes);
+    w.integer(MK_LARGEST);  w.integer(health->mem.heap.largestFreeBlock);
+    w.integer(MK_MIN_FREE); w.integer(health->mem.heap.minFreeBytes);
+    w.integer(MK_FRAG);     w.integer(health->mem.fragPct);
+    w.integer(MK_STACK);    w.integer(health->mem.loopStackFree);
+    w.integer(MK_ALLOCS);   w.integer(health->allocs);
+  }
+  return w.ok() ? w.size() : 0;
+}
+
+bool decodeFrameCbor(const uint8_t* in, size_t len, SensorFrame& f) {
+  CborReader r(in, len);
+  size_t n;
+  if (!r.map(n)) return false;
+  for (size_t i = 0; i < n; i++) {
+    int64_t key;
+    float v;
+    if (!r.integer(key)) return false;
+    switch (key) {
+      case FK_TEMPERATURE: if (r.number(v)) f.temperature = v; break;
+      case FK_HUMIDITY:    if (r.number(v)) f.humidity = v; break;
+      case FK_DISTANCE:    if (r.number(v)) f.distance = v; break;
+      case FK_PPM:         if (r.number(v)) f.ppm = v; break;
+      case FK_PH:          if (r.number(v)) f.ph = v; break;
+      case FK_WATER_SUFFICIENT: if (r.number(v)) f.waterSufficient = v != 0; break;
+      default:             r.skip(); break;
+    }
+    if (!r.ok()) return false;
+  }
+  return true;
+}
+
+static void logHeaderCycle() {
+  LOGD("========== LOOP ==========\n");
+  LOGD("[TIME] millis=%lu | WiFi=%s\n",
+       (unsigned long)hal::millis(),
+       (hal::networkUp() ? "CONNECTED" : "NOT CONNECTED"));
+  LOGD("[LOCKOUT] %s | remaining: %lu ms\n",
+       isLockedOut() ? "ACTIVE" : "INACTIVE",
+       lockoutRemaining());
+}
+
+// The server has this frame / the oldest `windows` windows (or refused them
+// for good: they're off the backlog all the same)
+static void delivered(int windows, const SensorFrame& frame) {
+  if (windows) {
+    pendingHead = (pendingHead + windows) % UPLINK_WINDOW_BACKLOG;
+    pendingCount -= windows;
+  } else deadband.sent(frame, hal::millis());
+}
+
+static size_t encodeFrame(const SensorFrame& f, const WindowSummary* window, const DeviceHealth* health,
+                          const FrameId& id, uint8_t* out, size_t cap) {
+  return UPLINK_CBOR ? encodeFrameCbor(f, window, health, id, out, cap)
+                     : encodeFrameJson(f, window, health, id, (char*)out, cap);
+}
+
+// The oldest pending windows, up to `max` and as many as fit: one goes out
+// as a plain frame, several as an array with health on the first. Returns
+// the body size; `count` is how many windows it holds.
+static_assert(UPLINK_BATCH_MAX < 24, "CBOR array head must stay one byte");
+static size_t encodeWindows(const DeviceHealth& health, uint8_t* out, size_t cap, int max, int& count) {
+  size_t at = 1;  // the array head / '['
+  count = 0;
+  while (count < max && count < pendingCount) {
+    int slot = (pendingHead + count) % UPLINK_WINDOW_BACKLOG;
+    size_t sep = count && !UPLINK_CBOR ? 1 : 0;
+    if (at + sep + 2 > cap) break;  // keep room for ']' and the NUL
+    size_t n = encodeFrame(pending[slot].mean, &pending[slot], count ? nullptr : &health,
+                           frameId(pendingSeq[slot]), out + at + sep, cap - at - sep - 1);
+    if (!n) break;
+    if (sep) out[at] = ',';
+    at += sep + n;
+    count++;
+  }
+  if (count == 1) {
+    memmove(out, out + 1, --at);
+    out[at] = '\0';
+  } else if (count > 1) {
+    if (UPLINK_CBOR) out[0] = 0x80 | count;
+    else { out[0] = '['; out[at++] = ']'; out[at] = '\0'; }
+  }
+  return count ? at : 0;
+}
+
+// HTTPS to the server, by the cached address when there is one; if that
+// refuses the connection, once more on the next
+static int serverPost(const uint8_t* body, size_t len, char* resp, hal::HttpTiming& timing) {
+  const char* type = UPLINK_CBOR ? "application/cbor" : "application/json";
+  uint32_t addr = dnsCacheAddress();
+  int code = hal::httpPost(HOSTNAME, HTTPS_PORT, API_PATH, type, body, len, resp, UPLINK_RESP_BYTES, &timing, addr);
+  if (code != hal::HTTP_ERR_CONNECT || !addr) return code;
+  dnsCacheFailed(addr);
+  uint32_t next = dnsCacheAddress();
+  if (next == addr) return code;
+  LOGW("[HTTP] %s refused the connection, trying the next address\n", HOSTNAME);
+  return hal::httpPost(HOSTNAME, HTTPS_PORT, API_PATH, type, body, len, resp, UPLINK_RESP_BYTES, &timing, next);
+}
+
+// Nothing went out this tick. If an upload is expected by the next one,
+// connect now (failing over like serverPost()) so that upload skips the
+// connect. A connect that fails counts against the retry policy like a
+// failed upload would.
+static void warmUp(uint32_t now) {
+  if (!UPLINK_WARM_LEAD_MS || pushUp() || gatewayEnabled()) return;
+  uint32_t in = 0;  // until the next upload, as far as it's scheduled
+  switch (mode) {
+    case UPLINK_RAW:      break;
+    case UPLINK_DEADBAND: in = deadband.heartbeatInMs(now); break;
+    case UPLINK_WINDOW:   in = pendingCount ? 0 : windows.dueInMs(now); break;
+  }
+  uint32_t wait = pacer.waitMs(now, dosingActive());
+  if (policy.waitMs(now) > wait) wait = policy.waitMs(now);
+  if (wait > in) in = wait;
+  if (in > UPLINK_WARM_LEAD_MS) return;
+
+  uint32_t addr = dnsCacheAddress();
+  int warmed = hal::httpWarm(HOSTNAME, HTTPS_PORT, addr);
+  if (warmed < 0 && addr) {
+    dnsCacheFailed(addr);
+    uint32_t next = dnsCacheAddress();
+    if (next != addr) warmed = hal::httpWarm(HOSTNAME, HTTPS_PORT, next);
+  }
+  if (warmed > 0) metrics.uplinkWarmups++;
+  if (warmed >= 0) return;
+  LOGD("[HTTP] warm-up connect failed\n");
+  recordOutcome(hal::HTTP_ERR_CONNECT, hal::millis(), 0);
+}
+
+// Server reply: the POST response body (`upload`), or a message on the push channel.
+// Without `commands` only its pacing is taken (an error status).
+static void applyReply(const char* json, size_t len, bool upload, bool commands = true) {
+  JsonDocument doc(&jsonAllocator);
+  DeserializationError err;
+  {
+    TRACE_SCOPE(TRACE_PARSE);
+    MEM_REGION(MEM_JSON);
+    err = deserializeJson(doc, json, len);
+  }
+  if(err){
+    metrics.jsonParseErrors++;
+    LOGW("[JSON] Parse error: %s\n", err.c_str());
+    return;
+  }
+
+  // Pacing, e.g. {"next_upload_ms":60000,"batch_hint":4}. An upload
+  // reply without it gives pacing back to the device; pushed commands
+  // usually don't carry it and leave it alone.
+  if (upload || !doc["next_upload_ms"].isNull()) {
+    uint32_t gapMs = doc["next_upload_ms"] | 0UL;
+    bool was = pacer.serverPaced();
+    pacer.hint(gapMs, doc["batch_hint"] | 0);
+    if (pacer.serverPaced()) LOGD("[HTTP] server pacing: %lu ms between uploads, batch %d\n",
+                                  (unsigned long)pacer.gapMs(false), pacer.batch(UPLINK_BATCH_MAX));
+    else if (was) LOGD("[HTTP] server pacing lifted\n");
+  }
+
+  if (!commands) return;
+
+  DeviceCommands cmd;
+  cmd.light  = doc["light"]|0;
+  cmd.phUp   = doc["ph_up_pump"]|false;
+  cmd.phDown = doc["ph_down_pump"]|false;
+  cmd.ppmA   = doc["ppm_a_pump"]|false;
+  cmd.ppmB   = doc["ppm_b_pump"]|false;
+  cmd.lockoutMs = doc["lockout_ms"]|120000UL;
+  cmd.doseMs = doc["dose_ms"]|0UL;
+
+  LOGD("[CMD] light=%d, ph_up=%d, ph_down=%d, ppm_a=%d, ppm_b=%d, lockout_hint=%lu ms, dose=%lu ms\n",
+       cmd.light, cmd.phUp, cmd.phDown, cmd.ppmA, cmd.ppmB, cmd.lockoutMs, cmd.doseMs);
+
+  TRACE_SCOPE(TRACE_APPLY);
+
+  // Apply light immediately
+  controlGrowLight(cmd.light);
+
+  // Optional runtime sampling overrides
+  if (!doc["sampling"].isNull()) applySamplingConfig(doc["sampling"]);
+
+  // ... and uplink mode, e.g. {"uplink":{"mode":"raw","window_ms":60000}}
+  JsonVariant up = doc["uplink"];
+  if (!up.isNull()) {
+    UplinkMode m;
+    if (parseUplinkMode(up["mode"] | "", m)) setUplinkMode(m);
+    uint32_t windowMs = up["window_ms"] | 0UL;
+    if (windowMs) windows.setLengthMs(windowMs);
+  }
+
+  applyDosingCommands(cmd.phUp, cmd.phDown, cmd.ppmA, cmd.ppmB, cmd.lockoutMs, cmd.doseMs);
+}
+
+void uplinkTick() {
+  if (!hal::networkUp()) return;
+
+  uint32_t now = hal::millis();
+
+  // Commands only matter once the device can act on them again
+  static bool wasLockedOut = false;
+  bool locked = isLockedOut();
+  bool lockoutEnded = wasLockedOut && !locked;
+  wasLockedOut = locked;
+  if (lockoutEnded) deadband.force();
+
+  if (windows.due(now) || (lockoutEnded && mode == UPLINK_WINDOW)) {
+    WindowSummary s = windows.close(now, latestFrame);
+    if (mode == UPLINK_WINDOW || policy.state() != BREAKER_CLOSED) queueWindow(s);
+  }
+
+  // What goes out: the latest frame, or the oldest closed windows
+  const SensorFrame frame = latestFrame;  // what gets sent is what the band is measured from
+  bool backlog = pendingCount > 0;
+  bool due = true;
+  switch (mode) {
+    case UPLINK_RAW:      break;
+    case UPLINK_DEADBAND: due = backlog || deadband.due(frame, now); break;
+    case UPLINK_WINDOW:   due = backlog; break;
+  }
+  if (!due) {
+    // Window mode has nothing to send between windows; that isn't suppression
+    if (mode == UPLINK_DEADBAND) metrics.uplinksSuppressed++;
+    warmUp(now);
+    return;
+  }
+  // Not yet by the pace (server's or our own), backing off, or the breaker
+  // is open: don't spend a connect on it. The push channel keeps its own
+  // reconnect backoff.
+  if (!pacer.due(now, dosingActive()) || (!pushUp() && !policy.mayAttempt(now))) {
+    metrics.uplinksDeferred++;
+    warmUp(now);
+    return;
+  }
+  logHeaderCycle();
+  // One frame per message on the push channel and the gateway (which
+  // re-ages each body it queues); HTTPS takes a batch of windows
+  int maxBatch = pushUp() || gatewayEnabled() ? 1 : pacer.batch(UPLINK_BATCH_MAX);
+
+  // Snapshot before encoding so the JSON work shows up in the next report
+  static uint32_t allocsAtLastUplink = 0;
+  DeviceHealth health;
+  health.mem = memSnapshot();
+  uint32_t allocs = memTotalAllocs();
+  health.allocs = allocs - allocsAtLastUplink;
+  allocsAtLastUplink = allocs;
+
+  arena.reset();
+  uint8_t* payload = (uint8_t*)arena.alloc(UPLINK_PAYLOAD_BYTES, 1);
+  char* resp = (char*)arena.alloc(UPLINK_RESP_BYTES, 1);
+  size_t len = 0;
+  int windowCount = 0;
+  if (payload && resp) {
+    TRACE_SCOPE(TRACE_ENCODE);
+    MEM_REGION(MEM_JSON);
+    len = backlog
+              ? encodeWindows(health, payload, UPLINK_PAYLOAD_BYTES, maxBatch, windowCount)
+              : encodeFrame(frame, nullptr, &health, frameId(nextSeq++), payload, UPLINK_PAYLOAD_BYTES);
+  }
+  if (!len) {
+    LOGE("[HTTP] Frame doesn't fit the uplink arena (%u bytes)\n", (unsigned)arena.capacity());
+    return;
+  }
+  pacer.attempted(now);
+  if (UPLINK_CBOR) LOGD("[HTTP] Outgoing CBOR: %u bytes\n", (unsigned)len);
+  else LOGD("[HTTP] Outgoing JSON: %s\n", (const char*)payload);
+
+  // Push channel up: telemetry is a publish, commands come back on their own
+  if (pushUp()) {
+    metrics.uplinks++;
+    if (pushTelemetry(payload, len, UPLINK_CBOR)) delivered(windowCount, frame);
+    else metrics.httpTransportErrors++;
+    return;
+  }
+
+  // LAN gateway: one confirmable CoAP exchange, same status numbers as HTTP
+  bool coap = gatewayEnabled();
+  hal::HttpTiming timing;
+  int code = coap ? gatewayPost(payload, len, UPLINK_CBOR, resp, UPLINK_RESP_BYTES, &timing)
+                  : serverPost(payload, len, resp, timing);
+  metrics.uplinks++;
+  if (timing.connectUs) metrics.connectUs.record(timing.connectUs);
+  metrics.postUs.record(timing.totalUs);
+  const char* error = coap ? gatewayErrorString(code) : hal::httpErrorString(code);
+  if (code == hal::HTTP_ERR_BEGIN) {
+    metrics.httpTransportErrors++;
+    LOGW("[HTTP] %s\n", error);
+    return;
+  }
+  recordOutcome(code, hal::millis(), timing.totalUs / 1000);
+
+  LOGD("[HTTP] %s code: %d\n", coap ? "CoAP" : "POST", code);
+  LOGD("[HTTP] Server response:\n%s\n", resp);
+
+  if(code<=0){
+    metrics.httpTransportErrors++;
+    LOGW("[HTTP] Request failed: %s\n", error);
+    return;
+  }
+  if(code>=400){
+    metrics.httpStatusErrors++;
+    // Refused for good (a 4xx other than 429): the same body would be refused
+    // again on every tick, and hold up the backlog behind it
+    if (!UplinkPolicy::serverFailure(code)) {
+      metrics.uplinkFramesRejected += windowCount ? windowCount : 1;
+      LOGW("[HTTP] server refused the upload (%d): dropping %d frame(s)\n", code, windowCount ? windowCount : 1);
+      delivered(windowCount, frame);
+    }
+  } else delivered(windowCount, frame);
+
+  // The gateway ACKs with an empty payload until it has a server reply
+  if (coap && !resp[0]) return;
+  // An error reply may still pace us, but its commands aren't meant for the pumps
+  applyReply(resp, strlen(resp), true, code < 400);
+}
+
+void uplinkApplyCommands(const char* json, size_t len) {
+  arena.reset();  // between uplink cycles: nothing in the arena is live
+  applyReply(json, len, false);
+}
@@ -0,0 +1,95 @@
+#include "websocket.h"
+#include <string.h>
+
+// -------- Handshake --------
+// SHA-1 is only used for the accept key, once per connection
+static uint32_t rol(uint32_t v, int n) { return v << n | v >> (32 - n); }
+
+static void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+  uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+  uint64_t bits = (uint64_t)len * 8;
+  size_t total = (len + 8) / 64 * 64 + 64;  // message + 0x80 + length, padded
+  for (size_t off = 0; off < total; off += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 64; i++) {
+      size_t at = off + i;
+      uint8_t b = at < len ? data[at] : at == len ? 0x80 : 0;
+      if (at >= total - 8) b = bits >> (8 * (total - 1 - at));
+      if (i % 4 == 0) w[i / 4] = 0;
+      w[i / 4] |= (uint32_t)b << (24 - 8 * (i % 4));
+    }
+    for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+      else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+      else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+      else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d; d = c; c = rol(b, 30); b = a; a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+  for (int i = 0; i < 20; i++) out[i] = h[i / 4] >> (24 - 8 * (i % 4));
+}
+
+void wsAcceptKey(const char* clientKey, char out[29]) {
+  static const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  uint8_t buf[64 + sizeof(GUID)];
+  size_t n = strlen(clientKey);
+  if (n > 64) n = 64;  // real keys are 24 chars
+  memcpy(buf, clientKey, n);
+  memcpy(buf + n, GUID, sizeof(GUID) - 1);
+  uint8_t digest[20];
+  sha1(buf, n + sizeof(GUID) - 1, digest);
+
+  static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  char* o = out;
+  for (int i = 0; i < 21; i += 3) {
+    uint32_t v = digest[i] << 16 | (i + 1 < 20 ? digest[i + 1] << 8 : 0) | (i + 2 < 20 ? digest[i + 2] : 0);
+    *o++ = B64[v >> 18 & 63];
+    *o++ = B64[v >> 12 & 63];
+    *o++ = i + 1 < 20 ? B64[v >> 6 & 63] : '=';
+    *o++ = i + 2 < 20 ? B64[v & 63] : '=';
+  }
+  *o = '\0';
+}
+
+// -------- Frames --------
+size_t wsFrame(uint8_t* out, size_t cap, uint8_t opcode, const void* payload, size_t len) {
+  size_t head = len < 126 ? 2 : len <= 0xFFFF ? 4 : 10;
+  if (head + len > cap) return 0;
+  out[0] = 0x80 | opcode;  // FIN
+  if (head == 2) out[1] = len;
+  else if (head == 4) { out[1] = 126; out[2] = len >> 8; out[3] = len; }
+  else {
+    out[1] = 127;
+    for (int i = 0; i < 8; i++) out[2 + i] = (uint64_t)len >> (56 - 8 * i);
+  }
+  memcpy(out + head, payload, len);
+  return head + len;
+}
+
+int wsParse(uint8_t* buf, size_t have, size_t cap, uint8_t& opcode, uint8_t*& payload, size_t& len) {
+  if (have < 2) return 0;
+  if (!(buf[1] & 0x80)) return -1;  // clients must mask
+  opcode = buf[0] & 0x0F;
+  size_t head = 2;
+  len = buf[1] & 0x7F;
+  if (len == 126) {
+    if (have < 4) return 0;
+    len = buf[2] << 8 | buf[3];
+    head = 4;
+  } else if (len == 127) {
+    return -1;  // nothing we accept is that large
+  }
+  if (head + 4 + len > cap) return -1;
+  if (head + 4 + len > have) return 0;
+
+  const uint8_t* mask = buf + head;
+  payload = buf + head + 4;
+  for (size_t i = 0; i < len; i++) payload[i] ^= mask[i % 4];
+  return (int)(head + 4 + len);
+}
@@ -0,0 +1,277 @@
+// ===================================================
+// Stand-in LAN gateway: CoAP from the boxes, batched HTTP to the server
+// ===================================================
+// g++ -O2 -std=gnu++17 -Iinclude tools/coap_gateway.cpp src/coap.cpp -o coap_gateway
+// ./coap_gateway [coap_port] [server host:port] [flush_ms] [max_batch]   (5683 127.0.0.1:3000 5000 32)
+//
+// Devices with the gateway transport on (console "gateway on"; a native
+// build needs PLANTERBOX_GATEWAY_HOST=127.0.0.1) send each frame as a
+// confirmable POST /t?d=<device>. The gateway:
+//   - ACKs at once, piggybacking the device's latest server reply (empty
+//     until the first batch has gone through)
+//   - answers retransmissions from its exchange cache instead of queueing
+//     the frame twice
+//   - per device and body format, POSTs the queued frames as one array to
+//     /api/sensordata?deviceId=<device> every flush_ms (or at max_batch),
+//     adding the time each frame spent queued to its age_ms so the server
+//     stamps it when it was taken
+// A real deployment would run the HTTPS leg; this one speaks plain HTTP
+// to a dev server.
+
+#include "coap.h"
+#include "cbor.h"
+#include "uplink.h"
+#include "http_forward.h"
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+static const uint64_t EXCHANGE_LIFETIME_MS = 247000;  // RFC 7252 4.8.2
+
+struct Queued {
+  std::vector<uint8_t> body;
+  uint64_t receivedMs;
+};
+
+struct Device {
+  std::string commands;          // latest server reply, piggybacked on ACKs
+  std::vector<Queued> batch[2];  // [0] JSON, [1] CBOR
+};
+
+struct Exchange {
+  std::vector<uint8_t> ack;
+  uint64_t atMs;
+};
+
+static std::map<std::string, Device> devices;
+static std::map<std::string, Exchange> exchanges;  // "addr:port/mid" -> ACK sent
+static std::string serverHost = "127.0.0.1", serverPort = "3000";
+static uint64_t flushMs = 5000;
+static size_t maxBatch = 32;
+static uint32_t frames = 0, duplicates = 0, batches = 0;
+
+static uint64_t nowMs() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// -------- age_ms rewriting --------
+// One CBOR item appended to `out` through a scratch writer
+template <typename Fn>
+static void append(std::vector<uint8_t>& out, Fn fn) {
+  uint8_t b[9];
+  CborWriter w(b, sizeof(b));
+  fn(w);
+  out.insert(out.end(), b, b + w.size());
+}
+
+// CBOR: copy the map through, adding `heldMs` to FK_AGE_MS (or appending it)
+static std::vector<uint8_t> ageCbor(const std::vector<uint8_t>& in, uint64_t heldMs) {
+  CborReader r(in.data(), in.size());
+  size_t n;
+  if (!r.map(n)) return in;
+  std::vector<uint8_t> entries;
+  bool hasAge = false;
+  for (size_t i = 0; i < n; i++) {
+    int64_t key, age;
+    if (!r.integer(key)) return in;
+    append(entries, [&](CborWriter& w) { w.integer(key); });
+    if (key == FK_AGE_MS && r.integer(age)) {
+      append(entries, [&](CborWriter& w) { w.integer(age + heldMs); });
+      hasAge = true;
+      continue;
+    }
+    const uint8_t* start = r.position();
+    if (!r.skip()) return in;
+    entries.insert(entries.end(), start, r.position());
+  }
+  if (!hasAge) {
+    append(entries, [&](CborWriter& w) { w.integer(FK_AGE_MS); });
+    append(entries, [&](CborWriter& w) { w.integer(heldMs); });
+  }
+
+  std::vector<uint8_t> out;
+  append(out, [&](CborWriter& w) { w.map(n + !hasAge); });
+  out.insert(out.end(), entries.begin(), entries.end());
+  return out;
+}
+
+// JSON: the device's objects are flat apart from mem/min/max/count, whose
+// keys never include age_ms, so a textual edit is enough
+static std::vector<uint8_t> ageJson(const std::vector<uint8_t>& in, uint64_t heldMs) {
+  std::string s(in.begin(), in.end());
+  size_t at = s.find("\"age_ms\":");
+  if (at != std::string::npos) {
+    size_t v = at + 9, end = v;
+    while (end < s.size() && isdigit((unsigned char)s[end])) end++;
+    uint64_t age = strtoull(s.c_str() + v, nullptr, 10);
+    s.replace(v, end - v, std::to_string(age + heldMs));
+  } else if (!s.empty() && s[0] == '{') {
+    s.insert(1, "\"age_ms\":" + std::to_string(heldMs) + (s.size() > 2 ? "," : ""));
+  }
+  return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+// -------- Upstream --------
+static void flush(const std::string& id, Device& d, int format, uint64_t now) {
+  std::vector<Queued>& q = d.batch[format];
+  bool cbor = format == 1;
+  std::vector<uint8_t> body;
+  if (cbor) append(body, [&](CborWriter& w) { w.array(q.size()); });
+  else body.push_back('[');
+  for (size_t i = 0; i < q.size(); i++) {
+    uint64_t held = now - q[i].receivedMs;
+    std::vector<uint8_t> f = cbor ? ageCbor(q[i].body, held) : ageJson(q[i].body, held);
+    if (!cbor && i) body.push_back(',');
+    body.insert(body.end(), f.begin(), f.end());
+  }
+  if (!cbor) body.push_back(']');
+
+  std::string reply;
+  int code = httpForward(serverHost, serverPort, "/api/sensordata?deviceId=" + id,
+                         cbor ? "application/cbor" : "application/json", body.data(), body.size(), reply);
+  batches++;
+  printf("[GATEWAY] %s: %zu %s frames (%zu bytes) -> server %d\n", id.c_str(), q.size(),
+         cbor ? "CBOR" : "JSON", body.size(), code);
+  // On failure the frames stay queued for the next round (bounded below)
+  if (code >= 200 && code < 300) {
+    q.clear();
+    if (!reply.empty()) d.commands = reply;
+  } else if (q.size() > 4 * maxBatch) {
+    q.erase(q.begin(), q.begin() + (q.size() - 4 * maxBatch));
+  }
+}
+
+static void flushDue(uint64_t now) {
+  for (auto& it : devices) {
+    for (int f = 0; f < 2; f++) {
+      const std::vector<Queued>& q = it.second.batch[f];
+      if (!q.empty() && (q.size() >= maxBatch || now - q.front().receivedMs >= flushMs)) {
+        flush(it.first, it.second, f, now);
+      }
+    }
+  }
+}
+
+// -------- CoAP --------
+static void reply(int fd, const sockaddr_in& peer, const CoapMessage& req, uint8_t code,
+                  const std::string& payload, std::vector<uint8_t>* keep) {
+  CoapMessage ack;
+  ack.type = req.type == COAP_CON ? COAP_ACK : COAP_NON;
+  ack.code = code;
+  ack.messageId = req.messageId;
+  memcpy(ack.token, req.token, req.tokenLen);
+  ack.tokenLen = req.tokenLen;
+  if (!payload.empty()) {
+    ack.contentFormat = COAP_FORMAT_JSON;
+    ack.payload = (const uint8_t*)payload.data();
+    ack.payloadLen = payload.size();
+  }
+  std::vector<uint8_t> out(payload.size() + 32);
+  size_t n = coapEncode(ack, out.data(), out.size());
+  sendto(fd, out.data(), n, 0, (const sockaddr*)&peer, sizeof(peer));
+  if (keep) keep->assign(out.begin(), out.begin() + n);
+}
+
+static void onDatagram(int fd, const sockaddr_in& peer, const uint8_t* data, size_t len, uint64_t now) {
+  CoapMessage m;
+  if (!coapDecode(data, len, m) || m.type == COAP_ACK || m.type == COAP_RST) return;
+  if (m.code == COAP_EMPTY) {  // CoAP ping
+    CoapMessage rst;
+    rst.type = COAP_RST;
+    rst.messageId = m.messageId;
+    uint8_t out[4];
+    sendto(fd, out, coapEncode(rst, out, sizeof(out)), 0, (const sockaddr*)&peer, sizeof(peer));
+    return;
+  }
+
+  char key[48];
+  snprintf(key, sizeof(key), "%s:%u/%u", inet_ntoa(peer.sin_addr), ntohs(peer.sin_port), m.messageId);
+  auto seen = exchanges.find(key);
+  if (seen != exchanges.end()) {
+    duplicates++;
+    const std::vector<uint8_t>& ack = seen->second.ack;  // empty for NON
+    if (!ack.empty()) sendto(fd, ack.data(), ack.size(), 0, (const sockaddr*)&peer, sizeof(peer));
+    return;
+  }
+  Exchange& ex = exchanges[key];
+  ex.atMs = now;
+  std::vector<uint8_t>* keep = m.type == COAP_CON ? &ex.ack : nullptr;
+
+  std::string path(m.uriPath ? m.uriPath : "", m.uriPathLen);
+  std::string query(m.uriQuery ? m.uriQuery : "", m.uriQueryLen);
+  if (m.code != COAP_POST || path != "t") { reply(fd, peer, m, COAP_NOT_FOUND, "", keep); return; }
+  if (query.compare(0, 2, "d=") || query.size() == 2 || !m.payloadLen ||
+      (m.contentFormat != COAP_FORMAT_CBOR && m.contentFormat != COAP_FORMAT_JSON)) {
+    reply(fd, peer, m, COAP_BAD_REQUEST, "", keep);
+    return;
+  }
+
+  std::string id = query.substr(2);
+  Device& d = devices[id];
+  d.batch[m.contentFormat == COAP_FORMAT_CBOR].push_back({ std::vector<uint8_t>(m.payload, m.payload + m.payloadLen), now });
+  frames++;
+  reply(fd, peer, m, COAP_CHANGED, d.commands, keep);
+}
+
+int main(int argc, char** argv) {
+  uint16_t port = argc > 1 ? (uint16_t)atoi(argv[1]) : 5683;
+  if (argc > 2) {
+    std::string hp = argv[2];
+    size_t colon = hp.rfind(':');
+    serverHost = hp.substr(0, colon);
+    if (colon != std::string::npos) serverPort = hp.substr(colon + 1);
+  }
+  if (argc > 3) flushMs = strtoull(argv[3], nullptr, 10);
+  if (argc > 4) maxBatch = strtoul(argv[4], nullptr, 10);
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "cannot bind udp :%u: %s\n", port, strerror(errno));
+    return 1;
+  }
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  printf("[GATEWAY] CoAP on udp :%u, server %s:%s, flush %llu ms / %zu frames\n", port,
+         serverHost.c_str(), serverPort.c_str(), (unsigned long long)flushMs, maxBatch);
+
+  uint64_t lastReport = nowMs();
+  for (;;) {
+    pollfd p = { fd, POLLIN, 0 };
+    poll(&p, 1, 100);
+    uint64_t now = nowMs();
+    while (p.revents & POLLIN) {
+      uint8_t buf[2048];
+      sockaddr_in peer;
+      socklen_t plen = sizeof(peer);
+      ssize_t n = recvfrom(fd, buf, sizeof(buf), MSG_DONTWAIT, (sockaddr*)&peer, &plen);
+      if (n <= 0) break;
+      onDatagram(fd, peer, buf, n, now);
+    }
+
+    flushDue(now);
+    for (auto it = exchanges.begin(); it != exchanges.end();) {
+      if (now - it->second.atMs > EXCHANGE_LIFETIME_MS) it = exchanges.erase(it);
+      else ++it;
+    }
+    if (now - lastReport >= 60000) {
+      lastReport = now;
+      printf("[GATEWAY] %u frames, %u duplicates, %u batches, %zu devices\n",
+             frames, duplicates, batches, devices.size());
+    }
+  }
+}
@@ -0,0 +1,375 @@
+// ===================================================
+// Device emulator: thousands of virtual boxes against the ingest endpoint
+// ===================================================
+// Built from the native firmware sources, so every upload is what a real
+// box sends (the firmware's frame encoder, wire format and FIRMWARE_VERSION):
+//   pio run -e emulator
+//   .pio/build/emulator/program --seed [devices] | mongosh "$MONGODB_URI"
+//   .pio/build/emulator/program [host:port] [devices] [seconds] [interval_ms] [concurrency] [noisy_pct]
+//                               (127.0.0.1:3000 1000 60 5000 256 0)
+//
+// The server only stores uploads from paired devices, so seed first: --seed
+// prints a mongosh script that pairs the emulated IDs with a user
+// "planterbox-emulator" and gives it a selection and profile, so every
+// upload takes the real path (insert, then processSensorData). Undo it with
+// deleteMany({ userId: "planterbox-emulator" }) on app_state and
+// plant_profiles, and on sensordata for the device IDs.
+//
+// Each virtual device has its own ID (planterbox-e0 + index in hex) and a
+// random-walking reservoir, and POSTs one frame per interval_ms, the first
+// at a random offset. Each upload opens its own connection (the firmware
+// keeps one alive between uploads, so this is the server's worst case). At
+// most `concurrency` uploads are in flight; a device whose turn comes while
+// its previous upload is still out skips it (counted as late). The first
+// noisy_pct percent of devices upload ten times as often.
+//
+// Every 5 s: throughput and latency. At the end:
+//   - latency percentiles for quiet and noisy devices separately: a noisy
+//     neighbour shouldn't move the quiet devices' tail
+//   - fairness: the spread of successful uploads per quiet device
+//   - isolation: each frame carries the device index as its distance, and
+//     GET /api/sensordata?deviceId= for a sample of devices must return
+//     that device's own value. Anything else fails the run (exit 1): another
+//     device's value, or nothing stored (the devices weren't seeded)
+// Against a dev server (npm run dev); it speaks plain HTTP.
+
+#include "uplink.h"
+#include "config.h"
+#include <ArduinoJson.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+static const uint64_t REQUEST_TIMEOUT_MS = 10000;
+static const uint64_t REPORT_MS = 5000;
+static const int VERIFY_SAMPLE = 200;
+
+static uint64_t nowMs() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t nowUs() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static sockaddr_in server;
+static char hostHeader[80];
+
+struct VirtualDevice {
+  char id[32];
+  uint32_t session = 0, seq = 0;
+  int index = 0;
+  bool noisy = false;
+  uint64_t intervalMs = 0, nextMs = 0;
+  SensorFrame frame;
+  // in flight
+  int fd = -1;
+  uint64_t startUs = 0;
+  std::string out, reply;
+  size_t sentBytes = 0;
+  // totals
+  uint32_t ok = 0, failed = 0, late = 0;
+};
+
+struct Stats {
+  std::vector<uint32_t> quietUs, noisyUs;
+  uint32_t ok = 0, httpErrors = 0, transportErrors = 0, late = 0;
+};
+
+// -------- Frames --------
+static std::mt19937 rng(12345);
+
+static float walk(float v, float step, float lo, float hi) {
+  std::uniform_real_distribution<float> d(-step, step);
+  return std::min(hi, std::max(lo, v + d(rng)));
+}
+
+static void nextFrame(VirtualDevice& d) {
+  SensorFrame& f = d.frame;
+  f.temperature = walk(f.temperature, 0.2f, 15, 32);
+  f.humidity = walk(f.humidity, 0.5f, 30, 90);
+  f.ppm = walk(f.ppm, 5, 400, 1400);
+  f.ph = walk(f.ph, 0.02f, 5, 7.5f);
+  f.distance = d.index;  // fingerprint for the isolation check
+  f.waterSufficient = true;
+}
+
+static std::string request(VirtualDevice& d) {
+  nextFrame(d);
+  DeviceHealth health;
+  health.mem.heap.freeBytes = 180000 + d.index % 1000;
+  health.mem.heap.largestFreeBlock = 110000;
+  health.mem.heap.minFreeBytes = 170000;
+  health.allocs = 0;
+  FrameId id = { d.id, d.session, ++d.seq };
+  uint8_t body[UPLINK_PAYLOAD_BYTES];
+  size_t len = UPLINK_CBOR ? encodeFrameCbor(d.frame, nullptr, &health, id, body, sizeof(body))
+                           : encodeFrameJson(d.frame, nullptr, &health, id, (char*)body, sizeof(body));
+  char head[256];
+  int n = snprintf(head, sizeof(head),
+                   "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: %s\r\nContent-Length: %u\r\n"
+                   "Connection: close\r\n\r\n",
+                   API_PATH, hostHeader, UPLINK_CBOR ? "application/cbor" : "application/json", (unsigned)len);
+  return std::string(head, n) + std::string((const char*)body, len);
+}
+
+// -------- Connections --------
+static int openConnection() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  if (connect(fd, (sockaddr*)&server, sizeof(server)) != 0 && errno != EINPROGRESS) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int statusOf(const std::string& reply) {
+  if (reply.compare(0, 5, "HTTP/")) return 0;
+  size_t sp = reply.find(' ');
+  return sp == std::string::npos ? 0 : atoi(reply.c_str() + sp + 1);
+}
+
+static void finish(VirtualDevice& d, Stats& st, int& active) {
+  close(d.fd);
+  d.fd = -1;
+  active--;
+  uint32_t us = nowUs() - d.startUs;
+  int code = statusOf(d.reply);
+  if (code >= 200 && code < 300) {
+    d.ok++;
+    st.ok++;
+    (d.noisy ? st.noisyUs : st.quietUs).push_back(us);
+  } else {
+    d.failed++;
+    if (code) st.httpErrors++;
+    else st.transportErrors++;
+  }
+}
+
+// Advance one in-flight upload; false once it's done
+static bool service(VirtualDevice& d, short ev, Stats& st, int& active) {
+  if (nowUs() - d.startUs > REQUEST_TIMEOUT_MS * 1000) { d.reply.clear(); finish(d, st, active); return false; }
+  if (d.sentBytes < d.out.size()) {
+    if (!(ev & (POLLOUT | POLLERR | POLLHUP))) return true;
+    ssize_t n = send(d.fd, d.out.data() + d.sentBytes, d.out.size() - d.sentBytes, MSG_NOSIGNAL);
+    if (n < 0 && errno != EAGAIN) { d.reply.clear(); finish(d, st, active); return false; }
+    if (n > 0) d.sentBytes += n;
+    return true;
+  }
+  if (!(ev & (POLLIN | POLLERR | POLLHUP))) return true;
+  char buf[2048];
+  ssize_t n = recv(d.fd, buf, sizeof(buf), 0);
+  if (n > 0) { d.reply.append(buf, n); return true; }
+  if (n < 0 && errno == EAGAIN) return true;
+  finish(d, st, active);
+  return false;
+}
+
+static double pct(std::vector<uint32_t>& v, double p) {
+  if (v.empty()) return 0;
+  size_t i = std::min(v.size() - 1, (size_t)(p * v.size()));
+  std::nth_element(v.begin(), v.begin() + i, v.end());
+  return v[i] / 1000.0;
+}
+
+static void printLatency(const char* label, std::vector<uint32_t>& v) {
+  fprintf(stderr, "  %-6s %7zu ok  p50 %7.1f  p90 %7.1f  p99 %7.1f  max %7.1f ms\n", label, v.size(), pct(v, 0.5),
+          pct(v, 0.9), pct(v, 0.99), pct(v, 1.0));
+}
+
+// -------- Isolation check --------
+// Blocking GET, after the load has stopped. HTTP/1.0 so the body isn't chunked.
+static std::string get(const std::string& path) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  timeval tv = { 10, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  std::string reply;
+  if (connect(fd, (sockaddr*)&server, sizeof(server)) == 0) {
+    std::string req = "GET " + path + " HTTP/1.0\r\nHost: " + hostHeader + "\r\n\r\n";
+    send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) reply.append(buf, n);
+  }
+  close(fd);
+  size_t body = reply.find("\r\n\r\n");
+  return body == std::string::npos ? "" : reply.substr(body + 4);
+}
+
+// -------- Seed --------
+// mongosh script pairing devices 0..count-1 with the emulator's user
+static void printSeed(int count) {
+  printf("const pb = db.getSiblingDB(\"planterbox\");\n"
+         "const user = \"planterbox-emulator\";\n"
+         "const now = new Date().toISOString();\n"
+         "pb.plant_profiles.updateOne({ userId: user, plant_name: \"emulator\", stage: \"seedling\" },\n"
+         "  { $set: { ideal_conditions: { temp_min: 18, temp_max: 28, humidity_min: 40, humidity_max: 80,\n"
+         "    ph_min: 5.5, ph_max: 6.8, ppm_min: 700, ppm_max: 1200, light_pwm_cycle: 16 } } },\n"
+         "  { upsert: true });\n"
+         "pb.app_state.updateOne({ state_name: \"plantSelection\", userId: user },\n"
+         "  { $set: { value: { plant: \"emulator\", stage: \"seedling\", timestamp: now } } }, { upsert: true });\n"
+         "const ids = Array.from({ length: %d }, (_, i) => \"planterbox-e0\" + i.toString(16).padStart(10, \"0\"));\n"
+         "pb.app_state.bulkWrite(ids.map((deviceId) => ({ updateOne: {\n"
+         "  filter: { state_name: \"deviceOwner\", deviceId },\n"
+         "  update: { $set: { userId: user, boundAt: now }, $unset: { auto: \"\" } }, upsert: true } })));\n"
+         "print(`paired ${ids.length} devices with ${user}`);\n",
+         count);
+}
+
+static bool verify(std::vector<VirtualDevice>& devices) {
+  int own = 0, unstored = 0, foreign = 0, unreadable = 0;
+  int step = std::max<int>(1, devices.size() / VERIFY_SAMPLE);
+  for (size_t i = 0; i < devices.size(); i += step) {
+    std::string body = get(std::string(API_PATH) + "?deviceId=" + devices[i].id);
+    JsonDocument doc;
+    if (deserializeJson(doc, body.c_str())) { unreadable++; continue; }
+    JsonVariant s = doc["sensorData"];
+    if (s.isNull()) unstored++;
+    else if (s["distance"].as<int>() == devices[i].index) own++;
+    else {
+      foreign++;
+      fprintf(stderr, "[EMU] %s reads back device %d's frame\n", devices[i].id, s["distance"].as<int>());
+    }
+  }
+  fprintf(stderr, "[EMU] isolation: %d own, %d not stored, %d foreign, %d unreadable\n", own, unstored, foreign,
+          unreadable);
+  if (unstored) fprintf(stderr, "[EMU] devices without stored frames: not paired? run --seed first\n");
+  return !unstored && !foreign && !unreadable;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && !strcmp(argv[1], "--seed")) {
+    int count = argc > 2 ? atoi(argv[2]) : 1000;
+    if (count < 1) return 2;
+    printSeed(count);
+    return 0;
+  }
+  std::string target = argc > 1 ? argv[1] : "127.0.0.1:3000";
+  int count = argc > 2 ? atoi(argv[2]) : 1000;
+  uint64_t seconds = argc > 3 ? strtoull(argv[3], nullptr, 10) : 60;
+  uint64_t intervalMs = argc > 4 ? strtoull(argv[4], nullptr, 10) : 5000;
+  int concurrency = argc > 5 ? atoi(argv[5]) : 256;
+  int noisyPct = argc > 6 ? atoi(argv[6]) : 0;
+  if (count < 1 || concurrency < 1 || intervalMs < 10) return 2;
+
+  size_t colon = target.rfind(':');
+  std::string host = target.substr(0, colon);
+  std::string port = colon == std::string::npos ? "3000" : target.substr(colon + 1);
+  addrinfo hints = {}, *res = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) {
+    fprintf(stderr, "[EMU] can't resolve %s\n", host.c_str());
+    return 1;
+  }
+  memcpy(&server, res->ai_addr, sizeof(server));
+  freeaddrinfo(res);
+  snprintf(hostHeader, sizeof(hostHeader), "%s", target.c_str());
+
+  std::vector<VirtualDevice> devices(count);
+  uint64_t t0 = nowMs();
+  std::uniform_int_distribution<uint64_t> offset(0, intervalMs - 1);
+  for (int i = 0; i < count; i++) {
+    VirtualDevice& d = devices[i];
+    snprintf(d.id, sizeof(d.id), "planterbox-e0%010x", i);
+    d.index = i;
+    d.session = rng() | 1;
+    d.noisy = i < count * noisyPct / 100;
+    d.intervalMs = d.noisy ? std::max<uint64_t>(intervalMs / 10, 1) : intervalMs;
+    d.nextMs = t0 + offset(rng) % d.intervalMs;
+    d.frame.temperature = 24;
+    d.frame.humidity = 60;
+    d.frame.ppm = 900;
+    d.frame.ph = 6.2f;
+  }
+  fprintf(stderr, "[EMU] %d devices (%d noisy) -> %s%s, every %llu ms, %d in flight, fw %s, %s\n", count,
+          count * noisyPct / 100, target.c_str(), API_PATH, (unsigned long long)intervalMs, concurrency,
+          FIRMWARE_VERSION, UPLINK_CBOR ? "CBOR" : "JSON");
+
+  Stats st;
+  Stats at;  // counters at the last report (latency vectors unused)
+  size_t quietSeen = 0, noisySeen = 0;
+  int active = 0;
+  uint64_t end = t0 + seconds * 1000, lastReport = t0;
+  std::vector<VirtualDevice*> live;
+  while (nowMs() < end || active) {
+    uint64_t now = nowMs();
+    if (now < end) {
+      for (auto& d : devices) {
+        if (now < d.nextMs) continue;
+        if (d.fd >= 0) { d.late++; st.late++; d.nextMs += d.intervalMs; continue; }
+        if (active >= concurrency) break;  // the rest wait for a slot
+        d.nextMs += d.intervalMs;
+        d.fd = openConnection();
+        d.startUs = nowUs();
+        d.reply.clear();
+        d.sentBytes = 0;
+        active++;
+        if (d.fd < 0) { finish(d, st, active); continue; }
+        d.out = request(d);
+        live.push_back(&d);
+      }
+    }
+
+    std::vector<pollfd> pfds;
+    for (auto* d : live) pfds.push_back({ d->fd, (short)(d->sentBytes < d->out.size() ? POLLOUT : POLLIN), 0 });
+    poll(pfds.data(), pfds.size(), 5);
+    std::vector<VirtualDevice*> still;
+    for (size_t i = 0; i < live.size(); i++)
+      if (service(*live[i], pfds[i].revents, st, active)) still.push_back(live[i]);
+    live.swap(still);
+
+    now = nowMs();
+    if (now - lastReport >= REPORT_MS) {
+      std::vector<uint32_t> recent(st.quietUs.begin() + quietSeen, st.quietUs.end());
+      recent.insert(recent.end(), st.noisyUs.begin() + noisySeen, st.noisyUs.end());
+      fprintf(stderr, "[EMU] %3llus  %6.0f uploads/s  %4u http err  %4u transport err  %4u late  p50 %6.1f  p99 %7.1f ms\n",
+              (unsigned long long)(now - t0) / 1000, (st.ok - at.ok) * 1000.0 / (now - lastReport),
+              st.httpErrors - at.httpErrors, st.transportErrors - at.transportErrors, st.late - at.late,
+              pct(recent, 0.5), pct(recent, 0.99));
+      quietSeen = st.quietUs.size();
+      noisySeen = st.noisyUs.size();
+      at.ok = st.ok;
+      at.httpErrors = st.httpErrors;
+      at.transportErrors = st.transportErrors;
+      at.late = st.late;
+      lastReport = now;
+    }
+  }
+
+  double secs = (nowMs() - t0) / 1000.0;
+  fprintf(stderr, "[EMU] %u uploads in %.1f s (%.0f/s), %u http errors, %u transport errors, %u late\n", st.ok, secs,
+          st.ok / secs, st.httpErrors, st.transportErrors, st.late);
+  printLatency("quiet", st.quietUs);
+  if (noisyPct) printLatency("noisy", st.noisyUs);
+
+  std::vector<uint32_t> perDevice;
+  int starved = 0;
+  for (const auto& d : devices) {
+    if (d.noisy) continue;
+    perDevice.push_back(d.ok);
+    starved += d.ok == 0;
+  }
+  if (!perDevice.empty()) {
+    std::sort(perDevice.begin(), perDevice.end());
+    fprintf(stderr, "[EMU] uploads per quiet device: min %u  median %u  max %u  (%d with none)\n", perDevice.front(),
+            perDevice[perDevice.size() / 2], perDevice.back(), starved);
+  }
+  return verify(devices) ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+// ===================================================
+// LAN fleet collector: find Planterboxes over mDNS, scrape them in parallel
+// ===================================================
+// g++ -O2 -std=gnu++17 -Iinclude tools/fleet_collector.cpp src/mdns.cpp -o fleet_collector
+// ./fleet_collector [targets] [rounds] [interval_ms] [concurrency]   (mdns 10 1000 64)
+//
+// targets:
+//   mdns               browse _planterbox._tcp (legacy unicast query, 2 s)
+//   host:port[-port]   a fixed range, e.g. 127.0.0.1:18000-18299
+//   spawn:N[:binary]   start N native builds (default ./program) on
+//                      PLANTERBOX_LOCAL_PORT 18000.. with their output
+//                      discarded, then browse for them; stopped on exit
+//
+// Each round GETs /status and /metrics from every device, at most
+// `concurrency` requests in flight, each with a 2 s deadline, and prints
+// latency percentiles and throughput. At the end it compares the requests
+// the fleet says it served (planterbox_local_requests_total) with the ones
+// sent, and lists the slowest devices: a device that falls behind shows up
+// as a long tail here before it shows up as timeouts.
+
+#include "mdns.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+static const char SERVICE[] = "_planterbox._tcp.local";
+static const uint64_t REQUEST_TIMEOUT_MS = 2000;
+static const uint64_t BROWSE_MS = 2000;
+static const uint16_t SPAWN_BASE_PORT = 18000;
+
+static uint64_t nowUs() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+struct Device {
+  sockaddr_in addr;
+  std::string name;  // mDNS instance, or host:port
+  std::string fw;
+  uint64_t served = 0, servedBase = 0;  // planterbox_local_requests_total
+  bool haveBase = false;
+  uint32_t ok = 0, failed = 0;
+  uint64_t maxUs = 0;
+};
+
+// -------- Discovery --------
+static std::vector<Device> browse() {
+  std::vector<Device> found;
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int big = 1 << 20;  // hundreds of answers arrive at once
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &big, sizeof(big));
+  sockaddr_in group = {};
+  group.sin_family = AF_INET;
+  group.sin_port = htons(5353);
+  group.sin_addr.s_addr = inet_addr("224.0.0.251");
+
+  uint8_t q[128];
+  size_t qlen = mdnsQuery(q, sizeof(q), 0x5042, SERVICE);
+  uint64_t start = nowUs() / 1000, nextQuery = start;
+  while (nowUs() / 1000 - start < BROWSE_MS) {
+    uint64_t now = nowUs() / 1000;
+    if (now >= nextQuery) {  // three queries in case one is lost
+      sendto(fd, q, qlen, 0, (sockaddr*)&group, sizeof(group));
+      nextQuery = now + BROWSE_MS / 3;
+    }
+    pollfd p = { fd, POLLIN, 0 };
+    if (poll(&p, 1, 50) <= 0) continue;
+    uint8_t buf[1500];
+    sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+    MdnsService s;
+    if (n <= 0 || !mdnsParseAnswer(buf, n, SERVICE, s)) continue;
+    bool dup = false;
+    for (const auto& d : found) dup |= d.name == s.instance;
+    if (dup) continue;
+
+    Device d = {};
+    d.addr.sin_family = AF_INET;
+    d.addr.sin_port = htons(s.port);
+    d.addr.sin_addr.s_addr = s.ipv4 ? s.ipv4 : from.sin_addr.s_addr;
+    d.name = s.instance;
+    for (int i = 0; i < s.txtCount; i++)
+      if (!strncmp(s.txt[i], "fw=", 3)) d.fw = s.txt[i] + 3;
+    found.push_back(d);
+  }
+  close(fd);
+  return found;
+}
+
+static std::vector<Device> range(const char* spec) {
+  std::vector<Device> out;
+  char host[64];
+  unsigned lo = 0, hi = 0;
+  int n = sscanf(spec, "%63[^:]:%u-%u", host, &lo, &hi);
+  if (n < 2) return out;
+  if (n < 3) hi = lo;
+  for (unsigned port = lo; port <= hi && port <= 65535; port++) {
+    Device d = {};
+    d.addr.sin_family = AF_INET;
+    d.addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &d.addr.sin_addr) != 1) return {};
+    d.name = std::string(host) + ":" + std::to_string(port);
+    out.push_back(d);
+  }
+  return out;
+}
+
+// -------- Spawned fleet --------
+static std::vector<pid_t> children;
+
+static void stopChildren() {
+  for (pid_t pid : children) kill(pid, SIGTERM);
+  for (pid_t pid : children) waitpid(pid, nullptr, 0);
+  children.clear();
+}
+
+static void onSignal(int) {
+  stopChildren();
+  _exit(1);
+}
+
+static void spawn(int count, const char* binary) {
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  for (int i = 0; i < count; i++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      char port[12];
+      snprintf(port, sizeof(port), "%u", SPAWN_BASE_PORT + i);
+      setenv("PLANTERBOX_LOCAL_PORT", port, 1);
+      int null = open("/dev/null", O_RDWR);
+      dup2(null, 0);
+      dup2(null, 1);
+      dup2(null, 2);
+      execl(binary, binary, (char*)nullptr);
+      _exit(127);
+    }
+    if (pid > 0) children.push_back(pid);
+  }
+  fprintf(stderr, "[FLEET] started %zu x %s on :%u..%u\n", children.size(), binary, SPAWN_BASE_PORT,
+          SPAWN_BASE_PORT + count - 1);
+  usleep(1000000);  // let them bind and announce
+}
+
+// -------- Scraping --------
+struct Request {
+  Device* dev;
+  const char* path;
+  int fd = -1;
+  bool sent = false;
+  uint64_t startUs = 0;
+  std::string reply;
+};
+
+// Status line 200 and a body we recognise
+static bool check(Request& r) {
+  if (r.reply.compare(0, 12, "HTTP/1.1 200") && r.reply.compare(0, 12, "HTTP/1.0 200")) return false;
+  size_t body = r.reply.find("\r\n\r\n");
+  if (body == std::string::npos) return false;
+  if (!strcmp(r.path, "/status")) return r.reply.find("\"fw\":\"", body) != std::string::npos;
+
+  // Chunked on the ESP32, so look for the sample line rather than parse
+  size_t at = r.reply.find("\nplanterbox_local_requests_total ", body);
+  if (at == std::string::npos) return false;
+  uint64_t served = strtoull(r.reply.c_str() + at + 33, nullptr, 10);
+  Device& d = *r.dev;
+  if (!d.haveBase) { d.servedBase = served; d.haveBase = true; }
+  d.served = served;
+  return true;
+}
+
+static bool start(Request& r) {
+  r.fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (r.fd < 0) return false;
+  fcntl(r.fd, F_SETFL, O_NONBLOCK);
+  r.startUs = nowUs();
+  if (connect(r.fd, (sockaddr*)&r.dev->addr, sizeof(r.dev->addr)) != 0 && errno != EINPROGRESS) {
+    close(r.fd);
+    r.fd = -1;
+    return false;
+  }
+  return true;
+}
+
+// One round: every request to completion or deadline; latencies in `lat`
+static void scrapeRound(std::vector<Request>& reqs, size_t concurrency, std::vector<uint64_t>& lat, uint32_t& failed) {
+  size_t next = 0, active = 0;
+  std::vector<Request*> live;
+  auto finish = [&](Request* r, bool ok) {
+    if (r->fd >= 0) close(r->fd);
+    r->fd = -1;
+    active--;
+    uint64_t us = nowUs() - r->startUs;
+    if (ok && check(*r)) {
+      lat.push_back(us);
+      r->dev->ok++;
+      r->dev->maxUs = std::max(r->dev->maxUs, us);
+    } else {
+      failed++;
+      r->dev->failed++;
+    }
+  };
+
+  while (next < reqs.size() || active) {
+    while (active < concurrency && next < reqs.size()) {
+      Request* r = &reqs[next++];
+      active++;
+      if (start(*r)) live.push_back(r);
+      else finish(r, false);
+    }
+    std::vector<pollfd> pfds;
+    for (Request* r : live) pfds.push_back({ r->fd, (short)(r->sent ? POLLIN : POLLOUT), 0 });
+    poll(pfds.data(), pfds.size(), 20);
+
+    uint64_t now = nowUs();
+    std::vector<Request*> still;
+    for (size_t i = 0; i < live.size(); i++) {
+      Request* r = live[i];
+      short ev = pfds[i].revents;
+      if (now - r->startUs > REQUEST_TIMEOUT_MS * 1000) { finish(r, false); continue; }
+      if (!r->sent && ev & (POLLOUT | POLLERR | POLLHUP)) {
+        char req[128];
+        int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: planterbox\r\nConnection: close\r\n\r\n",
+                         r->path);
+        if (send(r->fd, req, n, MSG_NOSIGNAL) != n) { finish(r, false); continue; }
+        r->sent = true;
+      } else if (r->sent && ev & (POLLIN | POLLERR | POLLHUP)) {
+        char buf[4096];
+        ssize_t n = recv(r->fd, buf, sizeof(buf), 0);
+        if (n > 0) r->reply.append(buf, n);
+        else if (n == 0) { finish(r, true); continue; }
+        else if (errno != EAGAIN) { finish(r, false); continue; }
+      }
+      still.push_back(r);
+    }
+    live.swap(still);
+  }
+}
+
+static double pct(std::vector<uint64_t>& v, double p) {
+  if (v.empty()) return 0;
+  size_t i = std::min(v.size() - 1, (size_t)(p * v.size()));
+  std::nth_element(v.begin(), v.begin() + i, v.end());
+  return v[i] / 1000.0;
+}
+
+int main(int argc, char** argv) {
+  const char* targets = argc > 1 ? argv[1] : "mdns";
+  int rounds = argc > 2 ? atoi(argv[2]) : 10;
+  uint64_t intervalMs = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1000;
+  size_t concurrency = argc > 4 ? strtoul(argv[4], nullptr, 10) : 64;
+  if (!concurrency) concurrency = 1;
+
+  std::vector<Device> fleet;
+  int spawned = 0;
+  if (!strncmp(targets, "spawn:", 6)) {
+    spawned = atoi(targets + 6);
+    const char* bin = strchr(targets + 6, ':');
+    spawn(spawned, bin ? bin + 1 : "./program");
+    fleet = browse();
+  } else if (!strcmp(targets, "mdns")) {
+    fleet = browse();
+  } else {
+    fleet = range(targets);
+  }
+  if (spawned) fprintf(stderr, "[FLEET] discovered %zu of %d spawned devices\n", fleet.size(), spawned);
+  else fprintf(stderr, "[FLEET] %zu devices\n", fleet.size());
+  if (fleet.empty()) {
+    stopChildren();
+    return 1;
+  }
+  for (size_t i = 0; i < fleet.size() && i < 3; i++)
+    fprintf(stderr, "[FLEET]   %s %s:%u fw=%s\n", fleet[i].name.c_str(), inet_ntoa(fleet[i].addr.sin_addr),
+            ntohs(fleet[i].addr.sin_port), fleet[i].fw.empty() ? "?" : fleet[i].fw.c_str());
+
+  uint64_t sent = 0;
+  for (int n = 0; n < rounds; n++) {
+    uint64_t t0 = nowUs();
+    std::vector<Request> reqs;
+    for (auto& d : fleet) {
+      Request a, b;
+      a.dev = b.dev = &d;
+      a.path = "/status";
+      b.path = "/metrics";
+      reqs.push_back(a);
+      reqs.push_back(b);
+    }
+    std::vector<uint64_t> lat;
+    uint32_t failed = 0;
+    scrapeRound(reqs, concurrency, lat, failed);
+    sent += reqs.size();
+    double secs = (nowUs() - t0) / 1e6;
+    size_t ok = lat.size();
+    fprintf(stderr, "round %2d: %5zu ok %4u failed  p50 %6.1f  p90 %6.1f  p99 %6.1f  max %6.1f ms  %6.0f req/s\n",
+            n + 1, ok, failed, pct(lat, 0.5), pct(lat, 0.9), pct(lat, 0.99), pct(lat, 1.0),
+            (ok + failed) / secs);
+    uint64_t spent = (nowUs() - t0) / 1000;
+    if (n + 1 < rounds && spent < intervalMs) usleep((intervalMs - spent) * 1000);
+  }
+
+  // The first /metrics of each device set its baseline, so the first
+  // round's /status may or may not be counted: allow one per device
+  uint64_t served = 0;
+  for (const auto& d : fleet) served += d.served - d.servedBase;
+  uint64_t expected = sent - 2 * fleet.size();
+  fprintf(stderr, "[FLEET] fleet served %llu of the %llu requests sent after its baseline (+/- %zu)\n",
+          (unsigned long long)served, (unsigned long long)expected, fleet.size());
+
+  std::vector<Device*> byMax;
+  for (auto& d : fleet) byMax.push_back(&d);
+  std::sort(byMax.begin(), byMax.end(), [](Device* a, Device* b) { return a->maxUs > b->maxUs; });
+  for (size_t i = 0; i < byMax.size() && i < 5; i++)
+    fprintf(stderr, "[FLEET] slowest: %-40s max %6.1f ms  %u ok  %u failed\n", byMax[i]->name.c_str(),
+            byMax[i]->maxUs / 1000.0, byMax[i]->ok, byMax[i]->failed);
+  stopChildren();
+  return 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+// Blocking HTTP/1.1 POST for the host tools (mqtt_bridge, coap_gateway):
+// one connection per request, chunked replies decoded.
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string>
+
+inline bool sendAll(int fd, const void* data, size_t len) {
+  const char* p = (const char*)data;
+  while (len) {
+    ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+// Status code (body in `reply`), -1 on transport errors
+inline int httpForward(const std::string& host, const std::string& port, const std::string& path,
+                       const char* contentType, const void* body, size_t len, std::string& reply) {
+  addrinfo hints = {}, *res = nullptr;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) return -1;
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  timeval tv = { 10, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  bool ok = connect(fd, res->ai_addr, res->ai_addrlen) == 0;
+  freeaddrinfo(res);
+  if (!ok) { close(fd); return -1; }
+
+  char head[512];
+  int hl = snprintf(head, sizeof(head),
+                    "POST %s HTTP/1.1\r\nHost: %s:%s\r\n"
+                    "Content-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                    path.c_str(), host.c_str(), port.c_str(), contentType, len);
+  if (!sendAll(fd, head, hl) || !sendAll(fd, body, len)) { close(fd); return -1; }
+
+  std::string raw;
+  char buf[4096];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) raw.append(buf, n);
+  close(fd);
+
+  int code = 0;
+  if (sscanf(raw.c_str(), "HTTP/%*s %d", &code) != 1) return -1;
+  size_t split = raw.find("\r\n\r\n");
+  if (split == std::string::npos) return code;
+  std::string headers = raw.substr(0, split);
+  reply = raw.substr(split + 4);
+  if (strcasestr(headers.c_str(), "transfer-encoding: chunked")) {
+    std::string out;
+    size_t at = 0;
+    for (;;) {
+      size_t size = strtoul(reply.c_str() + at, nullptr, 16);
+      size_t eol = reply.find("\r\n", at);
+      if (eol == std::string::npos || size == 0) break;
+      out.append(reply, eol + 2, size);
+      at = eol + 2 + size + 2;
+    }
+    reply = out;
+  }
+  return code;
+}
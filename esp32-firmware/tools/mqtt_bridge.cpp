@@ -0,0 +1,234 @@
+// ===================================================
+// Stand-in MQTT broker + bridge to /api/sensordata
+// ===================================================
+// g++ -O2 -std=gnu++17 -Iinclude tools/mqtt_bridge.cpp src/mqtt.cpp -o mqtt_bridge
+// ./mqtt_bridge [mqtt_port] [server host:port] [push_port]     (1883 127.0.0.1:3000 8090)
+//
+// Just enough broker for the push channel (QoS 0, exact-match topics, no
+// retained messages or wills), plus the two bridges the firmware relies on:
+//   planterbox/<id>/telemetry/{cbor,json}  -> POST /api/sensordata?deviceId=<id>
+//                                             reply published to planterbox/<id>/cmd
+//   POST http://<bridge>:<push_port>/push/<id> (JSON body)
+//                                          -> published to planterbox/<id>/cmd
+// The second one is what the server calls (PLANTERBOX_PUSH_URL) when a
+// selection or profile changes. A native build finds the bridge with
+// PLANTERBOX_MQTT_HOST=127.0.0.1 and "push on" on its console.
+
+#include "mqtt.h"
+#include "http_forward.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+static const size_t RX_BYTES = 16384;
+static const int MAX_SUBS = 8;
+
+struct Session {
+  int fd;
+  std::string clientId;
+  std::vector<std::string> subs;
+  std::vector<uint8_t> rx;
+  MqttReader reader;
+  bool connected = false;
+
+  explicit Session(int fd) : fd(fd), rx(RX_BYTES), reader(rx.data(), RX_BYTES) {}
+};
+
+static std::vector<Session*> sessions;
+static std::string serverHost = "127.0.0.1", serverPort = "3000";
+static uint32_t forwarded = 0, pushed = 0;
+
+// -------- Sockets --------
+static int listenOn(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+    fprintf(stderr, "cannot listen on :%u: %s\n", port, strerror(errno));
+    exit(1);
+  }
+  return fd;
+}
+
+static void closeSession(Session* s, const char* why) {
+  printf("[BRIDGE] %s disconnected (%s)\n", s->clientId.empty() ? "?" : s->clientId.c_str(), why);
+  close(s->fd);
+  for (size_t i = 0; i < sessions.size(); i++) {
+    if (sessions[i] == s) { sessions.erase(sessions.begin() + i); break; }
+  }
+  delete s;
+}
+
+// -------- Broker --------
+static int publish(const std::string& topic, const uint8_t* payload, size_t len) {
+  std::vector<uint8_t> pkt(len + topic.size() + 16);
+  size_t n = mqttPublish(pkt.data(), pkt.size(), topic.c_str(), payload, len);
+  int delivered = 0;
+  for (Session* s : sessions) {
+    for (const auto& sub : s->subs) {
+      if (sub == topic && sendAll(s->fd, pkt.data(), n)) { delivered++; break; }
+    }
+  }
+  return delivered;
+}
+
+// planterbox/<id>/telemetry/<fmt>: the device id and body format
+static bool telemetryTopic(const std::string& topic, std::string& id, std::string& fmt) {
+  static const char prefix[] = "planterbox/";
+  if (topic.compare(0, sizeof(prefix) - 1, prefix)) return false;
+  size_t a = sizeof(prefix) - 1, b = topic.find('/', a);
+  if (b == std::string::npos || topic.compare(b, 11, "/telemetry/")) return false;
+  id = topic.substr(a, b - a);
+  fmt = topic.substr(b + 11);
+  return fmt == "cbor" || fmt == "json";
+}
+
+static void onPublish(Session* s, const MqttPacket& p) {
+  const char* t;
+  size_t tl, len;
+  const uint8_t* payload;
+  if (!mqttParsePublish(p, t, tl, payload, len)) return;
+  std::string topic(t, tl), id, fmt;
+
+  if (!telemetryTopic(topic, id, fmt)) { publish(topic, payload, len); return; }
+
+  std::string reply;
+  int code = httpForward(serverHost, serverPort, "/api/sensordata?deviceId=" + id,
+                         fmt == "cbor" ? "application/cbor" : "application/json", payload, len, reply);
+  forwarded++;
+  printf("[BRIDGE] %s: %zu-byte %s frame -> server %d\n", s->clientId.c_str(), len, fmt.c_str(), code);
+  if (code >= 200 && code < 300 && !reply.empty()) {
+    publish("planterbox/" + id + "/cmd", (const uint8_t*)reply.data(), reply.size());
+  }
+}
+
+static bool onPacket(Session* s, const MqttPacket& p) {
+  uint8_t out[64];
+  switch (p.type) {
+    case MQTT_CONNECT: {
+      // protocol name (6) + level + flags + keepalive, then the client id
+      if (p.len < 12) return false;
+      size_t idLen = (size_t)p.body[10] << 8 | p.body[11];
+      s->clientId.assign((const char*)p.body + 12, idLen < p.len - 12 ? idLen : p.len - 12);
+      s->connected = true;
+      printf("[BRIDGE] %s connected\n", s->clientId.c_str());
+      return sendAll(s->fd, out, mqttConnAck(out, sizeof(out), 0));
+    }
+    case MQTT_SUBSCRIBE: {
+      if (p.len < 5) return false;
+      uint16_t id = p.body[0] << 8 | p.body[1];
+      size_t tl = (size_t)p.body[2] << 8 | p.body[3];
+      if (4 + tl > p.len) return false;
+      if ((int)s->subs.size() < MAX_SUBS) s->subs.emplace_back((const char*)p.body + 4, tl);
+      printf("[BRIDGE] %s subscribed to %s\n", s->clientId.c_str(), s->subs.back().c_str());
+      return sendAll(s->fd, out, mqttSubAck(out, sizeof(out), id));
+    }
+    case MQTT_PUBLISH:    onPublish(s, p); return true;
+    case MQTT_PINGREQ:    return sendAll(s->fd, out, mqttPingResp(out, sizeof(out)));
+    case MQTT_DISCONNECT: return false;
+    default:              return true;
+  }
+}
+
+// -------- Push endpoint (HTTP) --------
+static void servePush(int fd) {
+  timeval tv = { 2, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  std::string req;
+  char buf[4096];
+  ssize_t n;
+  size_t split = std::string::npos, want = 0;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    req.append(buf, n);
+    if (split == std::string::npos && (split = req.find("\r\n\r\n")) != std::string::npos) {
+      const char* cl = strcasestr(req.c_str(), "content-length:");
+      want = split + 4 + (cl && cl < req.c_str() + split ? strtoul(cl + 15, nullptr, 10) : 0);
+    }
+    if (split != std::string::npos && req.size() >= want) break;
+  }
+
+  char id[64] = "";
+  int status = 404;
+  std::string reply = "{\"error\":\"POST /push/<deviceId>\"}";
+  if (split != std::string::npos && sscanf(req.c_str(), "POST /push/%63[^ /?]", id) == 1) {
+    std::string body = req.substr(split + 4);
+    int delivered = publish(std::string("planterbox/") + id + "/cmd", (const uint8_t*)body.data(), body.size());
+    pushed++;
+    printf("[BRIDGE] push for %s: %zu bytes to %d subscriber(s)\n", id, body.size(), delivered);
+    status = 200;
+    reply = "{\"delivered\":" + std::to_string(delivered) + "}";
+  }
+  char head[160];
+  int hl = snprintf(head, sizeof(head),
+                    "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n"
+                    "Connection: close\r\n\r\n", status, status == 200 ? "OK" : "Not Found", reply.size());
+  sendAll(fd, head, hl);
+  sendAll(fd, reply.data(), reply.size());
+  close(fd);
+}
+
+int main(int argc, char** argv) {
+  uint16_t mqttPort = argc > 1 ? (uint16_t)atoi(argv[1]) : 1883;
+  if (argc > 2) {
+    std::string hp = argv[2];
+    size_t colon = hp.rfind(':');
+    serverHost = hp.substr(0, colon);
+    if (colon != std::string::npos) serverPort = hp.substr(colon + 1);
+  }
+  uint16_t pushPort = argc > 3 ? (uint16_t)atoi(argv[3]) : 8090;
+
+  int mqttFd = listenOn(mqttPort), pushFd = listenOn(pushPort);
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  printf("[BRIDGE] MQTT on :%u, push on :%u, server %s:%s\n", mqttPort, pushPort,
+         serverHost.c_str(), serverPort.c_str());
+
+  for (;;) {
+    std::vector<pollfd> fds = { { mqttFd, POLLIN, 0 }, { pushFd, POLLIN, 0 } };
+    for (Session* s : sessions) fds.push_back({ s->fd, POLLIN, 0 });
+    if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) { perror("poll"); return 1; }
+
+    if (fds[0].revents & POLLIN) {
+      int fd = accept(mqttFd, nullptr, nullptr);
+      if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        sessions.push_back(new Session(fd));
+      }
+    }
+    if (fds[1].revents & POLLIN) {
+      int fd = accept(pushFd, nullptr, nullptr);
+      if (fd >= 0) servePush(fd);
+    }
+
+    // Sessions may close while handling; walk the poll results by fd
+    for (size_t i = 2; i < fds.size(); i++) {
+      if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+      Session* s = nullptr;
+      for (Session* c : sessions) if (c->fd == fds[i].fd) s = c;
+      if (!s) continue;
+
+      ssize_t n = recv(s->fd, s->reader.writePtr(), s->reader.writeSpace(), 0);
+      if (n <= 0) { closeSession(s, n == 0 ? "closed" : strerror(errno)); continue; }
+      s->reader.commit(n);
+      MqttPacket p;
+      bool ok = true;
+      while (ok && s->reader.next(p)) ok = onPacket(s, p);
+      if (!ok) closeSession(s, "protocol");
+    }
+  }
+}
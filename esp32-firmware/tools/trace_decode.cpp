@@ -0,0 +1,231 @@
+// ===================================================
+// Host decoder for "trace dump" output
+// ===================================================
+// g++ -O2 -std=gnu++17 -Iinclude tools/trace_decode.cpp -o trace_decode
+// pio device monitor | tee serial.log     (then type "trace dump")
+// ./trace_decode serial.log [--timeline N] [--chrome trace.json]
+//
+// Takes the last complete dump in the log (prefixes such as monitor
+// timestamps are fine) and prints:
+//   - per-phase table: count, total, share of the traced window, p50/p90/p99/max
+//   - per-phase log2 histograms
+//   - a timeline of the last N top-level records with nested phases indented
+// --chrome writes Trace Event JSON for chrome://tracing or ui.perfetto.dev.
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Event {
+  int64_t startUs;
+  uint32_t durUs;
+  uint8_t id;
+  int depth;
+};
+
+struct Dump {
+  uint32_t count = 0, dropped = 0, nowUs = 0;
+  std::map<int, std::string> names;
+  std::vector<uint8_t> bytes;
+};
+
+static int b64(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;
+}
+
+static void decodeBase64(const char* s, std::vector<uint8_t>& out) {
+  uint32_t acc = 0;
+  int bits = 0;
+  for (; *s && *s != '='; s++) {
+    int v = b64(*s);
+    if (v < 0) continue;
+    acc = acc << 6 | v;
+    bits += 6;
+    if (bits >= 8) { bits -= 8; out.push_back(acc >> bits & 0xFF); }
+  }
+}
+
+static bool readLastDump(FILE* f, Dump& last) {
+  char line[512];
+  Dump cur;
+  bool inDump = false, found = false;
+  while (fgets(line, sizeof(line), f)) {
+    char* t = strstr(line, "[TRACE] ");
+    if (!t) continue;
+    t += 8;
+    t[strcspn(t, "\r\n")] = '\0';
+    unsigned ver, count, dropped, now;
+    if (sscanf(t, "begin %u %u %u %u", &ver, &count, &dropped, &now) == 4) {
+      cur = Dump();
+      cur.count = count; cur.dropped = dropped; cur.nowUs = now;
+      inDump = ver == 1;
+    } else if (!inDump) {
+      continue;
+    } else if (!strncmp(t, "name ", 5)) {
+      char* end;
+      int id = strtol(t + 5, &end, 10);
+      cur.names[id] = end + 1;
+    } else if (!strncmp(t, "data ", 5)) {
+      decodeBase64(t + 5, cur.bytes);
+    } else if (!strcmp(t, "end")) {
+      inDump = false;
+      if (cur.bytes.size() >= cur.count * 8) { last = cur; found = true; }
+    }
+  }
+  return found;
+}
+
+static uint32_t le32(const uint8_t* p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static std::string nameOf(const Dump& d, uint8_t id) {
+  auto it = d.names.find(id);
+  if (it != d.names.end()) return it->second;
+  char buf[16];
+  snprintf(buf, sizeof(buf), "phase%u", id);
+  return buf;
+}
+
+static std::string fmtUs(double us) {
+  char buf[32];
+  if (us < 1000) snprintf(buf, sizeof(buf), "%.0f us", us);
+  else if (us < 1e6) snprintf(buf, sizeof(buf), "%.2f ms", us / 1e3);
+  else snprintf(buf, sizeof(buf), "%.2f s", us / 1e6);
+  return buf;
+}
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+  size_t i = (size_t)(p * (sorted.size() - 1) + 0.5);
+  return sorted[i];
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  const char* chromePath = nullptr;
+  int timelineN = 40;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--timeline") && i + 1 < argc) timelineN = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--chrome") && i + 1 < argc) chromePath = argv[++i];
+    else path = argv[i];
+  }
+
+  FILE* f = path ? fopen(path, "r") : stdin;
+  if (!f) { perror(path); return 1; }
+  Dump d;
+  if (!readLastDump(f, d)) {
+    fprintf(stderr, "no complete [TRACE] dump found\n");
+    return 1;
+  }
+  if (path) fclose(f);
+
+  // Timestamps are 32-bit and wrap every ~71 min: place each record by its
+  // age relative to the dump time instead.
+  std::vector<Event> events;
+  for (uint32_t i = 0; i < d.count; i++) {
+    TraceRecord r = { le32(&d.bytes[i * 8]), le32(&d.bytes[i * 8 + 4]) };
+    uint32_t age = d.nowUs - r.startUs;
+    events.push_back({ -(int64_t)age, traceDurUs(r), traceId(r), 0 });
+  }
+  if (events.empty()) { printf("trace is empty\n"); return 0; }
+
+  // Parents start first and last longer; scopes close before their parent
+  // so the ring holds children first.
+  std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+    return a.startUs != b.startUs ? a.startUs < b.startUs : a.durUs > b.durUs;
+  });
+  std::vector<int64_t> openEnds;
+  for (auto& e : events) {
+    while (!openEnds.empty() && openEnds.back() <= e.startUs) openEnds.pop_back();
+    e.depth = (int)openEnds.size();
+    openEnds.push_back(e.startUs + e.durUs);
+  }
+
+  int64_t t0 = events.front().startUs;
+  int64_t t1 = 0;
+  for (const auto& e : events) t1 = std::max(t1, e.startUs + (int64_t)e.durUs);
+  double windowUs = (double)(t1 - t0);
+  printf("%u records, %u dropped before the dump, window %s\n\n",
+         d.count, d.dropped, fmtUs(windowUs).c_str());
+
+  // -------- Per-phase summary --------
+  std::map<uint8_t, std::vector<uint32_t>> byPhase;
+  for (const auto& e : events) byPhase[e.id].push_back(e.durUs);
+  std::vector<std::pair<uint64_t, uint8_t>> order;
+  for (auto& kv : byPhase) {
+    std::sort(kv.second.begin(), kv.second.end());
+    uint64_t total = 0;
+    for (uint32_t v : kv.second) total += v;
+    order.push_back({ total, kv.first });
+  }
+  std::sort(order.rbegin(), order.rend());
+
+  printf("%-14s %6s %11s %6s %11s %11s %11s %11s\n",
+         "phase", "count", "total", "share", "p50", "p90", "p99", "max");
+  for (const auto& o : order) {
+    const auto& v = byPhase[o.second];
+    printf("%-14s %6zu %11s %5.1f%% %11s %11s %11s %11s\n",
+           nameOf(d, o.second).c_str(), v.size(), fmtUs((double)o.first).c_str(),
+           windowUs > 0 ? 100.0 * o.first / windowUs : 0.0,
+           fmtUs(percentile(v, 0.5)).c_str(), fmtUs(percentile(v, 0.9)).c_str(),
+           fmtUs(percentile(v, 0.99)).c_str(), fmtUs(v.back()).c_str());
+  }
+
+  // -------- Histograms: power-of-two buckets --------
+  printf("\n");
+  for (const auto& o : order) {
+    const auto& v = byPhase[o.second];
+    int buckets[32] = {};
+    int peak = 0;
+    for (uint32_t us : v) {
+      int b = 0;
+      while (b < 31 && (1u << (b + 1)) <= us) b++;
+      peak = std::max(peak, ++buckets[b]);
+    }
+    printf("%s\n", nameOf(d, o.second).c_str());
+    for (int b = 0; b < 32; b++) {
+      if (!buckets[b]) continue;
+      int bar = (buckets[b] * 40 + peak - 1) / peak;
+      printf("  >= %-10s %6d %s\n", fmtUs(1u << b).c_str(), buckets[b], std::string(bar, '#').c_str());
+    }
+  }
+
+  // -------- Timeline --------
+  std::vector<const Event*> top;
+  for (const auto& e : events) if (e.depth == 0) top.push_back(&e);
+  size_t firstTop = top.size() > (size_t)timelineN ? top.size() - timelineN : 0;
+  printf("\nTimeline (last %zu top-level records, seconds before the dump)\n", top.size() - firstTop);
+  if (!top.empty()) {
+    const Event* from = top[firstTop];
+    for (const Event* e = from; e != events.data() + events.size(); e++) {
+      printf("%10.3f  %*s%-14s %s\n", e->startUs / 1e6, 2 * e->depth, "",
+             nameOf(d, e->id).c_str(), fmtUs(e->durUs).c_str());
+    }
+  }
+
+  // -------- Chrome / Perfetto export --------
+  if (chromePath) {
+    FILE* out = fopen(chromePath, "w");
+    if (!out) { perror(chromePath); return 1; }
+    fprintf(out, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < events.size(); i++) {
+      const Event& e = events[i];
+      fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"dur\":%u}",
+              i ? ",\n" : "", nameOf(d, e.id).c_str(), (long long)(e.startUs - t0), e.durUs);
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    printf("\nwrote %s\n", chromePath);
+  }
+  return 0;
+}
@@ -5,6 +5,7 @@ import { ObjectId } from 'mongodb';
 // Adjust these paths if your structure differs
 import clientPromise from '../../../lib/mongodb';
 import { auth } from '../auth/[...nextauth]/route';
+import { pairDevice } from '../../../lib/devices';
 
 
 
@@ -91,7 +92,8 @@ export async function GET(request) {
  *
  * - Inserts the plant profile (scoped to the user)
  * - Updates app_state to set current selection for the user
- * - If deviceId provided, mirrors the selection under that deviceId
+ * - If deviceId provided, pairs that device with the user (409 if it is paired with
+ *   another account) and mirrors the selection under its deviceId
  */
 export async function POST(request) {
   try {
@@ -110,6 +112,11 @@ export async function POST(request) {
 
     const client = await clientPromise;
     const db = client.db('planterbox');
+    const appState = db.collection('app_state');
+
+    if (body.deviceId && (await pairDevice(appState, body.deviceId, session.user.id)) !== session.user.id) {
+      return NextResponse.json({ error: 'Device is paired with another account' }, { status: 409 });
+    }
 
     const normalizedName = String(body.plant_name).toLowerCase().trim();
 
@@ -123,7 +130,6 @@ export async function POST(request) {
 
     const insertResult = await db.collection('plant_profiles').insertOne(plantData);
 
-    const appState = db.collection('app_state');
     const selectionValue = {
       plant: normalizedName,
       stage: body.stage,
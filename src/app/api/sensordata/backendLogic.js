@@ -105,9 +105,10 @@ export async function processSensorData(latestData, selectedPlant, selectedStage
   const hoursPerDay = Math.max(0, Math.min(24, Number(light_pwm_cycle) || 0));
   const light = computeDaylightPWM(hoursPerDay, /*startHour=*/6, new Date(), /*rampMinutes=*/60);
 
-  // Dosing needs
-  const needPhUp   = typeof ph  === 'number' && ph_min  != null && ph  < ph_min;
-  const needPhDown = typeof ph  === 'number' && ph_max  != null && ph  > ph_max;
+  // Dosing needs (the firmware sends pH 0 for a probe with no signal: never dose on it)
+  const phValid    = typeof ph  === 'number' && ph > 0;
+  const needPhUp   = phValid && ph_min  != null && ph  < ph_min;
+  const needPhDown = phValid && ph_max  != null && ph  > ph_max;
   const needPPM    = typeof ppm === 'number' && ppm_min != null && ppm < ppm_min;
 
   // Choose ONE action per tick (pH first, else PPM)
@@ -1,6 +1,8 @@
 import { NextResponse } from "next/server";
 import clientPromise from "../../../lib/mongodb";
 import { processSensorData } from "./backendLogic";
+import { readTelemetry } from "./telemetry";
+import { pairDevice } from "../../../lib/devices";
 import { auth } from "../auth/[...nextauth]/route";
 
 /** Get the current plant selection.
@@ -23,10 +25,97 @@ async function getSelection(appState, exactKey) {
   };
 }
 
-// Save one sensor sample
-async function saveSensor(db, sample) {
-  const sens = db.collection("sensordata");
-  await sens.insertOne(sample);
+/** The user a device uploads for (app_state { state_name: "deviceOwner", deviceId, userId }).
+ * Its owner pairs it by naming it: the dashboard's device field, sent with select_plant
+ * and POST /api/plants (pairDevice). Until then an unseen device is bound on its first
+ * upload to the most recent selection whose user has no device yet, so a one-box setup
+ * works unpaired; that guess is marked auto and gives way when anyone names the device.
+ * Returns null while there's nobody to bind to; the uploads aren't stored.
+ */
+async function deviceOwner(appState, deviceId) {
+  const bound = await appState.findOne({ state_name: "deviceOwner", deviceId });
+  if (bound) return bound.userId;
+
+  const [owners, devices] = await Promise.all([
+    appState.distinct("userId", { state_name: "deviceOwner" }),
+    appState.distinct("deviceId", { state_name: "deviceOwner" })
+  ]);
+  const free = await appState.findOne(
+    { state_name: "plantSelection", userId: { $nin: [...owners, ...devices, deviceId] } },
+    { sort: { "value.timestamp": -1 } }
+  );
+  return free ? pairDevice(appState, deviceId, free.userId, { auto: true }) : null;
+}
+
+/** The selection a device's uploads belong to, or null: one mirrored under its
+ * deviceId (POST /api/plants with a deviceId), else its owner's.
+ */
+async function deviceSelection(appState, deviceId) {
+  const mirrored = await appState.findOne({ state_name: "plantSelection", userId: deviceId });
+  if (mirrored?.value?.plant && mirrored?.value?.stage) return mirrored;
+  const ownerId = await deviceOwner(appState, deviceId);
+  if (!ownerId) return null;
+  const doc = await appState.findOne({ state_name: "plantSelection", userId: ownerId });
+  return doc?.value?.plant && doc?.value?.stage ? doc : null;
+}
+
+/** The first device bound to a user, for dashboard requests that don't name one */
+async function userDevice(appState, userId) {
+  if (!userId) return null;
+  const doc = await appState.findOne({ state_name: "deviceOwner", userId }, { sort: { boundAt: 1 } });
+  return doc?.deviceId ?? null;
+}
+
+// Indexes for the per-device lookups, created once per server process
+// (createIndex is a no-op when they already exist)
+let indexesReady = null;
+function ensureIndexes(db) {
+  indexesReady ??= Promise.all([
+    db.collection("sensordata").createIndex({ userId: 1, timestamp: -1 }),
+    // Frames from firmware without session / seq aren't deduplicated
+    db.collection("sensordata").createIndex(
+      { userId: 1, session: 1, seq: 1 },
+      { unique: true, partialFilterExpression: { seq: { $exists: true } } }
+    ),
+    db.collection("app_state").createIndex({ state_name: 1, userId: 1 }),
+    db.collection("app_state").createIndex({ state_name: 1, deviceId: 1 })
+  ]).catch((err) => {
+    indexesReady = null;
+    console.warn("sensordata index setup failed:", err.message);
+  });
+  return indexesReady;
+}
+
+// Save a batch of samples. Frames carry (session, seq), unique per device, so a
+// retried upload whose first attempt was stored (the reply got lost) is dropped by
+// the unique index instead of counted twice. Returns how many frames were new.
+async function saveSensor(db, frames) {
+  try {
+    const res = await db.collection("sensordata").insertMany(frames, { ordered: false });
+    return res.insertedCount;
+  } catch (err) {
+    const duplicatesOnly = [].concat(err?.writeErrors ?? []).every((e) => e.code === 11000);
+    if (err?.code !== 11000 || !duplicatesOnly) throw err;
+    return err.insertedCount ?? 0;
+  }
+}
+
+// Devices only upload when a reading leaves its deadband, plus a heartbeat
+// (UPLINK_HEARTBEAT_MS, 30 s), so a stored sample holds until the next one.
+// Holds are capped so a device that went offline doesn't stretch its last value.
+const MAX_HOLD_MS = 5 * 60 * 1000;
+const CHART_FIELDS = ["temperature", "humidity", "ph", "ppm"];
+
+// Time-weighted mean over step-held samples: sum(value * held) / sum(held),
+// counting only samples that actually carry the field.
+function heldAverage(field) {
+  return {
+    $cond: [
+      { $gt: [`$w_${field}`, 0] },
+      { $divide: [`$wv_${field}`, `$w_${field}`] },
+      null
+    ]
+  };
 }
 
 // Historical data helper (6h bins), since selection time if available
@@ -54,6 +143,14 @@ async function getHistoricalData(db, deviceId, ownerId, plant, stage, selectionS
     { $match: { userId: deviceId } },
     { $addFields: { tsDate: { $toDate: "$timestamp" } } },
     { $match: { tsDate: { $gte: startDate } } },
+    // Step hold: each sample is weighted by how long it stayed current
+    {
+      $setWindowFields: {
+        sortBy: { tsDate: 1 },
+        output: { nextTs: { $shift: { output: "$tsDate", by: 1, default: now } } }
+      }
+    },
+    { $addFields: { heldMs: { $min: [{ $subtract: ["$nextTs", "$tsDate"] }, MAX_HOLD_MS] } } },
     // 6-hour buckets
     {
       $group: {
@@ -63,12 +160,16 @@ async function getHistoricalData(db, deviceId, ownerId, plant, stage, selectionS
           block: { $floor: { $divide: [{ $hour: "$tsDate" }, 6] } }
         },
         timestamp: { $max: "$tsDate" },
-        temperature: { $avg: "$temperature" },
-        humidity: { $avg: "$humidity" },
-        ph: { $avg: "$ph" },
-        ppm: { $avg: "$ppm" }
+        ...Object.fromEntries(CHART_FIELDS.flatMap((f) => [
+          [`w_${f}`, { $sum: { $cond: [{ $isNumber: `$${f}` }, "$heldMs", 0] } }],
+          [`wv_${f}`, { $sum: { $cond: [{ $isNumber: `$${f}` }, { $multiply: [`$${f}`, "$heldMs"] }, 0] } }],
+          // Envelope: window summaries carry their own min/max, raw samples are their own
+          [`${f}_min`, { $min: { $ifNull: [`$min.${f}`, `$${f}`] } }],
+          [`${f}_max`, { $max: { $ifNull: [`$max.${f}`, `$${f}`] } }]
+        ]))
       }
     },
+    { $addFields: Object.fromEntries(CHART_FIELDS.map((f) => [f, heldAverage(f)])) },
     { $sort: { timestamp: 1 } },
     {
       $project: {
@@ -77,7 +178,11 @@ async function getHistoricalData(db, deviceId, ownerId, plant, stage, selectionS
         temperature: { $round: ["$temperature", 2] },
         humidity: { $round: ["$humidity", 2] },
         ph: { $round: ["$ph", 2] },
-        ppm: { $round: ["$ppm", 0] }
+        ppm: { $round: ["$ppm", 0] },
+        ...Object.fromEntries(CHART_FIELDS.flatMap((f) => [
+          [`${f}_min`, { $round: [`$${f}_min`, f === "ppm" ? 0 : 2] }],
+          [`${f}_max`, { $round: [`$${f}_max`, f === "ppm" ? 0 : 2] }]
+        ]))
       }
     }
   ]).toArray();
@@ -101,18 +206,84 @@ function safeDeviceDefaults() {
   };
 }
 
+// ---------- Upload pacing ----------
+// Device replies may carry next_upload_ms (the least gap before its next upload) and
+// batch_hint (windows per upload). Firmware clamps both; when a reply has neither it
+// paces itself (uplink_policy.h), and while it doses it uploads densely regardless.
+// The fleet-wide lever is app_state { state_name: "uploadPacing", value: { next_upload_ms,
+// batch_hint } }, read at most every PACING_CACHE_MS per server instance. On top of it,
+// an instance whose device uploads have been slow to handle asks for longer gaps.
+const PACING_CACHE_MS = 30 * 1000;
+const SLOW_UPLOAD_MS = 1000;        // smoothed handling time at which shedding starts
+const SHED_UPLOAD_MS = 30 * 1000;   // the gap asked for there (the device heartbeat), growing with it
+const IDLE_UPLOAD_MS = 60 * 1000;   // no selection: nothing is stored anyway
+const ERROR_UPLOAD_MS = 30 * 1000;  // the request failed on our side
+let pacingLever = { at: 0, value: null };
+let uploadMsAvg = 0;
+
+async function pacingOverride(appState) {
+  if (Date.now() - pacingLever.at > PACING_CACHE_MS) {
+    const doc = await appState.findOne({ state_name: "uploadPacing" }).catch(() => null);
+    pacingLever = { at: Date.now(), value: doc?.value ?? null };
+  }
+  return pacingLever.value;
+}
+
+/** Pacing fields for a device reply; {} leaves pacing to the device */
+async function uploadPacing(appState, startedAt, minGapMs = 0) {
+  uploadMsAvg += (Date.now() - startedAt - uploadMsAvg) / 8;
+  const lever = await pacingOverride(appState);
+  let next = Math.max(Number(lever?.next_upload_ms) || 0, minGapMs);
+  if (uploadMsAvg > SLOW_UPLOAD_MS) {
+    next = Math.max(next, Math.round((SHED_UPLOAD_MS * uploadMsAvg) / SLOW_UPLOAD_MS));
+  }
+  const batch = Number(lever?.batch_hint) || 0;
+  return {
+    ...(next > 0 && { next_upload_ms: next }),
+    ...(batch > 0 && { batch_hint: batch })
+  };
+}
+
+/** Push fresh commands to a device over the MQTT bridge (tools/mqtt_bridge.cpp).
+ * Only when PLANTERBOX_PUSH_URL is set; otherwise devices pick them up on their next upload.
+ * Fire-and-forget: a bridge that is down must not fail the dashboard request.
+ */
+function pushCommands(deviceId, commands) {
+  const base = process.env.PLANTERBOX_PUSH_URL;
+  if (!base) return;
+  fetch(`${base}/push/${encodeURIComponent(deviceId)}`, {
+    method: "POST",
+    headers: { "Content-Type": "application/json" },
+    body: JSON.stringify(commands),
+    signal: AbortSignal.timeout(3000)
+  }).catch((err) => console.warn("push to", deviceId, "failed:", err.message));
+}
+
 export async function POST(request) {
+  const startedAt = Date.now();
+  // Anything that isn't a dashboard action is a device upload
+  let dashboardRequest = false;
   try {
     const client = await clientPromise;
     const db = client.db("planterbox");
     const appState = db.collection("app_state");
     const archives = db.collection("archives");
+    await ensureIndexes(db);
 
     const session = await auth().catch(() => null);
     const authUserId = session?.user?.id;
 
-    const body = await request.json();
+    // JSON from the dashboard, JSON or CBOR (Content-Type: application/cbor) from devices.
+    // A body that doesn't decode is 400, not a server failure: resending it won't help,
+    // and the device drops it instead of backing off.
+    let body;
+    try {
+      body = await readTelemetry(request);
+    } catch (err) {
+      return NextResponse.json({ error: `Unreadable body: ${err.message}` }, { status: 400 });
+    }
     const action = body?.action;
+    dashboardRequest = action === "select_plant" || action === "abort_plant";
 
     // ---------- SELECT PLANT ----------
     if (action === "select_plant") {
@@ -121,11 +292,26 @@ export async function POST(request) {
       if (!selectedPlant || !selectedStage) {
         return NextResponse.json({ error: "Missing plant or stage" }, { status: 400 });
       }
-      await appState.updateOne(
-        { state_name: "plantSelection", userId: authUserId },
-        { $set: { value: { plant: selectedPlant, stage: selectedStage, timestamp: new Date().toISOString() } } },
-        { upsert: true }
-      );
+      // Naming a device pairs it with this user
+      if (body?.deviceId && (await pairDevice(appState, body.deviceId, authUserId)) !== authUserId) {
+        return NextResponse.json({ error: "Device is paired with another account" }, { status: 409 });
+      }
+      const value = { plant: selectedPlant, stage: selectedStage, timestamp: new Date().toISOString() };
+      await appState.updateOne({ state_name: "plantSelection", userId: authUserId }, { $set: { value } }, { upsert: true });
+      // A selection mirrored under the device (POST /api/plants) takes precedence; keep it current
+      if (body?.deviceId) {
+        await appState.updateOne({ state_name: "plantSelection", userId: body.deviceId }, { $set: { value } });
+      }
+
+      // Devices on the push channel get the new setpoints now, not on their next upload
+      if (process.env.PLANTERBOX_PUSH_URL) {
+        const pushDeviceId = body?.deviceId || (await userDevice(appState, authUserId)) || "default_device";
+        const latest = await db.collection("sensordata").findOne({ userId: pushDeviceId }, { sort: { timestamp: -1 } });
+        if (latest) {
+          const { deviceCommands } = await processSensorData(latest, selectedPlant, selectedStage, authUserId, pushDeviceId);
+          pushCommands(pushDeviceId, deviceCommands);
+        }
+      }
       return NextResponse.json({ ok: true }, { status: 200 });
     }
 
@@ -138,10 +324,10 @@ export async function POST(request) {
 
       // Current selection for this user (to archive)
       const selection = await appState.findOne({ state_name: "plantSelection", userId: authUserId });
+      const deviceIdToClear = body?.deviceId || (await userDevice(appState, authUserId)) || "default_device";
 
       if (selection?.value?.plant && selection?.value?.stage) {
-        // Compute simple stats from sensordata for the (default) device
-        const deviceIdToClear = body?.deviceId || "default_device";
+        // Compute simple stats from sensordata for the user's device
         const sens = db.collection("sensordata");
 
         // Stats computing helper
@@ -183,45 +369,64 @@ export async function POST(request) {
         });
       }
 
-      // Remove selection
-      await appState.deleteOne({ state_name: "plantSelection", userId: authUserId });
+      // Remove selection, and any mirrored under the device
+      await appState.deleteMany({ state_name: "plantSelection", userId: { $in: [authUserId, deviceIdToClear] } });
 
       // NEW: clear sensordata for the device so the next plant starts fresh
-      const deviceIdToClear = body?.deviceId || "default_device";
       await db.collection("sensordata").deleteMany({ userId: deviceIdToClear });
+      pushCommands(deviceIdToClear, safeDeviceDefaults());
 
       return NextResponse.json({ ok: true }, { status: 200 });
     }
 
     // ---------- DEVICE UPLOAD ----------
-    // Only save samples if there is a REAL active selection in app_state.
-    // (Prevents populating sensordata when no plant is selected.)
-    const deviceId = body?.deviceId || "default_device";
-    const activeSelectionDoc = await appState.findOne({ state_name: "plantSelection" });
-
-    if (!activeSelectionDoc?.value?.plant || !activeSelectionDoc?.value?.stage) {
-      // No active selection anywhere -> do not store; return safe defaults
-      return NextResponse.json(safeDeviceDefaults(), { status: 200 });
+    // A frame or a batch of frames; anything else is 400, like a body that didn't decode
+    const isFrame = (frame) => frame !== null && typeof frame === "object" && !Array.isArray(frame);
+    if (!(Array.isArray(body) ? body.every(isFrame) : isFrame(body))) {
+      return NextResponse.json({ error: "Expected a frame or an array of frames" }, { status: 400 });
     }
 
-    // If we do have a real selection, store the sample and compute commands.
-    const sensorData = {
-      ...body,
-      userId: deviceId, // namespace by device ID
-      timestamp: body.timestamp ? new Date(body.timestamp) : new Date() // store as Date
-    };
-    await saveSensor(db, sensorData);
-
-    // Determine selection (prefer deviceId match, fallback to latest any)
-    const { plant, stage, ownerId } = await getSelection(appState, deviceId);
-
-    const { deviceCommands } = await processSensorData(sensorData, plant, stage, ownerId, deviceId);
+    // Only save samples if there is a REAL active selection for this device.
+    // (Prevents populating sensordata when no plant is selected.)
+    // Frames name their device; bridged batches may only carry it in the query string,
+    // and firmware older than the deviceId field falls back to "default_device".
+    const first = Array.isArray(body) ? body[0] : body;
+    const deviceId = first?.deviceId || new URL(request.url).searchParams.get("deviceId") || "default_device";
+    const selectionDoc = await deviceSelection(appState, deviceId);
+
+    if (!selectionDoc) {
+      // Nothing selected for this device -> do not store; return safe defaults
+      const pacing = await uploadPacing(appState, startedAt, IDLE_UPLOAD_MS);
+      return NextResponse.json({ ...safeDeviceDefaults(), ...pacing }, { status: 200 });
+    }
 
-    return NextResponse.json(deviceCommands, { status: 200 });
+    // If we do have a real selection, store the sample(s) and compute commands.
+    // A batch is an array of frames, each carrying age_ms relative to the upload.
+    const now = Date.now();
+    const frames = (Array.isArray(body) ? body : [body]).map((frame) => {
+      const { age_ms, deviceId: _sender, ...sample } = frame || {};
+      return {
+        ...sample,
+        userId: deviceId, // namespace by device ID
+        timestamp: sample.timestamp ? new Date(sample.timestamp) : new Date(now - (Number(age_ms) || 0)) // store as Date
+      };
+    });
+    if (!frames.length) return NextResponse.json(safeDeviceDefaults(), { status: 200 });
+    await saveSensor(db, frames);
+    const sensorData = frames[frames.length - 1];
+
+    const { plant, stage } = selectionDoc.value;
+    const { deviceCommands } = await processSensorData(sensorData, plant, stage, selectionDoc.userId, deviceId);
+
+    const pacing = await uploadPacing(appState, startedAt);
+    return NextResponse.json({ ...deviceCommands, ...pacing }, { status: 200 });
   } catch (err) {
     console.error("POST /api/sensordata error:", err);
-    // Safe defaults
-    return NextResponse.json(safeDeviceDefaults(), { status: 200 });
+    // Safe defaults, and give the server some room. Devices take any status below 400
+    // as "stored" and drop the frames, so a failed upload must say so: 503 keeps them
+    // queued and backs off (uplink_policy.h).
+    const status = dashboardRequest ? 200 : 503;
+    return NextResponse.json({ ...safeDeviceDefaults(), next_upload_ms: ERROR_UPLOAD_MS }, { status });
   }
 }
 
@@ -241,7 +446,7 @@ export async function GET(request) {
     const growth = searchParams.get("growth") === "true";
     const queryPlant = searchParams.get("plant");
     const queryStage = searchParams.get("stage");
-    const deviceId = searchParams.get("deviceId") || "default_device";
+    const deviceId = searchParams.get("deviceId") || (await userDevice(appState, authUserId)) || "default_device";
 
     // 1) Historical charts branch
     if (growth) {
@@ -0,0 +1,61 @@
+import { decodeCbor } from '../../../lib/cbor';
+
+// Integer keys used by the firmware's CBOR frames (esp32-firmware/include/uplink.h,
+// enum FrameKey / MemKey). Keep both tables in sync with the device.
+const FRAME_KEYS = {
+  1: 'temperature',
+  2: 'humidity',
+  3: 'distance',
+  4: 'ppm',
+  5: 'ph',
+  6: 'water_sufficient',
+  7: 'mem',
+  8: 'age_ms',
+  9: 'window_ms',
+  10: 'min',
+  11: 'max',
+  12: 'count',
+  13: 'deviceId',
+  14: 'fw',
+  15: 'session',
+  16: 'seq'
+};
+
+// Window summaries: these hold maps keyed like the frame itself
+const WINDOW_STATS = ['min', 'max', 'count'];
+
+const MEM_KEYS = {
+  1: 'free',
+  2: 'largest',
+  3: 'min_free',
+  4: 'frag',
+  5: 'stack',
+  6: 'allocs'
+};
+
+function rename(map, keys) {
+  const out = {};
+  for (const [k, v] of Object.entries(map || {})) out[keys[k] ?? k] = v;
+  return out;
+}
+
+function toFrame(map) {
+  const frame = rename(map, FRAME_KEYS);
+  if (frame.mem && typeof frame.mem === 'object') frame.mem = rename(frame.mem, MEM_KEYS);
+  for (const stat of WINDOW_STATS) {
+    if (frame[stat] && typeof frame[stat] === 'object') frame[stat] = rename(frame[stat], FRAME_KEYS);
+  }
+  return frame;
+}
+
+/**
+ * Decode a device body by content type. Returns the same shape the JSON path
+ * produces: one frame object, or an array of frames for batched uploads.
+ */
+export async function readTelemetry(request) {
+  const type = request.headers.get('content-type') || '';
+  if (!type.startsWith('application/cbor')) return request.json();
+
+  const decoded = decodeCbor(new Uint8Array(await request.arrayBuffer()));
+  return Array.isArray(decoded) ? decoded.map(toFrame) : toFrame(decoded);
+}
@@ -38,6 +38,10 @@ export default function DashboardPage() {
   const [dropdownStage, setDropdownStage] = useState("seedling");
   const [newStage, setNewStage] = useState("seedling");
 
+  // The box this dashboard drives (planterbox-<MAC>, on its LAN status page)
+  const [deviceId, setDeviceId] = useState("");
+  const [deviceInput, setDeviceInput] = useState("");
+
   const [sensorData, setSensorData] = useState({});
   const [idealConditions, setIdealConditions] = useState({});
   const [sensorStatus, setSensorStatus] = useState({});
@@ -75,7 +79,12 @@ export default function DashboardPage() {
   useEffect(() => {
     const savedPlant = localStorage.getItem("selectedPlant");
     const savedStage = localStorage.getItem("selectedStage");
+    const savedDevice = localStorage.getItem("deviceId");
     if (savedPlant) setSelectedPlant(savedPlant);
+    if (savedDevice) {
+      setDeviceId(savedDevice);
+      setDeviceInput(savedDevice);
+    }
     if (savedStage) {
       setSelectedStage(savedStage);
       setDropdownStage(savedStage);
@@ -99,7 +108,9 @@ export default function DashboardPage() {
 
     const fetchData = async () => {
       try {
-        const res = await fetch("/api/sensordata");
+        const res = await fetch(
+          deviceId ? `/api/sensordata?deviceId=${encodeURIComponent(deviceId)}` : "/api/sensordata"
+        );
         const data = await res.json();
         setSensorData(data.sensorData);
         setSensorStatus(data.sensorStatus);
@@ -113,7 +124,7 @@ export default function DashboardPage() {
     fetchData();
     const intervalId = setInterval(fetchData, 3000);
     return () => clearInterval(intervalId);
-  }, [selectedPlant, selectedStage]);
+  }, [selectedPlant, selectedStage, deviceId]);
 
   // Debug: log modal open prop changes
   useEffect(() => {
@@ -121,7 +132,8 @@ export default function DashboardPage() {
   }, [showGraphModal]);
 
   // === keep your existing selection update ===
-  const handlePlantSelection = async (plantName, stageName) => {
+  // Naming the device pairs it with this account (409: someone else's box)
+  const handlePlantSelection = async (plantName, stageName, device = deviceId) => {
     try {
       const response = await fetch("/api/sensordata", {
         method: "POST",
@@ -130,8 +142,13 @@ export default function DashboardPage() {
           action: "select_plant",
           selectedPlant: plantName,
           selectedStage: stageName,
+          ...(device ? { deviceId: device } : {}),
         }),
       });
+      if (response.status === 409) {
+        message.error("That device is paired with another account");
+        return false;
+      }
       if (!response.ok) throw new Error("Failed to save plant selection");
       setSelectedPlant(plantName);
       setSelectedStage(stageName);
@@ -139,10 +156,24 @@ export default function DashboardPage() {
       localStorage.setItem("selectedPlant", plantName);
       localStorage.setItem("selectedStage", stageName);
       message.success(`${plantName} (${stageName}) selected successfully!`);
+      return true;
     } catch (error) {
       console.error("Failed to send plant selection/stage update:", error);
       message.error("Error selecting plant");
+      return false;
+    }
+  };
+
+  // Pairs right away when a plant is already selected; otherwise with the next selection
+  const handleDeviceSave = async () => {
+    const id = deviceInput.trim();
+    if (id && selectedPlant && selectedStage && !(await handlePlantSelection(selectedPlant, selectedStage, id))) {
+      return;
     }
+    setDeviceId(id);
+    if (id) localStorage.setItem("deviceId", id);
+    else localStorage.removeItem("deviceId");
+    if (!selectedPlant) message.success(id ? "Device saved; it pairs with your next plant" : "Device cleared");
   };
 
   const handleStageUpdate = () => {
@@ -155,7 +186,7 @@ export default function DashboardPage() {
       const response = await fetch("/api/sensordata", {
         method: "POST",
         headers: { "Content-Type": "application/json" },
-        body: JSON.stringify({ action: "abort_plant", snapshots }),
+        body: JSON.stringify({ action: "abort_plant", snapshots, ...(deviceId ? { deviceId } : {}) }),
       });
 
       if (!response.ok) throw new Error("Failed to abort plant");
@@ -214,6 +245,7 @@ export default function DashboardPage() {
               preset_type: "custom",
               stage,
               ideal_conditions: stageDefs[stage],
+              ...(deviceId ? { deviceId } : {}),
             }),
           });
           if (!res.ok) throw new Error(`Failed to create ${stage} profile`);
@@ -255,6 +287,7 @@ export default function DashboardPage() {
           preset_type: selectedPreset.plant_name,
           stage: initialStage,
           ideal_conditions: idealConditionsToUse,
+          ...(deviceId ? { deviceId } : {}),
         }),
       });
       if (!response.ok) throw new Error("Failed to create plant");
@@ -320,6 +353,16 @@ export default function DashboardPage() {
               <p className={styles.infoLabel}>Email</p>
               <p className={styles.infoValue}>{session.user?.email || "Not provided"}</p>
             </div>
+            <div className={styles.infoItem}>
+              <p className={styles.infoLabel}>Device ID</p>
+              <Input.Search
+                placeholder="planterbox-xxxxxxxxxxxx"
+                value={deviceInput}
+                onChange={(e) => setDeviceInput(e.target.value)}
+                onSearch={handleDeviceSave}
+                enterButton="Pair"
+              />
+            </div>
           </div>
         </Card>
 
@@ -346,6 +389,15 @@ export default function DashboardPage() {
                         "__v",
                         "timestamp",
                         "idealRanges",
+                        "mem",
+                        "fw",
+                        "session",
+                        "seq",
+                        // window summaries (uplink "window" mode, outage backlog)
+                        "window_ms",
+                        "min",
+                        "max",
+                        "count",
                       ].includes(key)
                   )
                   .map((key) => {
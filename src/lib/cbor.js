@@ -0,0 +1,81 @@
+// Minimal CBOR (RFC 8949) decoder for device uploads.
+// Covers what the firmware sends: definite-length maps and arrays, integers,
+// byte/text strings, tags (value passed through), simple values and
+// half/single/double floats. Map keys may be integers or strings.
+
+export function decodeCbor(bytes) {
+  const buf = bytes instanceof Uint8Array ? bytes : new Uint8Array(bytes);
+  const view = new DataView(buf.buffer, buf.byteOffset, buf.byteLength);
+  let pos = 0;
+
+  const need = (n) => {
+    if (pos + n > buf.length) throw new Error('CBOR: truncated input');
+  };
+
+  function argument(info) {
+    if (info < 24) return info;
+    switch (info) {
+      case 24: need(1); return view.getUint8(pos++);
+      case 25: need(2); pos += 2; return view.getUint16(pos - 2);
+      case 26: need(4); pos += 4; return view.getUint32(pos - 4);
+      case 27: {
+        need(8);
+        const v = view.getBigUint64(pos);
+        pos += 8;
+        return v <= BigInt(Number.MAX_SAFE_INTEGER) ? Number(v) : v;
+      }
+      default: throw new Error(`CBOR: unsupported additional info ${info}`);
+    }
+  }
+
+  function half(h) {
+    const exp = (h >> 10) & 0x1f;
+    const mant = h & 0x3ff;
+    const v = exp === 0 ? mant * 2 ** -24
+      : exp === 31 ? (mant ? NaN : Infinity)
+      : (mant + 1024) * 2 ** (exp - 25);
+    return h & 0x8000 ? -v : v;
+  }
+
+  function item() {
+    need(1);
+    const ib = view.getUint8(pos++);
+    const major = ib >> 5;
+    const info = ib & 0x1f;
+
+    if (major === 7) {
+      switch (info) {
+        case 20: return false;
+        case 21: return true;
+        case 22: return null;
+        case 23: return undefined;
+        case 25: need(2); pos += 2; return half(view.getUint16(pos - 2));
+        case 26: need(4); pos += 4; return view.getFloat32(pos - 4);
+        case 27: need(8); pos += 8; return view.getFloat64(pos - 8);
+        default: throw new Error(`CBOR: unsupported simple value ${info}`);
+      }
+    }
+
+    const arg = argument(info);
+    switch (major) {
+      case 0: return arg;
+      case 1: return typeof arg === 'bigint' ? -1n - arg : -1 - arg;
+      case 2: need(arg); pos += arg; return buf.slice(pos - arg, pos);
+      case 3: need(arg); pos += arg; return new TextDecoder().decode(buf.subarray(pos - arg, pos));
+      case 4: return Array.from({ length: arg }, item);
+      case 5: {
+        const out = {};
+        for (let i = 0; i < arg; i++) {
+          const k = item();
+          out[k] = item();
+        }
+        return out;
+      }
+      case 6: return item();
+    }
+  }
+
+  const value = item();
+  if (pos !== buf.length) throw new Error('CBOR: trailing bytes');
+  return value;
+}
@@ -0,0 +1,25 @@
+// Device pairing: app_state { state_name: 'deviceOwner', deviceId, userId, boundAt, auto? }.
+// Uploads carry no credentials, so the binding that counts is a signed-in user naming
+// the device's ID (the one on its LAN status page and in its mDNS record). Until a
+// user does, an unseen device may be bound automatically (auto: true); naming it
+// takes such a binding over, while an explicit one stands.
+
+/** Bind deviceId to userId unless another user already holds it explicitly.
+ * Returns the device's owner afterwards: userId on success, someone else's otherwise.
+ */
+export async function pairDevice(appState, deviceId, userId, { auto = false } = {}) {
+  const boundAt = new Date().toISOString();
+  if (!auto) {
+    await appState.updateOne(
+      { state_name: 'deviceOwner', deviceId, auto: true },
+      { $set: { userId, boundAt }, $unset: { auto: '' } }
+    );
+  }
+  // Concurrent claims: whichever binding landed first stands
+  await appState.updateOne(
+    { state_name: 'deviceOwner', deviceId },
+    { $setOnInsert: { userId, boundAt, ...(auto && { auto: true }) } },
+    { upsert: true }
+  );
+  return (await appState.findOne({ state_name: 'deviceOwner', deviceId }))?.userId ?? null;
+}